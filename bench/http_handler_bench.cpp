@@ -0,0 +1,124 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * HttpHandler::Handle 按方法分派的基准测试：对比按 HttpMethod 查表与逐个比较
+ * 方法名称字符串，输出每秒分派的请求数。应使用 -DCMAKE_BUILD_TYPE=Release
+ * 构建。
+ */
+
+#include <chrono>
+#include <http_handler.hpp>
+#include <http_method.hpp>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace ayaka;
+
+namespace {
+
+constexpr int kIterations = 2000000;
+
+/**
+ * 所有方法都只计数，避免分派之外的开销。
+ */
+class CountHandler : public HttpHandler {
+ public:
+  void DoGet(const std::shared_ptr<Request>&,
+             std::shared_ptr<Response>&) override {
+    ++count_;
+  }
+  void DoPost(const std::shared_ptr<Request>&,
+              std::shared_ptr<Response>&) override {
+    ++count_;
+  }
+  void DoHead(const std::shared_ptr<Request>&,
+              std::shared_ptr<Response>&) override {
+    ++count_;
+  }
+  void DoPatch(const std::shared_ptr<Request>&,
+               std::shared_ptr<Response>&) override {
+    ++count_;
+  }
+
+  [[nodiscard]] auto count() const { return count_; }
+
+ private:
+  int count_ = 0;
+};
+
+/**
+ * 以前的分派方式：依次与各个方法的名称比较。
+ */
+void DispatchByName(CountHandler& handler, const std::shared_ptr<Request>& req,
+                    std::shared_ptr<Response>& resp) {
+  auto method = req->method();
+  if (method == http_method::kGet) {
+    handler.DoGet(req, resp);
+  } else if (method == http_method::kPost) {
+    handler.DoPost(req, resp);
+  } else if (method == http_method::kPut) {
+    handler.DoPut(req, resp);
+  } else if (method == http_method::kDelete) {
+    handler.DoDelete(req, resp);
+  } else if (method == http_method::kHead) {
+    handler.DoHead(req, resp);
+  } else if (method == http_method::kOptions) {
+    handler.DoOptions(req, resp);
+  } else if (method == http_method::kConnect) {
+    handler.DoConnect(req, resp);
+  } else if (method == http_method::kTrace) {
+    handler.DoTrace(req, resp);
+  } else if (method == http_method::kPatch) {
+    handler.DoPatch(req, resp);
+  }
+}
+
+template <typename Dispatch>
+void Bench(const char* name, Dispatch dispatch) {
+  // 常见的方法分布：大部分是 GET，也有排在比较链末尾的 PATCH。
+  std::vector<std::shared_ptr<Request>> reqs;
+  for (const auto* method : {"GET", "GET", "POST", "GET", "HEAD", "PATCH"}) {
+    auto req = std::make_shared<Request>();
+    req->set_method(method);
+    reqs.push_back(std::move(req));
+  }
+  CountHandler handler;
+  auto resp = std::make_shared<Response>();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; ++i) {
+    dispatch(handler, reqs[i % reqs.size()], resp);
+  }
+  auto seconds = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  std::cout << name << ": " << handler.count() / seconds / 1e6 << " M/s\n";
+}
+
+}  // namespace
+
+int main() {
+  Bench("Handle", [](CountHandler& handler,
+                     const std::shared_ptr<Request>& req,
+                     std::shared_ptr<Response>& resp) {
+    handler.Handle(req, resp);
+  });
+  Bench("DispatchByName", DispatchByName);
+  return 0;
+}
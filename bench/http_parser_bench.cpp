@@ -0,0 +1,118 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * RequestParser 的基准测试：反复解析一个带有 15 个头部的典型浏览器请求，
+ * 输出每秒解析的请求数和字节数。应使用 -DCMAKE_BUILD_TYPE=Release 构建。
+ */
+
+#include <buf_pool.hpp>
+#include <chrono>
+#include <cstring>
+#include <http_parser.hpp>
+#include <iostream>
+#include <scan.hpp>
+#include <string>
+
+using namespace ayaka;
+
+namespace {
+
+const std::string kRequest =
+    "GET /wp-content/uploads/2010/03/hello-kitty-darth-vader-pink.jpg "
+    "HTTP/1.1\r\n"
+    "Host: www.kittyhell.com\r\n"
+    "User-Agent: Mozilla/5.0 (Macintosh; U; Intel Mac OS X 10.6; ja-JP-mac; "
+    "rv:1.9.2.3) Gecko/20100401 Firefox/3.6.3 Pathtraq/0.9\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,"
+    "*/*;q=0.8\r\n"
+    "Accept-Language: ja,en-us;q=0.7,en;q=0.3\r\n"
+    "Accept-Encoding: gzip,deflate\r\n"
+    "Accept-Charset: Shift_JIS,utf-8;q=0.7,*;q=0.7\r\n"
+    "Keep-Alive: 115\r\n"
+    "Connection: keep-alive\r\n"
+    "Cookie: wp_ozh_wsa_visits=2; wp_ozh_wsa_visit_lasttime=xxxxxxxxxx; "
+    "__utma=xxxxxxxxx.xxxxxxxxxx.xxxxxxxxxx.xxxxxxxxxx.xxxxxxxxxx.x; "
+    "__utmz=xxxxxxxxx.xxxxxxxxxx.x.x.utmccn=(referral)|utmcsr=reader.livedoor."
+    "com|utmcct=/reader/|utmcmd=referral\r\n"
+    "Referer: http://www.kittyhell.com/\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "Sec-Fetch-Dest: image\r\n"
+    "Sec-Fetch-Mode: no-cors\r\n"
+    "DNT: 1\r\n"
+    "\r\n";
+
+constexpr int kIterations = 200000;
+
+void Report(const char *name, std::chrono::steady_clock::duration elapsed,
+            size_t nbytes, int nitems) {
+  auto seconds = std::chrono::duration<double>(elapsed).count();
+  std::cout << name << ": " << nbytes / seconds / 1e9 << " GB/s, "
+            << nitems / seconds / 1e6 << " M/s\n";
+}
+
+void BenchParser() {
+  BufPool pool(BufPool::kDefaultBufSize, 1);
+  auto *buf = pool.Acquire();
+  memcpy(buf, kRequest.data(), kRequest.size());
+  BufRef buf_ref(pool, buf);
+
+  RequestParser parser;
+  size_t nparsed = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; ++i) {
+    nparsed += parser.Exec(buf, kRequest.size(), buf_ref);
+    parser.Reset();
+  }
+  Report("RequestParser", std::chrono::steady_clock::now() - start, nparsed,
+         kIterations);
+  pool.Release(buf);
+}
+
+template <typename Scan>
+void BenchScan(const char *name, Scan scan) {
+  size_t nscanned = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; ++i) {
+    // 逐行扫描，与解析头部时的访问模式相同。
+    size_t pos = 0;
+    while (pos < kRequest.size()) {
+      pos += scan(kRequest.data() + pos, kRequest.size() - pos, '\r', '\r');
+      pos += 2;
+    }
+    nscanned += kRequest.size();
+  }
+  Report(name, std::chrono::steady_clock::now() - start, nscanned,
+         kIterations);
+}
+
+}  // namespace
+
+int main() {
+  std::cout << "request: " << kRequest.size() << " bytes, scan: "
+            << ScanImplName() << "\n";
+  BenchParser();
+  BenchScan("ScanScalar", detail::ScanScalar);
+#if defined(__x86_64__)
+  BenchScan("ScanSse2", detail::ScanSse2);
+  if (detail::CpuHasAvx2()) {
+    BenchScan("ScanAvx2", detail::ScanAvx2);
+  }
+#endif
+  return 0;
+}
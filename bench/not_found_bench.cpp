@@ -0,0 +1,87 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * 404 响应的基准测试：对比 Router::Route 返回 nullptr 后直接生成响应与抛出、
+ * 捕获 Http404Except 再生成响应，输出每秒生成的响应数。日志级别被设置为 warn，
+ * 两种方式都不输出日志。应使用 -DCMAKE_BUILD_TYPE=Release 构建。
+ */
+
+#include <chrono>
+#include <http_except.hpp>
+#include <http_handler.hpp>
+#include <iostream>
+#include <location.hpp>
+#include <memory>
+#include <response.hpp>
+#include <router.hpp>
+#include <string>
+
+using namespace ayaka;
+
+namespace {
+
+constexpr int kIterations = 1000000;
+
+template <typename NotFound>
+void Bench(const char* name, const Router& router, NotFound not_found) {
+  const std::string path = "/missing/index.html";
+  auto resp = Response::Default();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; ++i) {
+    not_found(router, path, resp);
+  }
+  auto seconds = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  std::cout << name << ": " << kIterations / seconds / 1e6 << " M/s ("
+            << resp->status().code() << ")\n";
+}
+
+}  // namespace
+
+int main() {
+  spdlog::set_level(spdlog::level::warn);
+
+  Router router;
+  auto handler = std::make_shared<Http404Handler>();
+  router.AddLocation(std::make_shared<PathLocation>("/index.html", handler));
+  router.AddLocation(std::make_shared<DirLocation>("/static", handler));
+
+  Bench("SetUpError", router,
+        [](const Router& router, const std::string& path,
+           std::shared_ptr<Response>& resp) {
+          if (!router.Route(path)) {
+            resp->Reset();
+            SetUpError(*resp, HttpError::kNotFound);
+          }
+        });
+  // 以前的方式：Route 抛出 Http404Except，由 Downstream 捕获后生成响应。
+  Bench("Http404Except", router,
+        [](const Router& router, const std::string& path,
+           std::shared_ptr<Response>& resp) {
+          try {
+            if (!router.Route(path)) {
+              throw Http404Except("GET", path);
+            }
+          } catch (const HttpExcept& except) {
+            resp = Response::Default();
+            except.SetUp(resp);
+          }
+        });
+  return 0;
+}
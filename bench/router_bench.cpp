@@ -0,0 +1,104 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Router::Route 的基准测试：对比前缀树与以前依次调用 Location::Match 的线性
+ * 查找，输出每秒路由的请求数。应使用 -DCMAKE_BUILD_TYPE=Release 构建。
+ */
+
+#include <chrono>
+#include <http_handler.hpp>
+#include <iostream>
+#include <location.hpp>
+#include <memory>
+#include <router.hpp>
+#include <string>
+#include <vector>
+
+using namespace ayaka;
+
+namespace {
+
+constexpr int kIterations = 2000000;
+constexpr int kPaths = 300;
+constexpr int kDirs = 100;
+
+/**
+ * 以前的路由方式：按照添加顺序依次匹配。
+ */
+std::shared_ptr<HttpHandler> RouteLinear(
+    const std::vector<std::shared_ptr<Location>>& locations,
+    const std::string& path) {
+  for (const auto& location : locations) {
+    if (location->Match(path)) {
+      return location->handler();
+    }
+  }
+  return nullptr;
+}
+
+template <typename Route>
+void Bench(const char* name, const std::vector<std::string>& paths,
+           Route route) {
+  int found = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; ++i) {
+    if (route(paths[i % paths.size()])) {
+      ++found;
+    }
+  }
+  auto seconds = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  std::cout << name << ": " << kIterations / seconds / 1e6 << " M/s ("
+            << found << " found)\n";
+}
+
+}  // namespace
+
+int main() {
+  // 数百个 Location：PathLocation 在前，DirLocation 在后，保证两种方式的
+  // 结果相同。
+  std::vector<std::shared_ptr<Location>> locations;
+  auto handler = std::make_shared<Http404Handler>();
+  for (int i = 0; i < kPaths; ++i) {
+    locations.push_back(std::make_shared<PathLocation>(
+        "/api/v1/resource" + std::to_string(i), handler));
+  }
+  for (int i = 0; i < kDirs; ++i) {
+    locations.push_back(std::make_shared<DirLocation>(
+        "/static" + std::to_string(i) + "/", handler));
+  }
+  Router router;
+  for (const auto& location : locations) {
+    router.AddLocation(location);
+  }
+
+  std::vector<std::string> paths;
+  for (int i = 0; i < kDirs; ++i) {
+    paths.push_back("/api/v1/resource" + std::to_string(i * 3));
+    paths.push_back("/static" + std::to_string(i) + "/js/app.js");
+    paths.push_back("/missing/" + std::to_string(i));
+  }
+
+  Bench("Router", paths,
+        [&router](const std::string& path) { return router.Route(path); });
+  Bench("RouteLinear", paths, [&locations](const std::string& path) {
+    return RouteLinear(locations, path);
+  });
+  return 0;
+}
@@ -0,0 +1,132 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SendRespPack 的基准测试：把一个带有 8 个头部的典型响应通过 writev 写入
+ * socketpair 并读出，对比头部合并为一个 uv_buf_t 与逐个字段一个 uv_buf_t
+ * 的系统调用开销。应使用 -DCMAKE_BUILD_TYPE=Release 构建。
+ */
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <buf_pool.hpp>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <send_pack.hpp>
+#include <string>
+#include <vector>
+
+using namespace ayaka;
+
+namespace {
+
+constexpr int kIterations = 200000;
+
+std::shared_ptr<Response> MakeResponse() {
+  auto resp = Response::Default();
+  resp->headers()[Header::kConnection] = "keep-alive";
+  resp->headers()[Header::kContentType] = "text/html";
+  resp->headers()[Header::kLastModified] = "Mon, 17 Oct 2022 08:00:00 GMT";
+  resp->headers()[Header::kETag] = "\"5f3a1c-2d4\"";
+  resp->headers()[Header::kCacheControl] = "max-age=3600";
+  resp->headers()[Header::kAcceptRanges] = "bytes";
+  std::string body(724, 'x');
+  resp->set_body(std::make_shared<std::vector<char>>(body.begin(), body.end()));
+  resp->headers()[Header::kContentLength] = std::to_string(body.size());
+  return resp;
+}
+
+void AddBuf(std::vector<uv_buf_t>& bufs, const std::string& str) {
+  bufs.push_back(uv_buf_init(const_cast<char*>(str.data()), str.size()));
+}
+
+/**
+ * 以前的做法：起始行和每个头部的每个部分都是一个 uv_buf_t。
+ */
+std::vector<uv_buf_t> ScatteredBufs(const Response& resp,
+                                    std::vector<std::string>& strs) {
+  strs = {resp.version(), " ", std::string(resp.status().code()), " ",
+          std::string(resp.status().msg()), "\r\n"};
+  resp.headers().ForEach([&strs](std::string_view name,
+                                 const std::string& value) {
+    strs.emplace_back(name);
+    strs.emplace_back(": ");
+    strs.emplace_back(value);
+    strs.emplace_back("\r\n");
+  });
+  strs.emplace_back("\r\n");
+  std::vector<uv_buf_t> bufs;
+  for (const auto& str : strs) {
+    AddBuf(bufs, str);
+  }
+  bufs.push_back(uv_buf_init(resp.body()->data(), resp.body()->size()));
+  return bufs;
+}
+
+template <typename MakeBufs>
+void Bench(const char* name, MakeBufs make_bufs) {
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+    std::cerr << "socketpair failed\n";
+    return;
+  }
+  std::vector<char> buf(64 * 1024);
+  size_t nbytes = 0;
+  size_t niovs = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; ++i) {
+    make_bufs([&](const std::vector<uv_buf_t>& bufs) {
+      niovs = bufs.size();
+      // uv_buf_t 与 iovec 的内存布局相同，libuv 直接把它传给 writev。
+      auto nwrite = writev(fds[0], reinterpret_cast<const iovec*>(bufs.data()),
+                           static_cast<int>(bufs.size()));
+      if (nwrite > 0) {
+        nbytes += nwrite;
+        for (auto nread = 0L; nread < nwrite;) {
+          nread += read(fds[1], buf.data(), buf.size());
+        }
+      }
+    });
+  }
+  auto seconds = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  std::cout << name << ": " << niovs << " iovecs, "
+            << kIterations / seconds / 1e6 << " M writev/s, "
+            << nbytes / seconds / 1e9 << " GB/s\n";
+  close(fds[0]);
+  close(fds[1]);
+}
+
+}  // namespace
+
+int main() {
+  auto resp = MakeResponse();
+  BufPool pool;
+  Bench("SendRespPack", [&](auto write) {
+    SendRespPack pack(resp, &pool);
+    write(pack.bufs());
+  });
+  Bench("Scattered", [&](auto write) {
+    std::vector<std::string> strs;
+    write(ScatteredBufs(*resp, strs));
+  });
+  return 0;
+}
@@ -0,0 +1,98 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "awaitable.hpp"
+
+#include <utility>
+
+namespace ayaka {
+
+void SleepAwaiter::await_suspend(std::coroutine_handle<> handle) {
+  // 协程可能在事件循环迭代的中途挂起，此时缓存的时间已经过时。
+  uv_update_time(loop_->uv_loop());
+  auto *timer = new uv_timer_t;
+  uv_timer_init(loop_->uv_loop(), timer);
+  timer->data = handle.address();
+  uv_timer_start(timer, UvOnTimer, timeout_.count(), 0);
+}
+
+void SleepAwaiter::UvOnTimer(uv_timer_t *timer) {
+  auto handle = std::coroutine_handle<>::from_address(timer->data);
+  uv_close(reinterpret_cast<uv_handle_t *>(timer), [](uv_handle_t *handle) {
+    delete reinterpret_cast<uv_timer_t *>(handle);
+  });
+  handle.resume();
+}
+
+TcpStream::TcpStream(std::shared_ptr<Tcp> tcp)
+    : state_(std::make_shared<State>()) {
+  state_->tcp = std::move(tcp);
+  state_->closed = state_->tcp->closed();
+
+  // 回调中只持有 weak_ptr，避免 Tcp 和 State 互相引用。
+  std::weak_ptr<State> weak = state_;
+  state_->tcp->set_on_recv([weak](const char *buf, size_t len) {
+    auto state = weak.lock();
+    if (!state) {
+      return;
+    }
+    state->buffer.append(buf, len);
+    if (auto reader = std::exchange(state->reader, {})) {
+      reader.resume();
+    }
+  });
+  state_->tcp->set_on_close([weak]() {
+    auto state = weak.lock();
+    if (!state) {
+      return;
+    }
+    state->closed = true;
+    state->write_ok = false;
+    if (auto reader = std::exchange(state->reader, {})) {
+      reader.resume();
+    }
+    if (auto writer = std::exchange(state->writer, {})) {
+      writer.resume();
+    }
+  });
+}
+
+TcpStream::ReadAwaiter TcpStream::Read() const { return ReadAwaiter(state_); }
+
+TcpStream::WriteAwaiter TcpStream::Write(
+    std::shared_ptr<SendPack> send_pack) const {
+  return {state_, std::move(send_pack)};
+}
+
+void TcpStream::WriteAwaiter::await_suspend(std::coroutine_handle<> handle) {
+  state_->writer = handle;
+  state_->write_ok = false;
+  std::weak_ptr<State> weak = state_;
+  // 发送失败时 Tcp 会关闭连接，由 on_close 恢复协程。
+  state_->tcp->Send(send_pack_, [weak]() {
+    auto state = weak.lock();
+    if (!state) {
+      return;
+    }
+    state->write_ok = true;
+    if (auto writer = std::exchange(state->writer, {})) {
+      writer.resume();
+    }
+  });
+}
+
+}  // namespace ayaka
@@ -0,0 +1,241 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef AYAKA_SRC_AWAITABLE_HPP_
+#define AYAKA_SRC_AWAITABLE_HPP_
+
+#include <uv.h>
+
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "file.hpp"
+#include "loop.hpp"
+#include "request.hpp"
+#include "send_pack.hpp"
+#include "tcp.hpp"
+
+namespace ayaka {
+
+/**
+ * 将基于回调的异步操作包装为可以 co_await 的对象。start 被调用时开始异步操作，
+ * 操作完成时调用传入的 resume 回调，co_await 的结果是传给 resume 的值。
+ *
+ * resume 可以在 start 中被同步调用，此时协程不会挂起。因为实现原因，resume
+ * 只能在调用 co_await 的线程中被调用。
+ */
+template <typename T>
+class CallbackAwaiter {
+ public:
+  using ResumeCb = std::function<void(T)>;
+  using StartCb = std::function<void(ResumeCb)>;
+
+  explicit CallbackAwaiter(StartCb start) : start_(std::move(start)) {}
+
+  [[nodiscard]] bool await_ready() const noexcept { return false; }
+
+  bool await_suspend(std::coroutine_handle<> handle) {
+    start_([this, handle](T value) {
+      value_ = std::move(value);
+      if (suspended_) {
+        handle.resume();
+      }
+    });
+    suspended_ = !value_.has_value();
+    return suspended_;
+  }
+
+  T await_resume() { return std::move(*value_); }
+
+ private:
+  StartCb start_;
+  std::optional<T> value_;
+  bool suspended_ = false;
+};
+
+/**
+ * co_await Sleep(loop, timeout) 在 timeout 之后继续执行。
+ */
+class SleepAwaiter {
+ public:
+  SleepAwaiter(std::shared_ptr<Loop> loop, std::chrono::milliseconds timeout)
+      : loop_(std::move(loop)), timeout_(timeout) {}
+
+  [[nodiscard]] bool await_ready() const noexcept { return false; }
+  void await_suspend(std::coroutine_handle<> handle);
+  void await_resume() const noexcept {}
+
+ private:
+  static void UvOnTimer(uv_timer_t *timer);
+
+  std::shared_ptr<Loop> loop_;
+  std::chrono::milliseconds timeout_;
+};
+
+[[nodiscard]] inline SleepAwaiter Sleep(std::shared_ptr<Loop> loop,
+                                        std::chrono::milliseconds timeout) {
+  return {std::move(loop), timeout};
+}
+
+/**
+ * co_await SwitchTo(loop) 之后，协程在 loop 的线程中继续执行。可以用于将
+ * 工作交给另一个工作线程，或者从其他线程回到事件循环的线程。
+ */
+class SwitchAwaiter {
+ public:
+  explicit SwitchAwaiter(std::shared_ptr<Loop> loop) : loop_(std::move(loop)) {}
+
+  [[nodiscard]] bool await_ready() const noexcept { return false; }
+  void await_suspend(std::coroutine_handle<> handle) {
+    loop_->Post([handle]() { handle.resume(); });
+  }
+  void await_resume() const noexcept {}
+
+ private:
+  std::shared_ptr<Loop> loop_;
+};
+
+[[nodiscard]] inline SwitchAwaiter SwitchTo(std::shared_ptr<Loop> loop) {
+  return SwitchAwaiter(std::move(loop));
+}
+
+/**
+ * co_await OpenFile(loop, path) 在 libuv 的线程池中打开文件，失败时返回
+ * nullptr。
+ */
+[[nodiscard]] inline CallbackAwaiter<std::shared_ptr<File>> OpenFile(
+    const std::shared_ptr<Loop> &loop, std::string path) {
+  return CallbackAwaiter<std::shared_ptr<File>>(
+      [uv_loop = loop->uv_loop(), path = std::move(path)](auto resume) {
+        File::OpenAsync(uv_loop, path, std::move(resume));
+      });
+}
+
+/**
+ * co_await ReadFile(loop, file) 在 libuv 的线程池中读取整个文件，失败时返回
+ * nullptr。
+ */
+[[nodiscard]] inline CallbackAwaiter<std::shared_ptr<std::vector<char>>>
+ReadFile(const std::shared_ptr<Loop> &loop, std::shared_ptr<File> file) {
+  return CallbackAwaiter<std::shared_ptr<std::vector<char>>>(
+      [uv_loop = loop->uv_loop(), file = std::move(file)](auto resume) {
+        File::ReadAllAsync(uv_loop, file, std::move(resume));
+      });
+}
+
+/**
+ * co_await ReadBody(req) 等待完整的请求体，请求体保存在 req->body().content()
+ * 中。成功时返回 nullptr，否则返回接收失败的原因。
+ */
+[[nodiscard]] inline CallbackAwaiter<std::exception_ptr> ReadBody(
+    std::shared_ptr<Request> req) {
+  return CallbackAwaiter<std::exception_ptr>(
+      [req = std::move(req)](auto resume) {
+        req->body().ReadAll(std::move(resume));
+      });
+}
+
+/**
+ * 以协程的方式读写 Tcp 连接。TcpStream 接管 tcp 的 on_recv 和 on_close，
+ * 在没有协程等待时收到的数据会被缓存。
+ *
+ * 同一时间最多只能有一个协程等待 Read，一个协程等待 Write。
+ */
+class TcpStream {
+ public:
+  explicit TcpStream(std::shared_ptr<Tcp> tcp);
+
+  /**
+   * TcpStream 只能移动，不能拷贝。
+   */
+  TcpStream(const TcpStream &) = delete;
+  TcpStream &operator=(const TcpStream &) = delete;
+  TcpStream(TcpStream &&) noexcept = default;
+  TcpStream &operator=(TcpStream &&) noexcept = default;
+  ~TcpStream() = default;
+
+  [[nodiscard]] auto &tcp() const { return state_->tcp; }
+  [[nodiscard]] bool closed() const { return state_->closed; }
+
+  class ReadAwaiter;
+  class WriteAwaiter;
+
+  /**
+   * co_await 返回收到的数据，连接关闭时返回空字符串。
+   */
+  [[nodiscard]] ReadAwaiter Read() const;
+
+  /**
+   * co_await 返回是否发送成功。
+   */
+  [[nodiscard]] WriteAwaiter Write(std::shared_ptr<SendPack> send_pack) const;
+
+ private:
+  struct State {
+    std::shared_ptr<Tcp> tcp;
+    std::string buffer;
+    bool closed = false;
+    std::coroutine_handle<> reader;
+    std::coroutine_handle<> writer;
+    bool write_ok = false;
+  };
+
+  std::shared_ptr<State> state_;
+};
+
+class TcpStream::ReadAwaiter {
+ public:
+  explicit ReadAwaiter(std::shared_ptr<State> state)
+      : state_(std::move(state)) {}
+
+  [[nodiscard]] bool await_ready() const noexcept {
+    return !state_->buffer.empty() || state_->closed;
+  }
+  void await_suspend(std::coroutine_handle<> handle) {
+    state_->reader = handle;
+  }
+  std::string await_resume() { return std::exchange(state_->buffer, {}); }
+
+ private:
+  std::shared_ptr<State> state_;
+};
+
+class TcpStream::WriteAwaiter {
+ public:
+  WriteAwaiter(std::shared_ptr<State> state,
+               std::shared_ptr<SendPack> send_pack)
+      : state_(std::move(state)), send_pack_(std::move(send_pack)) {}
+
+  [[nodiscard]] bool await_ready() const noexcept { return state_->closed; }
+  void await_suspend(std::coroutine_handle<> handle);
+  [[nodiscard]] bool await_resume() const { return state_->write_ok; }
+
+ private:
+  std::shared_ptr<State> state_;
+  std::shared_ptr<SendPack> send_pack_;
+};
+
+}  // namespace ayaka
+
+#endif  // AYAKA_SRC_AWAITABLE_HPP_
@@ -0,0 +1,110 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "buf_pool.hpp"
+
+#include <utility>
+
+#include "error.hpp"
+
+namespace ayaka {
+
+BufPool::BufPool(BufPool &&other) noexcept
+    : buf_size_(other.buf_size_),
+      max_free_(other.max_free_),
+      nused_(other.nused_),
+      nallocs_(other.nallocs_),
+      free_(std::move(other.free_)) {
+  other.nused_ = 0;
+  other.free_.clear();
+}
+
+BufPool &BufPool::operator=(BufPool &&other) noexcept {
+  if (this != &other) {
+    Clear();
+    buf_size_ = other.buf_size_;
+    max_free_ = other.max_free_;
+    nused_ = other.nused_;
+    nallocs_ = other.nallocs_;
+    free_ = std::move(other.free_);
+    other.nused_ = 0;
+    other.free_.clear();
+  }
+  return *this;
+}
+
+BufPool::~BufPool() { Clear(); }
+
+char *BufPool::Acquire() {
+  ++nused_;
+  char *buf = nullptr;
+  if (!free_.empty()) {
+    buf = free_.back();
+    free_.pop_back();
+  } else {
+    ++nallocs_;
+    buf = new char[kHeaderSize + buf_size_] + kHeaderSize;
+  }
+  RefCount(buf) = 1;
+  return buf;
+}
+
+void BufPool::Retain(const char *buf) {
+  AYAKA_TERM_IF(RefCount(buf) == 0, "retain a buffer that is not acquired");
+  ++RefCount(buf);
+}
+
+void BufPool::Release(const char *buf) {
+  if (buf == nullptr) {
+    return;
+  }
+  AYAKA_TERM_IF(nused_ == 0 || RefCount(buf) == 0,
+                "release a buffer that is not acquired");
+  if (--RefCount(buf) > 0) {
+    return;
+  }
+  --nused_;
+  // 缓冲区归还后由 BufPool 独占，可以去掉 const。
+  auto *mut_buf = const_cast<char *>(buf);
+  if (free_.size() < max_free_) {
+    free_.push_back(mut_buf);
+    return;
+  }
+  delete[](mut_buf - kHeaderSize);
+}
+
+void BufPool::Clear() {
+  AYAKA_TERM_IF(nused_ != 0, "{} buffers are still in use", nused_);
+  for (auto *buf : free_) {
+    delete[](buf - kHeaderSize);
+  }
+  free_.clear();
+}
+
+size_t &BufPool::RefCount(const char *buf) {
+  return *reinterpret_cast<size_t *>(const_cast<char *>(buf) - kHeaderSize);
+}
+
+void BufRef::Reset() {
+  if (buf_ != nullptr) {
+    pool_->Release(buf_);
+    pool_ = nullptr;
+    buf_ = nullptr;
+  }
+}
+
+}  // namespace ayaka
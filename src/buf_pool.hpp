@@ -0,0 +1,164 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef AYAKA_SRC_BUF_POOL_HPP_
+#define AYAKA_SRC_BUF_POOL_HPP_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace ayaka {
+
+/**
+ * 固定大小的接收缓冲区池，每个工作线程一个，避免每次读取都分配和释放内存。
+ * 空闲的缓冲区最多缓存 max_free 个，多余的直接释放，因此内存占用是有界的。
+ *
+ * 缓冲区带有引用计数，解析出的请求可以通过 BufRef 引用接收缓冲区中的数据，
+ * 直到最后一个引用被释放后缓冲区才会归还。
+ *
+ * 因为实现原因，BufPool 对象只能在同一个线程中使用。
+ */
+class BufPool {
+ public:
+  BufPool() = default;
+
+  BufPool(size_t buf_size, size_t max_free)
+      : buf_size_(buf_size), max_free_(max_free) {}
+
+  /**
+   * BufPool 只能移动，不能拷贝。
+   */
+  BufPool(const BufPool &) = delete;
+  BufPool &operator=(const BufPool &) = delete;
+
+  BufPool(BufPool &&other) noexcept;
+  BufPool &operator=(BufPool &&other) noexcept;
+
+  ~BufPool();
+
+  [[nodiscard]] auto buf_size() const { return buf_size_; }
+  [[nodiscard]] auto max_free() const { return max_free_; }
+  /**
+   * 正在使用的缓冲区数量。
+   */
+  [[nodiscard]] auto nused() const { return nused_; }
+  [[nodiscard]] auto nfree() const { return free_.size(); }
+  /**
+   * 从创建以来实际调用 new 的次数。
+   */
+  [[nodiscard]] auto nallocs() const { return nallocs_; }
+  /**
+   * 当前占用的内存（包括正在使用的和空闲的缓冲区），单位为字节。
+   */
+  [[nodiscard]] size_t MemoryUsage() const {
+    return (nused_ + free_.size()) * buf_size_;
+  }
+
+  /**
+   * 返回一个大小为 buf_size() 的缓冲区，引用计数为 1，使用完毕后必须调用
+   * Release 归还。
+   */
+  [[nodiscard]] char *Acquire();
+  /**
+   * 增加 buf 的引用计数。buf 必须是由同一个 BufPool 的 Acquire 返回的。
+   */
+  void Retain(const char *buf);
+  /**
+   * 减少 buf 的引用计数，计数为 0 时归还缓冲区。buf 必须是由同一个 BufPool
+   * 的 Acquire 返回的。buf 可以为 nullptr。
+   */
+  void Release(const char *buf);
+
+  static constexpr size_t kDefaultBufSize = 16 * 1024;
+  static constexpr size_t kDefaultMaxFree = 64;
+
+ private:
+  void Clear();
+
+  /**
+   * 引用计数保存在缓冲区之前，kHeaderSize 保证缓冲区的对齐。
+   */
+  static constexpr size_t kHeaderSize = alignof(std::max_align_t);
+  static size_t &RefCount(const char *buf);
+
+  size_t buf_size_ = kDefaultBufSize;
+  size_t max_free_ = kDefaultMaxFree;
+  size_t nused_ = 0;
+  size_t nallocs_ = 0;
+  std::vector<char *> free_;
+};
+
+/**
+ * 持有 BufPool 中的一个缓冲区的引用，可以拷贝，最后一个 BufRef 析构时归还
+ * 缓冲区。BufRef 不能比 BufPool 存活得更久。
+ */
+class BufRef {
+ public:
+  BufRef() = default;
+
+  /**
+   * buf 必须是由 pool 的 Acquire 返回的，此时增加它的引用计数。
+   */
+  BufRef(BufPool &pool, const char *buf) : pool_(&pool), buf_(buf) {
+    pool_->Retain(buf_);
+  }
+
+  /**
+   * 拷贝时增加引用计数。
+   */
+  BufRef(const BufRef &other) : pool_(other.pool_), buf_(other.buf_) {
+    if (buf_ != nullptr) {
+      pool_->Retain(buf_);
+    }
+  }
+  BufRef &operator=(const BufRef &other) {
+    if (this != &other) {
+      BufRef(other).Swap(*this);
+    }
+    return *this;
+  }
+
+  BufRef(BufRef &&other) noexcept
+      : pool_(std::exchange(other.pool_, nullptr)),
+        buf_(std::exchange(other.buf_, nullptr)) {}
+  BufRef &operator=(BufRef &&other) noexcept {
+    if (this != &other) {
+      BufRef(std::move(other)).Swap(*this);
+    }
+    return *this;
+  }
+
+  ~BufRef() { Reset(); }
+
+  [[nodiscard]] auto data() const { return buf_; }
+  [[nodiscard]] bool Empty() const { return buf_ == nullptr; }
+
+  void Reset();
+  void Swap(BufRef &other) noexcept {
+    std::swap(pool_, other.pool_);
+    std::swap(buf_, other.buf_);
+  }
+
+ private:
+  BufPool *pool_ = nullptr;
+  const char *buf_ = nullptr;
+};
+
+}  // namespace ayaka
+
+#endif  // AYAKA_SRC_BUF_POOL_HPP_
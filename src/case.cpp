@@ -25,12 +25,12 @@ void StrLower(std::string& str) {
   }
 }
 
-bool StrEqualIgnoreCase(const std::string& str1, const std::string& str2) {
+bool StrEqualIgnoreCase(std::string_view str1, std::string_view str2) {
   if (str1.size() != str2.size()) {
     return false;
   }
   auto len = str1.size();
-  for (auto i = 0; i < len; ++i) {
+  for (size_t i = 0; i < len; ++i) {
     if (tolower(str1[i]) != tolower(str2[i])) {
       return false;
     }
@@ -38,4 +38,23 @@ bool StrEqualIgnoreCase(const std::string& str1, const std::string& str2) {
   return true;
 }
 
+size_t StrHashIgnoreCase(std::string_view str) {
+  // FNV-1a
+  size_t hash = 14695981039346656037ULL;
+  for (auto ch : str) {
+    hash ^= static_cast<unsigned char>(tolower(ch));
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+std::string_view TrimOws(std::string_view str) {
+  auto begin = str.find_first_not_of(" \t");
+  if (begin == std::string_view::npos) {
+    return {};
+  }
+  auto end = str.find_last_not_of(" \t");
+  return str.substr(begin, end - begin + 1);
+}
+
 }  // namespace ayaka
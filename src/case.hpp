@@ -18,14 +18,41 @@
 #ifndef AYAKA_SRC_CASE_HPP_
 #define AYAKA_SRC_CASE_HPP_
 
+#include <cstddef>
 #include <string>
+#include <string_view>
 
 namespace ayaka {
 
 void StrLower(std::string& str);
 
-[[nodiscard]] bool StrEqualIgnoreCase(const std::string& str1,
-                                      const std::string& str2);
+[[nodiscard]] bool StrEqualIgnoreCase(std::string_view str1,
+                                      std::string_view str2);
+
+/**
+ * 忽略大小写的哈希，与 StrEqualIgnoreCase 一致。
+ */
+[[nodiscard]] size_t StrHashIgnoreCase(std::string_view str);
+
+/**
+ * 去掉首尾的空格和制表符，即 HTTP 头部值中的 OWS。
+ */
+[[nodiscard]] std::string_view TrimOws(std::string_view str);
+
+/**
+ * 用于以 HTTP 头部名称等不区分大小写的字符串为键的 unordered_map。
+ */
+struct IgnoreCaseHash {
+  size_t operator()(std::string_view str) const {
+    return StrHashIgnoreCase(str);
+  }
+};
+
+struct IgnoreCaseEqual {
+  bool operator()(std::string_view str1, std::string_view str2) const {
+    return StrEqualIgnoreCase(str1, str2);
+  }
+};
 
 }  // namespace ayaka
 
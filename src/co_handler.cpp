@@ -0,0 +1,42 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "co_handler.hpp"
+
+#include <exception>
+#include <utility>
+
+namespace ayaka {
+
+void CoHttpHandler::HandleAsync(const std::shared_ptr<Request>& req,
+                                HttpCompletion completion) {
+  Spawn(Run(this, req, std::move(completion)));
+}
+
+Task<void> CoHttpHandler::Run(CoHttpHandler* handler,
+                              std::shared_ptr<Request> req,
+                              HttpCompletion completion) {
+  try {
+    co_await handler->HandleCo(req, completion);
+  } catch (...) {
+    completion.Fail(std::current_exception());
+    co_return;
+  }
+  completion.Finish();
+}
+
+}  // namespace ayaka
@@ -0,0 +1,58 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef AYAKA_SRC_CO_HANDLER_HPP_
+#define AYAKA_SRC_CO_HANDLER_HPP_
+
+#include <memory>
+
+#include "http_handler.hpp"
+#include "task.hpp"
+
+namespace ayaka {
+
+/**
+ * 使用协程处理请求的 HttpHandler，可以在 HandleCo 中 co_await awaitable.hpp
+ * 中的异步操作，以同步的写法实现非阻塞的处理逻辑。
+ */
+class CoHttpHandler : public HttpHandler {
+ public:
+  CoHttpHandler() = default;
+  CoHttpHandler(const CoHttpHandler&) = default;
+  CoHttpHandler& operator=(const CoHttpHandler&) = default;
+  CoHttpHandler(CoHttpHandler&&) noexcept = default;
+  CoHttpHandler& operator=(CoHttpHandler&&) noexcept = default;
+  ~CoHttpHandler() override = default;
+
+  void HandleAsync(const std::shared_ptr<Request>& req,
+                   HttpCompletion completion) override;
+
+  /**
+   * 填充 completion.resp()。协程返回时自动完成 completion，抛出的异常被转换为
+   * 对应的错误响应。
+   */
+  virtual Task<void> HandleCo(std::shared_ptr<Request> req,
+                              HttpCompletion completion) = 0;
+
+ private:
+  static Task<void> Run(CoHttpHandler* handler, std::shared_ptr<Request> req,
+                        HttpCompletion completion);
+};
+
+}  // namespace ayaka
+
+#endif  // AYAKA_SRC_CO_HANDLER_HPP_
@@ -0,0 +1,104 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "compress_cache.hpp"
+
+#include <atomic>
+
+namespace ayaka {
+
+namespace {
+
+std::atomic<size_t> gLocalBudget = CompressCache::kDefaultBudget;
+
+}  // namespace
+
+CompressCache::Content CompressCache::Get(const std::string &path,
+                                          Encoding encoding,
+                                          const File &file) {
+  auto iter = map_.find(MakeKey(path, encoding));
+  if (iter == map_.end()) {
+    ++nmisses_;
+    return nullptr;
+  }
+
+  auto node = iter->second;
+  if (node->ino != file.ino() || node->mtime != file.mtime() ||
+      node->size != file.size()) {
+    Erase(node);
+    ++nmisses_;
+    return nullptr;
+  }
+
+  lru_.splice(lru_.begin(), lru_, node);
+  ++nhits_;
+  return node->content;
+}
+
+void CompressCache::Put(const std::string &path, Encoding encoding,
+                        const File &file, Content content) {
+  if (content->size() > budget_) {
+    return;
+  }
+
+  auto key = MakeKey(path, encoding);
+  auto iter = map_.find(key);
+  if (iter != map_.end()) {
+    usage_ -= iter->second->content->size();
+    lru_.erase(iter->second);
+    map_.erase(iter);
+  }
+  while (usage_ + content->size() > budget_) {
+    Erase(std::prev(lru_.end()));
+  }
+
+  usage_ += content->size();
+  lru_.push_front(Node{key, std::move(content), file.ino(), file.mtime(),
+                       file.size()});
+  map_[std::move(key)] = lru_.begin();
+}
+
+void CompressCache::Clear() {
+  map_.clear();
+  lru_.clear();
+  usage_ = 0;
+}
+
+CompressCache &CompressCache::Local() {
+  thread_local CompressCache cache(gLocalBudget);
+  return cache;
+}
+
+void CompressCache::SetLocalDefault(size_t budget) { gLocalBudget = budget; }
+
+std::string CompressCache::MakeKey(const std::string &path,
+                                   Encoding encoding) {
+  // 路径中不会出现 NUL，因此不同的键不会冲突。
+  std::string key = path;
+  key += '\0';
+  key += EncodingName(encoding);
+  return key;
+}
+
+void CompressCache::Erase(std::list<Node>::iterator node) {
+  usage_ -= node->content->size();
+  map_.erase(node->key);
+  lru_.erase(node);
+  ++nevictions_;
+}
+
+}  // namespace ayaka
@@ -0,0 +1,122 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef AYAKA_SRC_COMPRESS_CACHE_HPP_
+#define AYAKA_SRC_COMPRESS_CACHE_HPP_
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "encoding.hpp"
+#include "file.hpp"
+
+namespace ayaka {
+
+/**
+ * 静态文件运行时压缩结果的缓存，键是文件路径和编码，按照 LRU 淘汰，缓存的
+ * 内容总共不超过 budget 字节。budget 为 0 时禁用缓存。
+ *
+ * 每个缓存项记录了压缩时文件的 inode、大小和修改时间，与当前打开的文件不一致
+ * 时视为失效，因此每个文件的每个版本只需要压缩一次。
+ *
+ * 因为实现原因，CompressCache 对象只能在同一个线程中使用。
+ */
+class CompressCache {
+ public:
+  using Content = std::shared_ptr<std::vector<char>>;
+
+  CompressCache() = default;
+
+  explicit CompressCache(size_t budget) : budget_(budget) {}
+
+  /**
+   * CompressCache 不能被拷贝或移动。
+   */
+  CompressCache(const CompressCache &) = delete;
+  CompressCache &operator=(const CompressCache &) = delete;
+  CompressCache(CompressCache &&) = delete;
+  CompressCache &operator=(CompressCache &&) = delete;
+
+  ~CompressCache() = default;
+
+  [[nodiscard]] auto budget() const { return budget_; }
+  [[nodiscard]] auto Size() const { return lru_.size(); }
+  [[nodiscard]] auto MemoryUsage() const { return usage_; }
+  [[nodiscard]] auto nhits() const { return nhits_; }
+  [[nodiscard]] auto nmisses() const { return nmisses_; }
+  [[nodiscard]] auto nevictions() const { return nevictions_; }
+
+  /**
+   * 返回 path 对应的文件使用 encoding 压缩后的内容。如果没有缓存或者缓存的
+   * 内容不是由 file 压缩得到的，返回 nullptr。
+   */
+  [[nodiscard]] Content Get(const std::string &path, Encoding encoding,
+                            const File &file);
+
+  /**
+   * 缓存 file 使用 encoding 压缩后的内容 content。content 超过 budget 时
+   * 什么也不做。
+   */
+  void Put(const std::string &path, Encoding encoding, const File &file,
+           Content content);
+
+  void Clear();
+
+  /**
+   * 当前线程的 CompressCache。每个工作线程有自己的缓存，因此不需要加锁。
+   */
+  static CompressCache &Local();
+
+  /**
+   * 设置之后创建的线程局部 CompressCache 的参数，应该在工作线程启动之前调用。
+   */
+  static void SetLocalDefault(size_t budget);
+
+  static constexpr size_t kDefaultBudget = 16 * 1024 * 1024;
+
+ private:
+  struct Node {
+    std::string key;
+    Content content;
+    ino_t ino;
+    time_t mtime;
+    // 压缩前的文件大小。
+    size_t size;
+  };
+
+  static std::string MakeKey(const std::string &path, Encoding encoding);
+
+  void Erase(std::list<Node>::iterator node);
+
+  size_t budget_ = kDefaultBudget;
+  // 缓存的内容的总字节数。
+  size_t usage_ = 0;
+  // 最近使用的缓存项位于链表头部。
+  std::list<Node> lru_;
+  std::unordered_map<std::string, std::list<Node>::iterator> map_;
+  size_t nhits_ = 0;
+  size_t nmisses_ = 0;
+  // 因为超出预算或者文件被修改而被移除的缓存项数量。
+  size_t nevictions_ = 0;
+};
+
+}  // namespace ayaka
+
+#endif  // AYAKA_SRC_COMPRESS_CACHE_HPP_
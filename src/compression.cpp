@@ -0,0 +1,437 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "compression.hpp"
+
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+
+#ifdef AYAKA_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#include "case.hpp"
+
+namespace ayaka {
+
+namespace {
+
+CompressOptions gOptions;
+
+/**
+ * gzip 格式的压缩器。
+ */
+class GzipCompressor : public Compressor {
+ public:
+  explicit GzipCompressor(int level) {
+    // windowBits 加上 16 表示输出 gzip 格式而不是 zlib 格式。
+    ok_ = deflateInit2(&stream_, level, Z_DEFLATED, 15 + 16, 8,
+                       Z_DEFAULT_STRATEGY) == Z_OK;
+  }
+
+  ~GzipCompressor() override {
+    if (ok_) {
+      deflateEnd(&stream_);
+    }
+  }
+
+  [[nodiscard]] auto ok() const { return ok_; }
+
+  bool Update(std::string_view data, std::vector<char>& out) override {
+    return Deflate(data, Z_NO_FLUSH, out);
+  }
+
+  bool Finish(std::vector<char>& out) override {
+    return Deflate({}, Z_FINISH, out);
+  }
+
+ private:
+  bool Deflate(std::string_view data, int flush, std::vector<char>& out) {
+    if (!ok_) {
+      return false;
+    }
+    // data 的长度不超过 kChunkSize，不会溢出 uInt。
+    stream_.next_in =
+        reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream_.avail_in = static_cast<uInt>(data.size());
+    while (true) {
+      auto used = out.size();
+      out.resize(used + kChunkSize);
+      stream_.next_out = reinterpret_cast<Bytef*>(out.data() + used);
+      stream_.avail_out = static_cast<uInt>(kChunkSize);
+      auto ret = deflate(&stream_, flush);
+      out.resize(used + kChunkSize - stream_.avail_out);
+      if (ret == Z_STREAM_ERROR) {
+        return false;
+      }
+      // 输出缓冲区没有用完说明输入已经全部处理。
+      if (flush == Z_FINISH ? ret == Z_STREAM_END : stream_.avail_out != 0) {
+        return true;
+      }
+    }
+  }
+
+  z_stream stream_{};
+  bool ok_ = false;
+};
+
+#ifdef AYAKA_WITH_ZSTD
+/**
+ * zstd 格式的压缩器。
+ */
+class ZstdCompressor : public Compressor {
+ public:
+  explicit ZstdCompressor(int level) : ctx_(ZSTD_createCCtx()) {
+    if (ctx_ != nullptr) {
+      ZSTD_CCtx_setParameter(ctx_, ZSTD_c_compressionLevel, level);
+    }
+  }
+
+  ~ZstdCompressor() override { ZSTD_freeCCtx(ctx_); }
+
+  [[nodiscard]] auto ok() const { return ctx_ != nullptr; }
+
+  bool Update(std::string_view data, std::vector<char>& out) override {
+    return Compress(data, ZSTD_e_continue, out);
+  }
+
+  bool Finish(std::vector<char>& out) override {
+    return Compress({}, ZSTD_e_end, out);
+  }
+
+ private:
+  bool Compress(std::string_view data, ZSTD_EndDirective mode,
+                std::vector<char>& out) {
+    if (ctx_ == nullptr) {
+      return false;
+    }
+    ZSTD_inBuffer in{data.data(), data.size(), 0};
+    while (true) {
+      auto used = out.size();
+      out.resize(used + kChunkSize);
+      ZSTD_outBuffer buf{out.data() + used, kChunkSize, 0};
+      auto remaining = ZSTD_compressStream2(ctx_, &buf, &in, mode);
+      out.resize(used + buf.pos);
+      if (ZSTD_isError(remaining) != 0) {
+        return false;
+      }
+      if (mode == ZSTD_e_end ? remaining == 0 : in.pos == in.size) {
+        return true;
+      }
+    }
+  }
+
+  ZSTD_CCtx* ctx_;
+};
+#endif
+
+/**
+ * 除了 text/ 开头的类型和 +json、+xml 后缀之外，值得压缩的类型。
+ */
+constexpr std::array<std::string_view, 8> kCompressibleTypes = {
+    "application/ecmascript", "application/javascript",
+    "application/json",       "application/wasm",
+    "application/xml",        "application/x-javascript",
+    "font/otf",               "font/ttf"};
+
+struct CompressReq {
+  uv_work_t req;
+  std::shared_ptr<File> file;
+  Encoding encoding;
+  Response::Body result;
+  std::function<void(Response::Body)> on_compress;
+};
+
+}  // namespace
+
+const CompressOptions& CompressOptions::Global() { return gOptions; }
+
+void CompressOptions::SetGlobal(const CompressOptions& options) {
+  gOptions = options;
+}
+
+std::unique_ptr<Compressor> Compressor::Create(Encoding encoding, int level) {
+  switch (encoding) {
+    case Encoding::kGzip: {
+      auto compressor = std::make_unique<GzipCompressor>(level);
+      if (compressor->ok()) {
+        return compressor;
+      }
+      return nullptr;
+    }
+#ifdef AYAKA_WITH_ZSTD
+    case Encoding::kZstd: {
+      auto compressor = std::make_unique<ZstdCompressor>(level);
+      if (compressor->ok()) {
+        return compressor;
+      }
+      return nullptr;
+    }
+#endif
+    default:
+      return nullptr;
+  }
+}
+
+bool Compressor::Supported(Encoding encoding) {
+#ifdef AYAKA_WITH_ZSTD
+  if (encoding == Encoding::kZstd) {
+    return true;
+  }
+#endif
+  return encoding == Encoding::kGzip;
+}
+
+bool Compressible(std::string_view mime) {
+  mime = TrimOws(mime.substr(0, mime.find(';')));
+  auto slash = mime.find('/');
+  if (slash == std::string_view::npos) {
+    return false;
+  }
+  if (StrEqualIgnoreCase(mime.substr(0, slash), "text")) {
+    return true;
+  }
+  auto plus = mime.rfind('+');
+  if (plus != std::string_view::npos && plus > slash) {
+    auto suffix = mime.substr(plus + 1);
+    if (StrEqualIgnoreCase(suffix, "json") ||
+        StrEqualIgnoreCase(suffix, "xml")) {
+      return true;
+    }
+  }
+  return std::any_of(
+      kCompressibleTypes.begin(), kCompressibleTypes.end(),
+      [mime](std::string_view type) { return StrEqualIgnoreCase(mime, type); });
+}
+
+Encoding SelectCompression(std::string_view accept_encoding) {
+  auto accepted = AcceptedEncodings(accept_encoding);
+  for (auto encoding : {Encoding::kZstd, Encoding::kGzip}) {
+    if (Compressor::Supported(encoding) &&
+        (accepted & EncodingBit(encoding)) != 0) {
+      return encoding;
+    }
+  }
+  return Encoding::kIdentity;
+}
+
+std::string CompressedETag(std::string_view etag, Encoding encoding) {
+  std::string result(etag);
+  if (result.empty() || result.back() != '"') {
+    return result;
+  }
+  result.pop_back();
+  result += '-';
+  result += EncodingName(encoding);
+  result += '"';
+  return result;
+}
+
+Response::Body CompressData(Encoding encoding, std::string_view data) {
+  auto compressor =
+      Compressor::Create(encoding, CompressOptions::Global().level());
+  if (!compressor) {
+    return nullptr;
+  }
+  auto out = std::make_shared<std::vector<char>>();
+  while (!data.empty()) {
+    auto chunk = data.substr(0, Compressor::kChunkSize);
+    if (!compressor->Update(chunk, *out)) {
+      return nullptr;
+    }
+    data.remove_prefix(chunk.size());
+  }
+  if (!compressor->Finish(*out)) {
+    return nullptr;
+  }
+  out->shrink_to_fit();
+  return out;
+}
+
+Response::Body CompressFile(Encoding encoding, const File& file) {
+  auto compressor =
+      Compressor::Create(encoding, CompressOptions::Global().level());
+  if (!compressor) {
+    return nullptr;
+  }
+  auto out = std::make_shared<std::vector<char>>();
+  std::vector<char> buf(std::min(Compressor::kChunkSize, file.size()));
+  size_t offset = 0;
+  while (offset < file.size()) {
+    auto len = std::min(buf.size(), file.size() - offset);
+    auto ret =
+        pread(file.fd(), buf.data(), len, static_cast<off_t>(offset));
+    if (ret == -1 && errno == EINTR) {
+      continue;
+    }
+    // 文件在压缩过程中被截断。
+    if (ret <= 0) {
+      return nullptr;
+    }
+    if (!compressor->Update({buf.data(), static_cast<size_t>(ret)}, *out)) {
+      return nullptr;
+    }
+    offset += ret;
+  }
+  if (!compressor->Finish(*out)) {
+    return nullptr;
+  }
+  out->shrink_to_fit();
+  return out;
+}
+
+void CompressFileAsync(uv_loop_t* loop, std::shared_ptr<File> file,
+                       Encoding encoding,
+                       std::function<void(Response::Body)> on_compress) {
+  auto* compress_req = new CompressReq;
+  compress_req->req.data = compress_req;
+  compress_req->file = std::move(file);
+  compress_req->encoding = encoding;
+  compress_req->on_compress = std::move(on_compress);
+  auto ret = uv_queue_work(
+      loop, &compress_req->req,
+      [](uv_work_t* req) {
+        auto* compress_req = static_cast<CompressReq*>(req->data);
+        compress_req->result =
+            CompressFile(compress_req->encoding, *compress_req->file);
+      },
+      [](uv_work_t* req, int status) {
+        auto* compress_req = static_cast<CompressReq*>(req->data);
+        compress_req->on_compress(
+            status == 0 ? std::move(compress_req->result) : nullptr);
+        delete compress_req;
+      });
+  if (ret < 0) {
+    compress_req->on_compress(nullptr);
+    delete compress_req;
+  }
+}
+
+namespace {
+
+struct CompressRespReq {
+  uv_work_t req;
+  std::shared_ptr<Response> resp;
+  // 在线程池中只访问 body，不访问 resp。
+  Response::Body body;
+  Encoding encoding;
+  Response::Body result;
+  std::function<void()> done;
+};
+
+/**
+ * 返回 resp 的响应体应该使用的压缩编码，不需要压缩时返回 kIdentity。需要时
+ * 在 Vary 中加上 Accept-Encoding。
+ */
+Encoding SelectRespCompression(const Request& req, Response& resp) {
+  const auto& body = resp.body();
+  if (!body || resp.HasFileBody() || resp.status().code() != "200" ||
+      !CompressOptions::Global().Admit(body->size())) {
+    return Encoding::kIdentity;
+  }
+  auto& headers = resp.headers();
+  const auto* type = headers.Find(Header::kContentType);
+  if (type == nullptr || !Compressible(*type) ||
+      headers.Find(Header::kContentEncoding) != nullptr) {
+    return Encoding::kIdentity;
+  }
+
+  // 处理器已经根据 Accept-Encoding 选择了表示，例如静态文件。
+  auto& vary = headers[Header::kVary];
+  if (vary.find("Accept-Encoding") != std::string::npos) {
+    return Encoding::kIdentity;
+  }
+  // 无论是否压缩，响应都取决于 Accept-Encoding。
+  vary += vary.empty() ? "Accept-Encoding" : ", Accept-Encoding";
+  const auto* accept = req.headers().Find(Header::kAcceptEncoding);
+  if (accept == nullptr) {
+    return Encoding::kIdentity;
+  }
+  return SelectCompression(*accept);
+}
+
+/**
+ * 用以 encoding 压缩后的 compressed 替换 resp 的响应体。
+ */
+void SetCompressedBody(Response& resp, Encoding encoding,
+                       Response::Body compressed) {
+  auto& headers = resp.headers();
+  headers[Header::kContentEncoding] = EncodingName(encoding);
+  if (const auto* etag = headers.Find(Header::kETag)) {
+    headers[Header::kETag] = CompressedETag(*etag, encoding);
+  }
+  // 处理器设置的 Content-Length 是压缩前的大小，由 SendRespPack 重新添加。
+  headers.Erase(Header::kContentLength);
+  resp.set_body(std::move(compressed));
+}
+
+}  // namespace
+
+void CompressResponse(const Request& req, Response& resp) {
+  auto encoding = SelectRespCompression(req, resp);
+  if (encoding == Encoding::kIdentity) {
+    return;
+  }
+  const auto& body = resp.body();
+  auto compressed = CompressData(encoding, {body->data(), body->size()});
+  if (compressed) {
+    SetCompressedBody(resp, encoding, std::move(compressed));
+  }
+}
+
+void CompressResponseAsync(uv_loop_t* loop, const Request& req,
+                           std::shared_ptr<Response> resp,
+                           std::function<void()> done) {
+  auto encoding = SelectRespCompression(req, *resp);
+  if (encoding == Encoding::kIdentity) {
+    done();
+    return;
+  }
+  auto* compress_req = new CompressRespReq;
+  compress_req->req.data = compress_req;
+  compress_req->body = resp->body();
+  compress_req->resp = std::move(resp);
+  compress_req->encoding = encoding;
+  compress_req->done = std::move(done);
+  auto ret = uv_queue_work(
+      loop, &compress_req->req,
+      [](uv_work_t* req) {
+        auto* compress_req = static_cast<CompressRespReq*>(req->data);
+        const auto& body = *compress_req->body;
+        compress_req->result =
+            CompressData(compress_req->encoding, {body.data(), body.size()});
+      },
+      [](uv_work_t* req, int status) {
+        auto* compress_req = static_cast<CompressRespReq*>(req->data);
+        if (status == 0 && compress_req->result) {
+          SetCompressedBody(*compress_req->resp, compress_req->encoding,
+                            std::move(compress_req->result));
+        }
+        compress_req->done();
+        delete compress_req;
+      });
+  if (ret < 0) {
+    compress_req->done();
+    delete compress_req;
+  }
+}
+
+}  // namespace ayaka
@@ -0,0 +1,188 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef AYAKA_SRC_COMPRESSION_HPP_
+#define AYAKA_SRC_COMPRESSION_HPP_
+
+#include <uv.h>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "encoding.hpp"
+#include "file.hpp"
+#include "request.hpp"
+#include "response.hpp"
+
+namespace ayaka {
+
+/**
+ * 运行时压缩的参数。
+ */
+class CompressOptions {
+ public:
+  CompressOptions() = default;
+  CompressOptions(const CompressOptions&) = default;
+  CompressOptions& operator=(const CompressOptions&) = default;
+  CompressOptions(CompressOptions&&) noexcept = default;
+  CompressOptions& operator=(CompressOptions&&) noexcept = default;
+  ~CompressOptions() = default;
+
+  /**
+   * 压缩级别，gzip 和 zstd 使用相同的值。为 0 时禁用运行时压缩。
+   */
+  [[nodiscard]] auto level() const { return level_; }
+  void set_level(int level) { level_ = level; }
+  [[nodiscard]] auto min_size() const { return min_size_; }
+  void set_min_size(size_t min_size) { min_size_ = min_size; }
+  [[nodiscard]] auto max_size() const { return max_size_; }
+  void set_max_size(size_t max_size) { max_size_ = max_size; }
+
+  /**
+   * 大小为 size 的内容是否需要压缩。
+   */
+  [[nodiscard]] bool Admit(size_t size) const {
+    return level_ > 0 && size >= min_size_ && size <= max_size_;
+  }
+
+  /**
+   * 所有工作线程共享的参数。
+   */
+  static const CompressOptions& Global();
+
+  /**
+   * 设置 Global 返回的参数，应该在工作线程启动之前调用。
+   */
+  static void SetGlobal(const CompressOptions& options);
+
+  static constexpr int kDefaultLevel = 6;
+  // 太小的内容压缩后几乎不会变小。
+  static constexpr size_t kDefaultMinSize = 256;
+  // 更大的内容直接使用 sendfile 发送，避免占用过多的内存和 CPU。
+  static constexpr size_t kDefaultMaxSize = 1024 * 1024;
+
+ private:
+  int level_ = kDefaultLevel;
+  size_t min_size_ = kDefaultMinSize;
+  size_t max_size_ = kDefaultMaxSize;
+};
+
+/**
+ * 流式压缩器。每次输入一块数据，压缩结果追加到输出的末尾，不需要一次性提供
+ * 全部输入。
+ */
+class Compressor {
+ public:
+  Compressor() = default;
+
+  /**
+   * Compressor 不能被拷贝或移动。
+   */
+  Compressor(const Compressor&) = delete;
+  Compressor& operator=(const Compressor&) = delete;
+  Compressor(Compressor&&) = delete;
+  Compressor& operator=(Compressor&&) = delete;
+
+  virtual ~Compressor() = default;
+
+  /**
+   * 压缩 data，结果追加到 out。失败时返回 false。
+   */
+  [[nodiscard]] virtual bool Update(std::string_view data,
+                                    std::vector<char>& out) = 0;
+
+  /**
+   * 结束压缩，剩余的结果追加到 out。失败时返回 false。
+   */
+  [[nodiscard]] virtual bool Finish(std::vector<char>& out) = 0;
+
+  /**
+   * 创建 encoding 的压缩器。不支持运行时压缩为 encoding 时返回 nullptr。
+   */
+  static std::unique_ptr<Compressor> Create(Encoding encoding, int level);
+
+  /**
+   * 是否支持运行时压缩为 encoding。br 只能使用预压缩的文件，zstd 需要在构建时
+   * 找到 libzstd。
+   */
+  static bool Supported(Encoding encoding);
+
+  // 每次从文件读取并压缩的字节数，也是输出缓冲区每次增长的字节数。
+  static constexpr size_t kChunkSize = 64 * 1024;
+};
+
+/**
+ * 类型为 mime 的内容是否值得压缩，mime 来自 Mime 表或者处理器设置的
+ * Content-Type。图片、视频和压缩包等已经压缩过的格式不会被压缩。
+ */
+[[nodiscard]] bool Compressible(std::string_view mime);
+
+/**
+ * 根据 Accept-Encoding 选择运行时压缩使用的编码，优先使用 zstd。客户端不接受
+ * 任何支持的编码时返回 kIdentity。
+ */
+[[nodiscard]] Encoding SelectCompression(std::string_view accept_encoding);
+
+/**
+ * 压缩后的表示的 ETag，在原来的 ETag 的引号内加上编码的名称，
+ * 例如 "1-2-3" 变为 "1-2-3-gzip"。
+ */
+[[nodiscard]] std::string CompressedETag(std::string_view etag,
+                                         Encoding encoding);
+
+/**
+ * 按照 Compressor::kChunkSize 分块压缩 data。失败时返回 nullptr。
+ */
+[[nodiscard]] Response::Body CompressData(Encoding encoding,
+                                          std::string_view data);
+
+/**
+ * 按照 Compressor::kChunkSize 分块读取并压缩整个文件，不需要把文件读入内存。
+ * 失败时返回 nullptr。
+ */
+[[nodiscard]] Response::Body CompressFile(Encoding encoding, const File& file);
+
+/**
+ * 与 CompressFile 相同，但是在 libuv 的线程池中读取并压缩文件。完成后在事件
+ * 循环线程中调用 on_compress。
+ */
+void CompressFileAsync(uv_loop_t* loop, std::shared_ptr<File> file,
+                       Encoding encoding,
+                       std::function<void(Response::Body)> on_compress);
+
+/**
+ * 压缩处理器在内存中生成的 200 响应体。已经设置了 Content-Encoding、类型
+ * 不适合压缩或者大小不合适时什么也不做。
+ */
+void CompressResponse(const Request& req, Response& resp);
+
+/**
+ * 与 CompressResponse 相同，但是在 libuv 的线程池中压缩，不阻塞事件循环。
+ * 完成后在事件循环线程中调用 done，不需要压缩时在返回之前调用。Downstream
+ * 在处理器完成之后、发送之前调用。
+ */
+void CompressResponseAsync(uv_loop_t* loop, const Request& req,
+                           std::shared_ptr<Response> resp,
+                           std::function<void()> done);
+
+}  // namespace ayaka
+
+#endif  // AYAKA_SRC_COMPRESSION_HPP_
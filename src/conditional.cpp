@@ -0,0 +1,122 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "conditional.hpp"
+
+#include <array>
+#include <cstdio>
+
+#include "case.hpp"
+
+namespace ayaka {
+
+namespace {
+
+/**
+ * 弱比较时忽略 W/ 前缀。
+ */
+std::string_view WeakTag(std::string_view etag) {
+  if (etag.starts_with("W/")) {
+    etag.remove_prefix(2);
+  }
+  return etag;
+}
+
+}  // namespace
+
+std::string FormatHttpDate(time_t time) {
+  tm tm{};
+  gmtime_r(&time, &tm);
+  char buf[32];
+  auto len = strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+  return {buf, len};
+}
+
+time_t ParseHttpDate(std::string_view date) {
+  constexpr std::array kFormats = {
+      "%a, %d %b %Y %H:%M:%S GMT",
+      "%A, %d-%b-%y %H:%M:%S GMT",
+      "%a %b %d %H:%M:%S %Y",
+  };
+  // strptime 需要以 '\0' 结尾的字符串。
+  char buf[64];
+  if (date.size() >= sizeof(buf)) {
+    return -1;
+  }
+  date.copy(buf, date.size());
+  buf[date.size()] = '\0';
+  for (const auto* format : kFormats) {
+    tm tm{};
+    const auto* end = strptime(buf, format, &tm);
+    if (end != nullptr && *end == '\0') {
+      return timegm(&tm);
+    }
+  }
+  return -1;
+}
+
+std::string MakeETag(const File& file) {
+  char buf[64];
+  auto len = snprintf(buf, sizeof(buf), "\"%llx-%zx-%llx\"",
+                      static_cast<unsigned long long>(file.ino()),
+                      file.size(),
+                      static_cast<unsigned long long>(file.mtime()));
+  return {buf, static_cast<size_t>(len)};
+}
+
+bool MatchETag(std::string_view list, std::string_view etag) {
+  etag = WeakTag(etag);
+  while (!list.empty()) {
+    auto comma = list.find(',');
+    auto item = TrimOws(list.substr(0, comma));
+    if (item == "*" || WeakTag(item) == etag) {
+      return true;
+    }
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    list.remove_prefix(comma + 1);
+  }
+  return false;
+}
+
+bool NotModified(const Request& req, std::string_view etag, time_t mtime) {
+  const auto& headers = req.headers();
+  if (const auto* list = headers.Find(Header::kIfNoneMatch)) {
+    return MatchETag(*list, etag);
+  }
+  if (const auto* since = headers.Find(Header::kIfModifiedSince)) {
+    auto time = ParseHttpDate(TrimOws(*since));
+    return time != -1 && mtime <= time;
+  }
+  return false;
+}
+
+bool IfRangeMatch(const Request& req, std::string_view etag, time_t mtime) {
+  const auto* value = req.headers().Find(Header::kIfRange);
+  if (value == nullptr) {
+    return true;
+  }
+  auto validator = TrimOws(*value);
+  // If-Range 中的 ETag 使用强比较，弱 ETag 不匹配任何值。
+  if (validator.starts_with('"') || validator.starts_with("W/")) {
+    return !etag.starts_with("W/") && validator == etag;
+  }
+  return ParseHttpDate(validator) == mtime;
+}
+
+}  // namespace ayaka
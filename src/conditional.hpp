@@ -0,0 +1,68 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef AYAKA_SRC_CONDITIONAL_HPP_
+#define AYAKA_SRC_CONDITIONAL_HPP_
+
+#include <ctime>
+#include <string>
+#include <string_view>
+
+#include "file.hpp"
+#include "request.hpp"
+
+namespace ayaka {
+
+/**
+ * 格式化为 IMF-fixdate 格式的 HTTP-date，例如
+ * Sun, 06 Nov 1994 08:49:37 GMT。
+ */
+[[nodiscard]] std::string FormatHttpDate(time_t time);
+
+/**
+ * 解析 HTTP-date，接受 IMF-fixdate 以及 RFC 850 和 asctime 两种过时的格式。
+ * 格式错误时返回 -1。
+ */
+[[nodiscard]] time_t ParseHttpDate(std::string_view date);
+
+/**
+ * 由 inode、大小和修改时间生成的 ETag，文件被替换或修改后随之改变。
+ */
+[[nodiscard]] std::string MakeETag(const File& file);
+
+/**
+ * If-None-Match 的值 list 中是否有与 etag 弱匹配的项，"*" 匹配任何 etag。
+ */
+[[nodiscard]] bool MatchETag(std::string_view list, std::string_view etag);
+
+/**
+ * 根据 If-None-Match 和 If-Modified-Since 判断是否可以用 304 响应 req。
+ * 两者都存在时忽略 If-Modified-Since。
+ */
+[[nodiscard]] bool NotModified(const Request& req, std::string_view etag,
+                               time_t mtime);
+
+/**
+ * 没有 If-Range，或者 If-Range 与 etag 强匹配、与 mtime 相同时返回 true，
+ * 表示可以只返回 Range 请求的范围，否则应该返回完整的内容。
+ */
+[[nodiscard]] bool IfRangeMatch(const Request& req, std::string_view etag,
+                                time_t mtime);
+
+}  // namespace ayaka
+
+#endif  // AYAKA_SRC_CONDITIONAL_HPP_
@@ -83,6 +83,21 @@ bool ServerConf::Valid() const {
   if (worker_threads_ <= 0 || worker_threads_ > kMaxWorkerThreads) {
     return false;
   }
+  if (keep_alive_requests_ < 0) {
+    return false;
+  }
+  if (recv_buf_size_ < kMinRecvBufSize || recv_buf_size_ > kMaxRecvBufSize) {
+    return false;
+  }
+  if (recv_buf_pool_size_ < 0) {
+    return false;
+  }
+  if (header_timeout_ < 0 || keep_alive_timeout_ < 0 || send_timeout_ < 0) {
+    return false;
+  }
+  if (max_body_size_ < 0) {
+    return false;
+  }
   return listen_.Valid();
 }
 
@@ -99,6 +114,48 @@ void ServerConf::FromJson(const nlohmann::json& json) {
     }
     worker_threads_ = json.at("worker_threads");
   }
+  if (json.find("keep_alive_requests") != json.end()) {
+    if (!json.at("keep_alive_requests").is_number_integer()) {
+      AYAKA_LOG_CRITICAL("\"keep_alive_requests\" must be an integer");
+    }
+    keep_alive_requests_ = json.at("keep_alive_requests");
+  }
+  if (json.find("recv_buf_size") != json.end()) {
+    if (!json.at("recv_buf_size").is_number_integer()) {
+      AYAKA_LOG_CRITICAL("\"recv_buf_size\" must be an integer");
+    }
+    recv_buf_size_ = json.at("recv_buf_size");
+  }
+  if (json.find("recv_buf_pool_size") != json.end()) {
+    if (!json.at("recv_buf_pool_size").is_number_integer()) {
+      AYAKA_LOG_CRITICAL("\"recv_buf_pool_size\" must be an integer");
+    }
+    recv_buf_pool_size_ = json.at("recv_buf_pool_size");
+  }
+  if (json.find("header_timeout") != json.end()) {
+    if (!json.at("header_timeout").is_number_integer()) {
+      AYAKA_LOG_CRITICAL("\"header_timeout\" must be an integer");
+    }
+    header_timeout_ = json.at("header_timeout");
+  }
+  if (json.find("keep_alive_timeout") != json.end()) {
+    if (!json.at("keep_alive_timeout").is_number_integer()) {
+      AYAKA_LOG_CRITICAL("\"keep_alive_timeout\" must be an integer");
+    }
+    keep_alive_timeout_ = json.at("keep_alive_timeout");
+  }
+  if (json.find("send_timeout") != json.end()) {
+    if (!json.at("send_timeout").is_number_integer()) {
+      AYAKA_LOG_CRITICAL("\"send_timeout\" must be an integer");
+    }
+    send_timeout_ = json.at("send_timeout");
+  }
+  if (json.find("max_body_size") != json.end()) {
+    if (!json.at("max_body_size").is_number_integer()) {
+      AYAKA_LOG_CRITICAL("\"max_body_size\" must be an integer");
+    }
+    max_body_size_ = json.at("max_body_size");
+  }
 }
 
 HttpConf::HttpConf() {
@@ -114,6 +171,69 @@ void HttpConf::FromJson(const nlohmann::json& json) {
     }
     mime_ = json["mime"];
   }
+  if (json.find("open_file_cache_size") != json.end()) {
+    if (!json.at("open_file_cache_size").is_number_unsigned()) {
+      AYAKA_LOG_CRITICAL(
+          "\"open_file_cache_size\" must be a non-negative integer");
+    }
+    open_file_cache_size_ = json.at("open_file_cache_size");
+  }
+  if (json.find("open_file_cache_valid") != json.end()) {
+    if (!json.at("open_file_cache_valid").is_number_unsigned()) {
+      AYAKA_LOG_CRITICAL(
+          "\"open_file_cache_valid\" must be a non-negative integer");
+    }
+    open_file_cache_valid_ = json.at("open_file_cache_valid");
+  }
+  if (json.find("mmap_max_file") != json.end()) {
+    if (!json.at("mmap_max_file").is_number_unsigned()) {
+      AYAKA_LOG_CRITICAL("\"mmap_max_file\" must be a non-negative integer");
+    }
+    mmap_max_file_ = json.at("mmap_max_file");
+  }
+  if (json.find("content_cache_size") != json.end()) {
+    if (!json.at("content_cache_size").is_number_unsigned()) {
+      AYAKA_LOG_CRITICAL(
+          "\"content_cache_size\" must be a non-negative integer");
+    }
+    content_cache_size_ = json.at("content_cache_size");
+  }
+  if (json.find("content_cache_max_file") != json.end()) {
+    if (!json.at("content_cache_max_file").is_number_unsigned()) {
+      AYAKA_LOG_CRITICAL(
+          "\"content_cache_max_file\" must be a non-negative integer");
+    }
+    content_cache_max_file_ = json.at("content_cache_max_file");
+  }
+  if (json.find("compression_level") != json.end()) {
+    if (!json.at("compression_level").is_number_unsigned() ||
+        json.at("compression_level") > kMaxCompressionLevel) {
+      AYAKA_LOG_CRITICAL(
+          "\"compression_level\" must be an integer between 0 and 9");
+    }
+    compression_level_ = json.at("compression_level");
+  }
+  if (json.find("compression_min_size") != json.end()) {
+    if (!json.at("compression_min_size").is_number_unsigned()) {
+      AYAKA_LOG_CRITICAL(
+          "\"compression_min_size\" must be a non-negative integer");
+    }
+    compression_min_size_ = json.at("compression_min_size");
+  }
+  if (json.find("compression_max_size") != json.end()) {
+    if (!json.at("compression_max_size").is_number_unsigned()) {
+      AYAKA_LOG_CRITICAL(
+          "\"compression_max_size\" must be a non-negative integer");
+    }
+    compression_max_size_ = json.at("compression_max_size");
+  }
+  if (json.find("compress_cache_size") != json.end()) {
+    if (!json.at("compress_cache_size").is_number_unsigned()) {
+      AYAKA_LOG_CRITICAL(
+          "\"compress_cache_size\" must be a non-negative integer");
+    }
+    compress_cache_size_ = json.at("compress_cache_size");
+  }
 }
 
 void RouteConf::FromJson(const nlohmann::json& json) {
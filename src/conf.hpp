@@ -76,8 +76,37 @@ class ServerConf {
   }
   [[nodiscard]] auto& listen() const { return listen_; }
   [[nodiscard]] auto& listen() { return listen_; }
+  [[nodiscard]] auto keep_alive_requests() const {
+    return keep_alive_requests_;
+  }
+  void set_keep_alive_requests(int keep_alive_requests) {
+    keep_alive_requests_ = keep_alive_requests;
+  }
+  [[nodiscard]] auto recv_buf_size() const { return recv_buf_size_; }
+  void set_recv_buf_size(int recv_buf_size) { recv_buf_size_ = recv_buf_size; }
+  [[nodiscard]] auto recv_buf_pool_size() const { return recv_buf_pool_size_; }
+  void set_recv_buf_pool_size(int recv_buf_pool_size) {
+    recv_buf_pool_size_ = recv_buf_pool_size;
+  }
+  [[nodiscard]] auto header_timeout() const { return header_timeout_; }
+  void set_header_timeout(int header_timeout) {
+    header_timeout_ = header_timeout;
+  }
+  [[nodiscard]] auto keep_alive_timeout() const { return keep_alive_timeout_; }
+  void set_keep_alive_timeout(int keep_alive_timeout) {
+    keep_alive_timeout_ = keep_alive_timeout;
+  }
+  [[nodiscard]] auto send_timeout() const { return send_timeout_; }
+  void set_send_timeout(int send_timeout) { send_timeout_ = send_timeout; }
+  [[nodiscard]] auto max_body_size() const { return max_body_size_; }
+  void set_max_body_size(int max_body_size) { max_body_size_ = max_body_size; }
 
   /* 工作线程数必须大于 0，并且小于等于 kMaxWorkerThreads。
+   * keep_alive_requests_ 不能小于 0。
+   * recv_buf_size_ 必须在 [kMinRecvBufSize, kMaxRecvBufSize] 范围内，
+   * recv_buf_pool_size_ 不能小于 0。
+   * 各个超时时间不能小于 0。
+   * max_body_size_ 不能小于 0。
    * 如果 listen_ 也必须有效。否则返回 false。
    */
   [[nodiscard]] bool Valid() const;
@@ -86,10 +115,34 @@ class ServerConf {
 
   static constexpr int kDefaultWorkerThreads = 4;
   static constexpr int kMaxWorkerThreads = 255;
+  // 每个连接最多处理的请求数，为 0 时表示禁用 keep-alive。
+  static constexpr int kDefaultKeepAliveRequests = 100;
+  // 接收缓冲区的大小，单位为字节。
+  static constexpr int kDefaultRecvBufSize = 16 * 1024;
+  static constexpr int kMinRecvBufSize = 1024;
+  static constexpr int kMaxRecvBufSize = 1024 * 1024;
+  // 每个工作线程最多缓存的空闲接收缓冲区数量。
+  static constexpr int kDefaultRecvBufPoolSize = 64;
+  // 接收请求头部的超时时间，单位为秒，从收到请求的第一个字节（或者连接建立）
+  // 开始计时。为 0 时不超时，下同。
+  static constexpr int kDefaultHeaderTimeout = 60;
+  // 保持连接时，两个请求之间的最长空闲时间。
+  static constexpr int kDefaultKeepAliveTimeout = 75;
+  // 发送响应时，两次成功写入之间的最长时间。
+  static constexpr int kDefaultSendTimeout = 60;
+  // 请求体的最大字节数，超过时返回 413 并关闭连接。为 0 时不限制。
+  static constexpr int kDefaultMaxBodySize = 1024 * 1024;
 
  private:
   ListenConf listen_;
   int worker_threads_ = kDefaultWorkerThreads;
+  int keep_alive_requests_ = kDefaultKeepAliveRequests;
+  int recv_buf_size_ = kDefaultRecvBufSize;
+  int recv_buf_pool_size_ = kDefaultRecvBufPoolSize;
+  int header_timeout_ = kDefaultHeaderTimeout;
+  int keep_alive_timeout_ = kDefaultKeepAliveTimeout;
+  int send_timeout_ = kDefaultSendTimeout;
+  int max_body_size_ = kDefaultMaxBodySize;
 };
 
 class HttpConf {
@@ -105,11 +158,86 @@ class HttpConf {
   void set_mime(std::string mime) {
     mime_ = std::move(mime);
   }
+  [[nodiscard]] auto open_file_cache_size() const {
+    return open_file_cache_size_;
+  }
+  void set_open_file_cache_size(int open_file_cache_size) {
+    open_file_cache_size_ = open_file_cache_size;
+  }
+  [[nodiscard]] auto open_file_cache_valid() const {
+    return open_file_cache_valid_;
+  }
+  void set_open_file_cache_valid(int open_file_cache_valid) {
+    open_file_cache_valid_ = open_file_cache_valid;
+  }
+  [[nodiscard]] auto mmap_max_file() const { return mmap_max_file_; }
+  void set_mmap_max_file(int mmap_max_file) { mmap_max_file_ = mmap_max_file; }
+  [[nodiscard]] auto content_cache_size() const { return content_cache_size_; }
+  void set_content_cache_size(int content_cache_size) {
+    content_cache_size_ = content_cache_size;
+  }
+  [[nodiscard]] auto content_cache_max_file() const {
+    return content_cache_max_file_;
+  }
+  void set_content_cache_max_file(int content_cache_max_file) {
+    content_cache_max_file_ = content_cache_max_file;
+  }
+  [[nodiscard]] auto compression_level() const { return compression_level_; }
+  void set_compression_level(int compression_level) {
+    compression_level_ = compression_level;
+  }
+  [[nodiscard]] auto compression_min_size() const {
+    return compression_min_size_;
+  }
+  void set_compression_min_size(int compression_min_size) {
+    compression_min_size_ = compression_min_size;
+  }
+  [[nodiscard]] auto compression_max_size() const {
+    return compression_max_size_;
+  }
+  void set_compression_max_size(int compression_max_size) {
+    compression_max_size_ = compression_max_size;
+  }
+  [[nodiscard]] auto compress_cache_size() const {
+    return compress_cache_size_;
+  }
+  void set_compress_cache_size(int compress_cache_size) {
+    compress_cache_size_ = compress_cache_size;
+  }
 
   void FromJson(const nlohmann::json& json);
 
+  // 每个工作线程最多缓存的已打开文件数，为 0 时禁用缓存。
+  static constexpr int kDefaultOpenFileCacheSize = 1024;
+  // 已打开文件的缓存在多少秒之后需要重新检查文件是否被修改。
+  static constexpr int kDefaultOpenFileCacheValid = 10;
+  // 不能放入内容缓存、并且不超过这个字节数的文件映射到内存，随已打开文件的
+  // 缓存项一起缓存。为 0 时使用 sendfile 发送。
+  static constexpr int kDefaultMmapMaxFile = 0;
+  // 每个工作线程缓存的文件内容的总字节数，为 0 时禁用缓存。
+  static constexpr int kDefaultContentCacheSize = 16 * 1024 * 1024;
+  // 大于这个字节数的文件不会被读入内存缓存。
+  static constexpr int kDefaultContentCacheMaxFile = 64 * 1024;
+  // 运行时压缩的级别，为 0 时禁用运行时压缩。
+  static constexpr int kDefaultCompressionLevel = 6;
+  static constexpr int kMaxCompressionLevel = 9;
+  // 只压缩大小在 [compression_min_size, compression_max_size] 范围内的内容。
+  static constexpr int kDefaultCompressionMinSize = 256;
+  static constexpr int kDefaultCompressionMaxSize = 1024 * 1024;
+  // 每个工作线程缓存的静态文件压缩结果的总字节数，为 0 时禁用缓存。
+  static constexpr int kDefaultCompressCacheSize = 16 * 1024 * 1024;
+
  private:
   std::string mime_;
+  int open_file_cache_size_ = kDefaultOpenFileCacheSize;
+  int open_file_cache_valid_ = kDefaultOpenFileCacheValid;
+  int mmap_max_file_ = kDefaultMmapMaxFile;
+  int content_cache_size_ = kDefaultContentCacheSize;
+  int content_cache_max_file_ = kDefaultContentCacheMaxFile;
+  int compression_level_ = kDefaultCompressionLevel;
+  int compression_min_size_ = kDefaultCompressionMinSize;
+  int compression_max_size_ = kDefaultCompressionMaxSize;
+  int compress_cache_size_ = kDefaultCompressCacheSize;
 };
 
 class RouteConf {
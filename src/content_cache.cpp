@@ -0,0 +1,96 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "content_cache.hpp"
+
+#include <atomic>
+
+namespace ayaka {
+
+namespace {
+
+std::atomic<size_t> gLocalBudget = ContentCache::kDefaultBudget;
+std::atomic<size_t> gLocalMaxFileSize = ContentCache::kDefaultMaxFileSize;
+
+}  // namespace
+
+ContentCache::Content ContentCache::Get(const std::string &key,
+                                        const File &file) {
+  auto iter = map_.find(key);
+  if (iter == map_.end()) {
+    ++nmisses_;
+    return nullptr;
+  }
+
+  auto node = iter->second;
+  if (node->ino != file.ino() || node->mtime != file.mtime() ||
+      node->content->size() != file.size()) {
+    Erase(node);
+    ++nmisses_;
+    return nullptr;
+  }
+
+  lru_.splice(lru_.begin(), lru_, node);
+  ++nhits_;
+  return node->content;
+}
+
+void ContentCache::Put(const std::string &key, const File &file,
+                       Content content) {
+  if (!Admit(file) || content->size() != file.size()) {
+    return;
+  }
+
+  auto iter = map_.find(key);
+  if (iter != map_.end()) {
+    usage_ -= iter->second->content->size();
+    lru_.erase(iter->second);
+    map_.erase(iter);
+  }
+  while (usage_ + content->size() > budget_) {
+    Erase(std::prev(lru_.end()));
+  }
+
+  usage_ += content->size();
+  lru_.push_front(Node{key, std::move(content), file.ino(), file.mtime()});
+  map_[key] = lru_.begin();
+}
+
+void ContentCache::Clear() {
+  map_.clear();
+  lru_.clear();
+  usage_ = 0;
+}
+
+ContentCache &ContentCache::Local() {
+  thread_local ContentCache cache(gLocalBudget, gLocalMaxFileSize);
+  return cache;
+}
+
+void ContentCache::SetLocalDefault(size_t budget, size_t max_file_size) {
+  gLocalBudget = budget;
+  gLocalMaxFileSize = max_file_size;
+}
+
+void ContentCache::Erase(std::list<Node>::iterator node) {
+  usage_ -= node->content->size();
+  map_.erase(node->key);
+  lru_.erase(node);
+  ++nevictions_;
+}
+
+}  // namespace ayaka
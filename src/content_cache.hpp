@@ -0,0 +1,126 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef AYAKA_SRC_CONTENT_CACHE_HPP_
+#define AYAKA_SRC_CONTENT_CACHE_HPP_
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "file.hpp"
+
+namespace ayaka {
+
+/**
+ * 小文件内容的缓存，按照 LRU 淘汰，缓存的内容总共不超过 budget 字节，超过
+ * max_file_size 字节的文件不会被缓存。budget 为 0 时禁用缓存。
+ *
+ * 缓存的内容是不可变的共享缓冲区，可以直接用作多个响应的响应体。每个缓存项
+ * 记录了读取时文件的 inode、大小和修改时间，与当前打开的文件不一致时视为
+ * 失效。
+ *
+ * 因为实现原因，ContentCache 对象只能在同一个线程中使用。
+ */
+class ContentCache {
+ public:
+  using Content = std::shared_ptr<std::vector<char>>;
+
+  ContentCache() = default;
+
+  ContentCache(size_t budget, size_t max_file_size)
+      : budget_(budget), max_file_size_(max_file_size) {}
+
+  /**
+   * ContentCache 不能被拷贝或移动。
+   */
+  ContentCache(const ContentCache &) = delete;
+  ContentCache &operator=(const ContentCache &) = delete;
+  ContentCache(ContentCache &&) = delete;
+  ContentCache &operator=(ContentCache &&) = delete;
+
+  ~ContentCache() = default;
+
+  [[nodiscard]] auto budget() const { return budget_; }
+  [[nodiscard]] auto max_file_size() const { return max_file_size_; }
+  [[nodiscard]] auto Size() const { return lru_.size(); }
+  [[nodiscard]] auto MemoryUsage() const { return usage_; }
+  [[nodiscard]] auto nhits() const { return nhits_; }
+  [[nodiscard]] auto nmisses() const { return nmisses_; }
+  [[nodiscard]] auto nevictions() const { return nevictions_; }
+
+  /**
+   * 文件是否可以被缓存。
+   */
+  [[nodiscard]] bool Admit(const File &file) const {
+    return file.size() <= max_file_size_ && file.size() <= budget_;
+  }
+
+  /**
+   * 返回 key 对应的文件内容。如果没有缓存或者缓存的内容与 file 不一致，
+   * 返回 nullptr。
+   */
+  [[nodiscard]] Content Get(const std::string &key, const File &file);
+
+  /**
+   * 缓存 file 的内容 content。文件不能被缓存时什么也不做。
+   */
+  void Put(const std::string &key, const File &file, Content content);
+
+  void Clear();
+
+  /**
+   * 当前线程的 ContentCache。每个工作线程有自己的缓存，因此不需要加锁。
+   */
+  static ContentCache &Local();
+
+  /**
+   * 设置之后创建的线程局部 ContentCache 的参数，应该在工作线程启动之前调用。
+   */
+  static void SetLocalDefault(size_t budget, size_t max_file_size);
+
+  static constexpr size_t kDefaultBudget = 16 * 1024 * 1024;
+  static constexpr size_t kDefaultMaxFileSize = 64 * 1024;
+
+ private:
+  struct Node {
+    std::string key;
+    Content content;
+    ino_t ino;
+    time_t mtime;
+  };
+
+  void Erase(std::list<Node>::iterator node);
+
+  size_t budget_ = kDefaultBudget;
+  size_t max_file_size_ = kDefaultMaxFileSize;
+  // 缓存的内容的总字节数。
+  size_t usage_ = 0;
+  // 最近使用的缓存项位于链表头部。
+  std::list<Node> lru_;
+  std::unordered_map<std::string, std::list<Node>::iterator> map_;
+  size_t nhits_ = 0;
+  size_t nmisses_ = 0;
+  // 因为超出预算或者文件被修改而被移除的缓存项数量。
+  size_t nevictions_ = 0;
+};
+
+}  // namespace ayaka
+
+#endif  // AYAKA_SRC_CONTENT_CACHE_HPP_
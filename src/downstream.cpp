@@ -19,48 +19,347 @@
 
 #include <iostream>
 #include <memory>
+#include <stdexcept>
 #include <string>
 
+#include "compression.hpp"
+
 namespace ayaka {
 
-Downstream::Downstream(std::shared_ptr<Tcp> tcp, std::shared_ptr<Router> router)
-    : tcp_(std::move(tcp)), router_(std::move(router)) {
+Downstream::Downstream(std::shared_ptr<Tcp> tcp, std::shared_ptr<Router> router,
+                       const ServerConf& conf)
+    : tcp_(std::move(tcp)),
+      router_(std::move(router)),
+      keep_alive_requests_(conf.keep_alive_requests()),
+      header_timeout_(conf.header_timeout()),
+      keep_alive_timeout_(conf.keep_alive_timeout()),
+      send_timeout_(conf.send_timeout()) {
+  parser_.set_max_body_size(conf.max_body_size());
   tcp_->set_on_recv([this](const char* buf, size_t len) { OnRecv(buf, len); });
+  tcp_->set_on_send_progress([this]() { StartSendTimer(); });
+  UpdateReadTimer();
+}
+
+Downstream::~Downstream() {
+  if (parser_.state() == RequestParser::State::kBody) {
+    parser_.req()->body().Abort(std::make_exception_ptr(std::runtime_error(
+        "connection closed before the request body was received")));
+  }
 }
 
 void Downstream::OnRecv(const char* buf, size_t len) {
-  try {
-    HandleRecv(buf, len);
-  } catch (const HttpExcept& except) {
-    auto resp = Response::Default();
-    except.SetUp(resp);
-    Send(resp);
+  if (!Accepting()) {
+    return;
   }
+  receiving_ = true;
+  HandleRecv(buf, len);
+  receiving_ = false;
+  Flush();
+  UpdateReadTimer();
   // 由 Tcp 负责释放 buf.base。
 }
 
 void Downstream::HandleRecv(const char* buf, size_t len) {
   const auto* base = buf;
-  while (len > 0) {
-    // 可能会抛出 Http400Except。
-    auto nparsed = parser_.Exec(base, len);
+  // 请求直接引用接收缓冲区中的数据，在请求被释放之前缓冲区不会被归还。
+  BufRef buf_ref(tcp_->loop()->buf_pool(), buf);
+  while (len > 0 && Accepting()) {
+    auto in_head = parser_.InHead();
+    auto nparsed = parser_.Exec(base, len, buf_ref);
     base += nparsed;
     len -= nparsed;
+    if (parser_.state() == RequestParser::State::kError) {
+      OnParseError(in_head);
+      return;
+    }
+    if (in_head && !parser_.InHead()) {
+      // 收到完整的请求头部后立即处理，不等待请求体。
+      in_request_ = false;
+      HandleReq(parser_.req());
+    } else if (in_head && nparsed > 0) {
+      in_request_ = true;
+    }
     if (parser_.state() == RequestParser::State::kDone) {
-      auto req = parser_.req();
-      auto resp = Response::Default();
-      auto handler = router_->Route(req->url().path().string());
-      handler->Handle(req, resp);
-      AYAKA_LOG_INFO("{} {} {}", req->method(), req->url().src(),
-                     resp->status().code());
-      Send(resp);
+      body_pending_.reset();
+      parser_.Reset();
+    }
+  }
+}
+
+void Downstream::OnParseError(bool in_head) {
+  auto error = parser_.error();
+  if (!in_head) {
+    // 请求已经交给处理器，由处理器根据请求体的错误生成响应。只有等待请求体
+    // 的处理器才会收到异常，这种情况很少见。
+    AbortBody(error == HttpError::kPayloadTooLarge
+                  ? std::make_exception_ptr(Http413Except())
+                  : std::make_exception_ptr(Http400Except()));
+    return;
+  }
+  // 请求格式错误，解析器的状态已不可信，发送响应后关闭连接。
+  AYAKA_LOG_DEBUG("invalid request head, error {}", static_cast<int>(error));
+  parser_.Reset();
+  auto resp = Response::Default();
+  SetUpError(*resp, error);
+  Send(resp, false);
+}
+
+void Downstream::AbortBody(const std::exception_ptr& except) {
+  parser_.req()->body().Abort(except);
+  parser_.Reset();
+  // 请求体的剩余部分无法跳过，响应之后关闭连接。
+  closing_ = true;
+  if (body_pending_) {
+    body_pending_->keep_alive = false;
+    // 已经发送的响应不能再修改，由下面或者 OnFlushFinish 关闭连接。
+    if (body_pending_->ready && !body_pending_->sent) {
+      body_pending_->resp->headers()[Header::kConnection] = "close";
+    }
+    body_pending_.reset();
+  }
+  // 响应已经发送完毕，不会再有写入完成时关闭连接。
+  if (Drained()) {
+    read_timer_.Cancel();
+    tcp_->Close();
+  }
+}
+
+void Downstream::HandleReq(const std::shared_ptr<Request>& req) {
+  ++nrequests_;
+  auto pending =
+      Enqueue(req->KeepAlive() && nrequests_ < keep_alive_requests_);
+  pending->resp = Response::Default();
+  if (parser_.state() == RequestParser::State::kBody) {
+    body_pending_ = pending;
+  }
+
+  HttpCompletion completion(
+      tcp_->loop(), req, pending->resp,
+      [weak = weak_from_this(), pending, req](std::exception_ptr except) {
+        // 连接可能在处理期间被关闭。
+        if (auto self = weak.lock()) {
+          self->OnHandled(pending, req, except);
+        }
+      });
+  auto handler = router_->Route(req->url().path().string());
+  if (!handler) {
+    // 404 不经过异常，也不需要请求体。
+    AYAKA_LOG_DEBUG("{} {} 404", req->method(), req->url().src());
+    req->body().Discard();
+    completion.Fail(HttpError::kNotFound);
+    return;
+  }
+  // 兼容仍然抛出 HttpExcept 的处理器。
+  try {
+    handler->HandleAsync(req, completion);
+  } catch (const HttpExcept& except) {
+    completion.Fail(std::current_exception());
+  }
+}
+
+void Downstream::OnHandled(const std::shared_ptr<PendingResp>& pending,
+                           const std::shared_ptr<Request>& req,
+                           const std::exception_ptr& except) {
+  if (except) {
+    try {
+      std::rethrow_exception(except);
+    } catch (const HttpExcept& http_except) {
+      // 404、405 等错误不影响连接的复用。
+      pending->resp = Response::Default();
+      http_except.SetUp(pending->resp);
+    } catch (...) {
+      pending->resp = Response::Default();
+      Http500Except(req->method(), req->url().src()).SetUp(pending->resp);
     }
+  } else {
+    AYAKA_LOG_INFO("{} {} {}", req->method(), req->url().src(),
+                   pending->resp->status().code());
+    // 压缩完成之前响应留在队列中，之后的响应也不会被发送。
+    CompressResponseAsync(tcp_->loop()->uv_loop(), *req, pending->resp,
+                          [weak = weak_from_this(), pending]() {
+                            // 连接可能在压缩期间被关闭。
+                            if (auto self = weak.lock()) {
+                              self->Respond(*pending);
+                            }
+                          });
+    return;
+  }
+  Respond(*pending);
+}
+
+void Downstream::Respond(PendingResp& pending) {
+  Complete(pending);
+  if (!receiving_) {
+    Flush();
+  }
+}
+
+std::shared_ptr<Downstream::PendingResp> Downstream::Enqueue(
+    bool keep_alive) {
+  auto pending = std::make_shared<PendingResp>();
+  pending->keep_alive = keep_alive;
+  pending_.push_back(pending);
+  if (!keep_alive) {
+    closing_ = true;
+  }
+  if (pending_.size() >= kMaxPendingResps && !recv_paused_) {
+    recv_paused_ = true;
+    tcp_->PauseRecv();
+  }
+  return pending;
+}
+
+void Downstream::Complete(PendingResp& pending) {
+  auto& headers = pending.resp->headers();
+  headers[Header::kConnection] = pending.keep_alive ? "keep-alive" : "close";
+  // 保持连接时，客户端依靠 Content-Length 确定响应的结束位置，
+  // 由 SendRespPack 根据响应体自动添加。
+  pending.ready = true;
+}
+
+void Downstream::Send(const std::shared_ptr<Response>& resp, bool keep_alive) {
+  auto pending = Enqueue(keep_alive);
+  pending->resp = resp;
+  Complete(*pending);
+}
+
+void Downstream::Flush() {
+  // 连接可能因为超时或者读取错误正在关闭，此时异步处理的请求仍然可能完成。
+  if (writing_ || tcp_->Closing()) {
+    return;
+  }
+
+  std::vector<std::shared_ptr<Response>> resps;
+  while (!pending_.empty() && pending_.front()->ready) {
+    pending_.front()->sent = true;
+    resps.push_back(std::move(pending_.front()->resp));
+    pending_.pop_front();
+    // 文件响应体需要在头部发送完成之后通过 sendfile 发送，
+    // 之后的响应留到下一次发送。
+    if (resps.back()->HasFileBody()) {
+      break;
+    }
+  }
+  if (resps.empty()) {
+    return;
+  }
+  // closing_ 为 true 时不会再产生新的响应，所以关闭连接的响应一定是最后一个。
+  auto close = closing_ && pending_.empty();
+  auto last = resps.back();
+
+  writing_ = true;
+  ++nsends_;
+  StartSendTimer();
+  // 头部写入本线程的 BufPool，避免每次发送都分配内存。
+  std::shared_ptr<SendPack> send_pack = std::make_shared<SendRespPack>(
+      std::move(resps), &tcp_->loop()->buf_pool());
+  if (!last->HasFileBody()) {
+    tcp_->Send(send_pack, [this, close]() { OnFlushFinish(close); });
+    return;
+  }
+  tcp_->Send(send_pack, [this, close, last = std::move(last)]() {
+    SendFileBody(last, 0, close);
+  });
+}
+
+void Downstream::SendFileBody(const std::shared_ptr<Response>& resp,
+                              size_t index, bool close) {
+  const auto& parts = resp->parts();
+  if (parts.empty()) {
+    tcp_->SendFile(resp->file_body(),
+                   [this, close]() { OnFlushFinish(close); });
+    return;
+  }
+  tcp_->SendFile(parts[index].file, [this, resp, index, close]() {
+    auto next = index + 1;
+    if (next == resp->parts().size()) {
+      OnFlushFinish(close);
+      return;
+    }
+    // 第一段的 data 随头部发送，之后每段的 data 在上一段的文件内容之后发送。
+    const auto& data = resp->parts()[next].data;
+    if (data.empty()) {
+      SendFileBody(resp, next, close);
+      return;
+    }
+    tcp_->Send(std::make_shared<SendBufPack>(resp, data),
+               [this, resp, next, close]() {
+                 SendFileBody(resp, next, close);
+               });
+  });
+}
+
+void Downstream::OnFlushFinish(bool close) {
+  writing_ = false;
+  send_timer_.Cancel();
+  // 响应以保持连接的方式发出之后，请求体出错决定关闭连接。
+  if (close || Drained()) {
+    read_timer_.Cancel();
+    tcp_->Close();
+    return;
+  }
+  if (recv_paused_) {
+    recv_paused_ = false;
+    tcp_->ResumeRecv();
+  }
+  Flush();
+  UpdateReadTimer();
+}
+
+void Downstream::UpdateReadTimer() {
+  if (parser_.state() == RequestParser::State::kBody) {
+    // 接收请求体时，header_timeout 限制两次读取之间的时间。
+    StartReadTimer(header_timeout_, false);
+    return;
+  }
+  if (closing_) {
+    read_timer_.Cancel();
+    return;
+  }
+  if (in_request_) {
+    // 头部超时从请求的第一个字节开始计时，之后收到数据不会重新计时。
+    if (!read_timer_.Active() || idle_) {
+      StartReadTimer(header_timeout_, false);
+    }
+    return;
+  }
+  if (pending_.empty() && !writing_) {
+    // 连接建立之后的第一个请求同样使用头部超时。
+    auto idle = nrequests_ > 0;
+    if (!read_timer_.Active() || idle_ != idle) {
+      StartReadTimer(idle ? keep_alive_timeout_ : header_timeout_, idle);
+    }
+    return;
+  }
+  read_timer_.Cancel();
+}
+
+void Downstream::StartReadTimer(std::chrono::seconds timeout, bool idle) {
+  idle_ = idle;
+  if (timeout.count() == 0) {
+    read_timer_.Cancel();
+    return;
+  }
+  tcp_->loop()->timer_wheel().Start(read_timer_, timeout, [this, idle]() {
+    OnTimeout(idle ? "keep-alive" : "header");
+  });
+}
+
+void Downstream::StartSendTimer() {
+  if (send_timeout_.count() == 0) {
+    return;
   }
+  tcp_->loop()->timer_wheel().Start(send_timer_, send_timeout_,
+                                    [this]() { OnTimeout("send"); });
 }
 
-void Downstream::Send(std::shared_ptr<Response> resp) {
-  std::shared_ptr<SendPack> send_pack = std::make_shared<SendRespPack>(resp);
-  tcp_->Send(send_pack, [this]() { tcp_->Close(); });
+void Downstream::OnTimeout(const char* what) {
+  AYAKA_LOG_DEBUG("{} timeout after {} requests, closing connection", what,
+                  nrequests_);
+  closing_ = true;
+  read_timer_.Cancel();
+  send_timer_.Cancel();
+  tcp_->Close();
 }
 
 }  // namespace ayaka
@@ -18,44 +18,170 @@
 #ifndef AYAKA_SRC_DOWNSTREAM_HPP_
 #define AYAKA_SRC_DOWNSTREAM_HPP_
 
+#include <chrono>
+#include <deque>
+#include <exception>
 #include <memory>
 
+#include "conf.hpp"
 #include "http_parser.hpp"
 #include "logger.hpp"
 #include "router.hpp"
 #include "tcp.hpp"
+#include "timer_wheel.hpp"
 
 namespace ayaka {
 
-class Downstream {
+/**
+ * Downstream 表示一个客户端连接。HTTP/1.1 的连接默认保持打开，直到客户端要求
+ * 关闭、发生解析错误或者处理的请求数达到 keep_alive_requests。
+ *
+ * 客户端可以使用管线化（pipelining）连续发送多个请求。响应按照请求的顺序排队，
+ * 同一次读取中产生的响应以及上一次写入期间积累的响应会合并为一次 uv_write。
+ *
+ * 请求通过 HttpHandler::HandleAsync 处理，可能在之后的事件循环迭代中才完成。
+ * 先完成的响应会等待之前的响应完成后再发送。Downstream 必须由 shared_ptr 管理。
+ * 收到请求头部后就开始处理请求，请求体随后被传递到 Request::body()。
+ *
+ * 接收请求头部、保持连接时的空闲以及发送响应分别有超时时间，超时后直接关闭
+ * 连接。定时器由事件循环的 TimerWheel 管理。
+ */
+class Downstream : public std::enable_shared_from_this<Downstream> {
  public:
   Downstream() = default;
 
-  explicit Downstream(std::shared_ptr<Tcp> tcp, std::shared_ptr<Router> router);
+  Downstream(std::shared_ptr<Tcp> tcp, std::shared_ptr<Router> router,
+             const ServerConf &conf);
 
   /**
-   * Downstream 只能移动，不能拷贝。
+   * Downstream 的定时器被链接在 TimerWheel 中，不能被拷贝或移动。
    */
   Downstream(const Downstream &) = delete;
   Downstream &operator=(const Downstream &) = delete;
-  Downstream(Downstream &&) noexcept = default;
-  Downstream &operator=(Downstream &&) noexcept = default;
+  Downstream(Downstream &&) = delete;
+  Downstream &operator=(Downstream &&) = delete;
 
-  ~Downstream() = default;
+  /**
+   * 请求体还没有接收完毕时，通知处理器连接已经关闭。
+   */
+  ~Downstream();
 
   [[nodiscard]] auto &tcp() const { return tcp_; }
   [[nodiscard]] auto &tcp() { return tcp_; }
 
   auto router_ptr() const { return router_.get(); }
 
+  [[nodiscard]] auto nrequests() const { return nrequests_; }
+  [[nodiscard]] auto nsends() const { return nsends_; }
+  /**
+   * 还没有开始发送的响应数，包括还没有处理完成的响应。
+   */
+  [[nodiscard]] auto npending() const { return pending_.size(); }
+
+  // 待发送的响应达到此数量时暂停接收数据。
+  static constexpr size_t kMaxPendingResps = 64;
+
  private:
-  void Send(std::shared_ptr<Response> resp);
+  /**
+   * 发送队列中的一项，ready 为 false 时响应还没有处理完成。sent 为 true 时
+   * 响应已经交给 Tcp 发送并移出队列，resp 不再可用。
+   */
+  struct PendingResp {
+    std::shared_ptr<Response> resp;
+    bool keep_alive = true;
+    bool ready = false;
+    bool sent = false;
+  };
+
+  /**
+   * 在发送队列的末尾加入一个还未完成的响应。
+   */
+  std::shared_ptr<PendingResp> Enqueue(bool keep_alive);
+  /**
+   * 设置响应的 Connection 和 Content-Length 头部并标记为已完成。
+   */
+  void Complete(PendingResp &pending);
+  /**
+   * 完成响应，不在接收数据时立即发送。
+   */
+  void Respond(PendingResp &pending);
+  void OnHandled(const std::shared_ptr<PendingResp> &pending,
+                 const std::shared_ptr<Request> &req,
+                 const std::exception_ptr &except);
+  /**
+   * 将响应加入发送队列。如果 keep_alive 为 false，发送完成后关闭连接，并且不再
+   * 处理后续的请求。
+   */
+  void Send(const std::shared_ptr<Response> &resp, bool keep_alive);
+  /**
+   * 如果当前没有正在进行的写入，将队列中所有的响应合并为一次写入。
+   */
+  void Flush();
+  /**
+   * 头部发送完成后，通过 sendfile 发送 resp 的 file_body，或者从第 index 段
+   * 开始依次发送 resp 的各段。
+   */
+  void SendFileBody(const std::shared_ptr<Response> &resp, size_t index,
+                    bool close);
+  void OnFlushFinish(bool close);
+  /**
+   * 根据连接的状态启动或取消 read_timer_：正在接收请求时使用头部超时，
+   * 没有待处理的请求时使用空闲超时，否则不计时。
+   */
+  void UpdateReadTimer();
+  void StartReadTimer(std::chrono::seconds timeout, bool idle);
+  void StartSendTimer();
+  void OnTimeout(const char *what);
   void OnRecv(const char *buf, size_t len);
   void HandleRecv(const char *buf, size_t len);
+  void HandleReq(const std::shared_ptr<Request> &req);
+  /**
+   * 解析器进入 kError 状态。in_head 表示出错时是否还在解析请求头部。
+   */
+  void OnParseError(bool in_head);
+  /**
+   * 接收请求体时出错，通知处理器并在响应之后关闭连接。响应已经发送完毕时
+   * 立即关闭连接。
+   */
+  void AbortBody(const std::exception_ptr &except);
+  /**
+   * 是否继续处理收到的数据。决定关闭连接后，仍然需要接收当前请求的请求体。
+   */
+  [[nodiscard]] bool Accepting() const {
+    return !closing_ || parser_.state() == RequestParser::State::kBody;
+  }
+  /**
+   * 已经决定关闭连接，并且没有还需要发送的响应和需要接收的数据。
+   */
+  [[nodiscard]] bool Drained() const {
+    return !Accepting() && pending_.empty() && !writing_;
+  }
 
   std::shared_ptr<Tcp> tcp_;
   std::shared_ptr<Router> router_;
   RequestParser parser_;
+  int keep_alive_requests_ = ServerConf::kDefaultKeepAliveRequests;
+  int nrequests_ = 0;
+  // 调用 uv_write 的次数。
+  int nsends_ = 0;
+  std::deque<std::shared_ptr<PendingResp>> pending_;
+  // 正在接收请求体的请求对应的响应。
+  std::shared_ptr<PendingResp> body_pending_;
+  bool writing_ = false;
+  // 正在处理收到的数据，OnRecv 结束时会统一调用 Flush。
+  bool receiving_ = false;
+  bool recv_paused_ = false;
+  // 已经决定关闭连接，忽略当前请求之后收到的数据。
+  bool closing_ = false;
+  // 已经收到当前请求的一部分。
+  bool in_request_ = false;
+  std::chrono::seconds header_timeout_;
+  std::chrono::seconds keep_alive_timeout_;
+  std::chrono::seconds send_timeout_;
+  WheelTimer read_timer_;
+  // read_timer_ 计时的是空闲超时而不是头部超时。
+  bool idle_ = false;
+  WheelTimer send_timer_;
 };
 
 }  // namespace ayaka
@@ -0,0 +1,93 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "encoding.hpp"
+
+#include "case.hpp"
+
+namespace ayaka {
+
+namespace {
+
+/**
+ * 编码对应的位，不支持的编码返回 0。
+ */
+uint8_t CodingBit(std::string_view coding) {
+  for (size_t i = 0; i < kEncodings; ++i) {
+    auto encoding = static_cast<Encoding>(i);
+    if (StrEqualIgnoreCase(coding, EncodingName(encoding))) {
+      return EncodingBit(encoding);
+    }
+  }
+  if (StrEqualIgnoreCase(coding, "x-gzip")) {
+    return EncodingBit(Encoding::kGzip);
+  }
+  return 0;
+}
+
+/**
+ * 参数中的 q 值是否为 0，例如 q=0、q=0.0 或者 q=0.000。
+ */
+bool ZeroQuality(std::string_view params) {
+  while (!params.empty()) {
+    auto semicolon = params.find(';');
+    auto param = TrimOws(params.substr(0, semicolon));
+    if (param.size() >= 2 && (param[0] == 'q' || param[0] == 'Q') &&
+        param[1] == '=') {
+      auto value = param.substr(2);
+      return !value.empty() && value[0] == '0' &&
+             value.find_first_not_of("0.", 1) == std::string_view::npos;
+    }
+    if (semicolon == std::string_view::npos) {
+      break;
+    }
+    params.remove_prefix(semicolon + 1);
+  }
+  return false;
+}
+
+}  // namespace
+
+uint8_t AcceptedEncodings(std::string_view accept_encoding) {
+  constexpr uint8_t kAll = (1U << kEncodings) - 1;
+  uint8_t accepted = 0;
+  uint8_t rejected = 0;
+  bool any = false;
+  while (!accept_encoding.empty()) {
+    auto comma = accept_encoding.find(',');
+    auto item = accept_encoding.substr(0, comma);
+    auto semicolon = item.find(';');
+    auto coding = TrimOws(item.substr(0, semicolon));
+    auto zero = semicolon != std::string_view::npos &&
+                ZeroQuality(item.substr(semicolon + 1));
+    if (coding == "*") {
+      any = !zero;
+    } else if (auto bit = CodingBit(coding)) {
+      (zero ? rejected : accepted) |= bit;
+    }
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    accept_encoding.remove_prefix(comma + 1);
+  }
+  if (any) {
+    accepted = kAll;
+  }
+  return static_cast<uint8_t>(accepted & ~rejected);
+}
+
+}  // namespace ayaka
@@ -0,0 +1,65 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef AYAKA_SRC_ENCODING_HPP_
+#define AYAKA_SRC_ENCODING_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace ayaka {
+
+/**
+ * 支持的内容编码，按照优先级从高到低排列。kIdentity 表示不编码。
+ */
+enum class Encoding : uint8_t { kBr, kZstd, kGzip, kIdentity };
+
+inline constexpr size_t kEncodings = static_cast<size_t>(Encoding::kIdentity);
+
+/**
+ * Content-Encoding 中的名称，kIdentity 返回空字符串。
+ */
+constexpr std::string_view EncodingName(Encoding encoding) {
+  constexpr std::array<std::string_view, kEncodings + 1> kNames = {
+      "br", "zstd", "gzip", ""};
+  return kNames[static_cast<size_t>(encoding)];
+}
+
+/**
+ * 预压缩文件的后缀，例如 foo.js 的 br 版本是 foo.js.br。
+ */
+constexpr std::string_view EncodingSuffix(Encoding encoding) {
+  constexpr std::array<std::string_view, kEncodings + 1> kSuffixes = {
+      ".br", ".zst", ".gz", ""};
+  return kSuffixes[static_cast<size_t>(encoding)];
+}
+
+constexpr uint8_t EncodingBit(Encoding encoding) {
+  return static_cast<uint8_t>(1U << static_cast<unsigned>(encoding));
+}
+
+/**
+ * 解析 Accept-Encoding，返回客户端接受的编码的位掩码（见 EncodingBit）。
+ * q=0 表示不接受，其他的 q 值被忽略，由服务器按照 Encoding 的顺序选择。
+ */
+[[nodiscard]] uint8_t AcceptedEncodings(std::string_view accept_encoding);
+
+}  // namespace ayaka
+
+#endif  // AYAKA_SRC_ENCODING_HPP_
@@ -0,0 +1,233 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+namespace ayaka {
+
+namespace {
+
+struct OpenReq {
+  uv_fs_t req{};
+  std::shared_ptr<File> file;
+  File::OnOpenCb on_open;
+};
+
+struct ReadReq {
+  uv_fs_t req{};
+  std::shared_ptr<File> file;
+  std::shared_ptr<std::vector<char>> content;
+  size_t nread = 0;
+  File::OnReadCb on_read;
+};
+
+}  // namespace
+
+File::File(File &&other) noexcept
+    : fd_(other.fd_),
+      size_(other.size_),
+      mtime_(other.mtime_),
+      ino_(other.ino_) {
+  other.fd_ = -1;
+}
+
+File &File::operator=(File &&other) noexcept {
+  if (this != &other) {
+    if (fd_ != -1) {
+      close(fd_);
+    }
+    fd_ = other.fd_;
+    size_ = other.size_;
+    mtime_ = other.mtime_;
+    ino_ = other.ino_;
+    other.fd_ = -1;
+  }
+  return *this;
+}
+
+File::~File() {
+  if (fd_ != -1) {
+    close(fd_);
+  }
+}
+
+std::shared_ptr<File> File::Open(const std::string &path) {
+  auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return nullptr;
+  }
+
+  auto file = std::make_shared<File>();
+  file->fd_ = fd;
+
+  struct stat st {};
+  if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)) {
+    return nullptr;
+  }
+  file->size_ = st.st_size;
+  file->mtime_ = st.st_mtime;
+  file->ino_ = st.st_ino;
+  return file;
+}
+
+std::shared_ptr<std::vector<char>> File::ReadAll() const {
+  auto content = std::make_shared<std::vector<char>>(size_);
+  size_t nread = 0;
+  while (nread < size_) {
+    auto ret = pread(fd_, content->data() + nread, size_ - nread,
+                     static_cast<off_t>(nread));
+    if (ret == -1 && errno == EINTR) {
+      continue;
+    }
+    if (ret <= 0) {
+      return nullptr;
+    }
+    nread += ret;
+  }
+  return content;
+}
+
+void File::OpenAsync(uv_loop_t *loop, const std::string &path,
+                     OnOpenCb on_open) {
+  auto *open_req = new OpenReq;
+  open_req->req.data = open_req;
+  open_req->on_open = std::move(on_open);
+  // libuv 会自动加上 O_CLOEXEC。
+  auto ret = uv_fs_open(loop, &open_req->req, path.c_str(), O_RDONLY, 0,
+                        UvOnOpen);
+  if (ret < 0) {
+    open_req->on_open(nullptr);
+    delete open_req;
+  }
+}
+
+void File::UvOnOpen(uv_fs_t *req) {
+  auto *open_req = static_cast<OpenReq *>(req->data);
+  auto fd = static_cast<int>(req->result);
+  uv_fs_req_cleanup(req);
+  if (fd < 0) {
+    open_req->on_open(nullptr);
+    delete open_req;
+    return;
+  }
+
+  open_req->file = std::make_shared<File>();
+  open_req->file->fd_ = fd;
+  if (uv_fs_fstat(req->loop, req, fd, UvOnFstat) < 0) {
+    open_req->on_open(nullptr);
+    delete open_req;
+  }
+}
+
+void File::UvOnFstat(uv_fs_t *req) {
+  auto *open_req = static_cast<OpenReq *>(req->data);
+  auto file = std::move(open_req->file);
+  if (req->result < 0 || !S_ISREG(req->statbuf.st_mode)) {
+    file = nullptr;
+  } else {
+    file->size_ = req->statbuf.st_size;
+    file->mtime_ = req->statbuf.st_mtim.tv_sec;
+    file->ino_ = req->statbuf.st_ino;
+  }
+  uv_fs_req_cleanup(req);
+  open_req->on_open(std::move(file));
+  delete open_req;
+}
+
+void File::ReadAllAsync(uv_loop_t *loop, std::shared_ptr<File> file,
+                        OnReadCb on_read) {
+  auto content = std::make_shared<std::vector<char>>(file->size());
+  if (content->empty()) {
+    on_read(std::move(content));
+    return;
+  }
+
+  auto *read_req = new ReadReq;
+  read_req->req.data = read_req;
+  read_req->file = std::move(file);
+  read_req->content = std::move(content);
+  read_req->on_read = std::move(on_read);
+  auto buf = uv_buf_init(read_req->content->data(),
+                         read_req->content->size());
+  if (uv_fs_read(loop, &read_req->req, read_req->file->fd(), &buf, 1, 0,
+                 UvOnRead) < 0) {
+    read_req->on_read(nullptr);
+    delete read_req;
+  }
+}
+
+void File::UvOnRead(uv_fs_t *req) {
+  auto *read_req = static_cast<ReadReq *>(req->data);
+  auto result = req->result;
+  uv_fs_req_cleanup(req);
+  // 读取失败，或者文件在打开后被截断。
+  if (result <= 0) {
+    read_req->on_read(nullptr);
+    delete read_req;
+    return;
+  }
+
+  read_req->nread += result;
+  auto &content = *read_req->content;
+  if (read_req->nread == content.size()) {
+    read_req->on_read(std::move(read_req->content));
+    delete read_req;
+    return;
+  }
+
+  auto buf = uv_buf_init(content.data() + read_req->nread,
+                         content.size() - read_req->nread);
+  if (uv_fs_read(req->loop, req, read_req->file->fd(), &buf, 1,
+                 static_cast<int64_t>(read_req->nread), UvOnRead) < 0) {
+    read_req->on_read(nullptr);
+    delete read_req;
+  }
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    munmap(const_cast<char *>(data_), size_);
+  }
+}
+
+std::shared_ptr<const MappedFile> MappedFile::Map(const File &file) {
+  if (file.size() == 0) {
+    return nullptr;
+  }
+  auto *data =
+      mmap(nullptr, file.size(), PROT_READ, MAP_SHARED, file.fd(), 0);
+  if (data == MAP_FAILED) {
+    return nullptr;
+  }
+  // 同一个映射会被反复发送，MADV_SEQUENTIAL 会让内核在访问之后尽快回收页面，
+  // 因此只请求提前读取。
+  madvise(data, file.size(), MADV_WILLNEED);
+
+  auto mapped = std::make_shared<MappedFile>();
+  mapped->data_ = static_cast<const char *>(data);
+  mapped->size_ = file.size();
+  return mapped;
+}
+
+}  // namespace ayaka
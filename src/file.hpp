@@ -0,0 +1,161 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef AYAKA_SRC_FILE_HPP_
+#define AYAKA_SRC_FILE_HPP_
+
+#include <sys/types.h>
+#include <uv.h>
+
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ayaka {
+
+/**
+ * 以只读方式打开的普通文件，析构时关闭文件描述符。
+ */
+class File {
+ public:
+  using OnOpenCb = std::function<void(std::shared_ptr<File>)>;
+  using OnReadCb = std::function<void(std::shared_ptr<std::vector<char>>)>;
+
+  File() = default;
+
+  /**
+   * File 只能移动，不能拷贝。
+   */
+  File(const File &) = delete;
+  File &operator=(const File &) = delete;
+
+  File(File &&other) noexcept;
+  File &operator=(File &&other) noexcept;
+
+  ~File();
+
+  [[nodiscard]] auto fd() const { return fd_; }
+  [[nodiscard]] auto size() const { return size_; }
+  [[nodiscard]] auto mtime() const { return mtime_; }
+  [[nodiscard]] auto ino() const { return ino_; }
+
+  /**
+   * 打开 path 指向的普通文件。如果文件不存在、不是普通文件或者无法打开，
+   * 返回 nullptr。
+   */
+  [[nodiscard]] static std::shared_ptr<File> Open(const std::string &path);
+
+  /**
+   * 将整个文件读入内存。读取失败或者文件在打开后被截断时返回 nullptr。
+   */
+  [[nodiscard]] std::shared_ptr<std::vector<char>> ReadAll() const;
+
+  /**
+   * 与 Open 相同，但是在 libuv 的线程池中打开文件，不阻塞事件循环。完成后在
+   * 事件循环线程中调用 on_open。
+   */
+  static void OpenAsync(uv_loop_t *loop, const std::string &path,
+                        OnOpenCb on_open);
+
+  /**
+   * 与 ReadAll 相同，但是在 libuv 的线程池中读取文件。完成后在事件循环线程中
+   * 调用 on_read。
+   */
+  static void ReadAllAsync(uv_loop_t *loop, std::shared_ptr<File> file,
+                           OnReadCb on_read);
+
+ private:
+  static void UvOnOpen(uv_fs_t *req);
+  static void UvOnFstat(uv_fs_t *req);
+  static void UvOnRead(uv_fs_t *req);
+
+  int fd_ = -1;
+  size_t size_ = 0;
+  time_t mtime_ = 0;
+  ino_t ino_ = 0;
+};
+
+/**
+ * 表示文件中 [offset, offset + length) 范围的内容，用作响应体时通过 sendfile
+ * 发送，不需要读入用户空间。
+ */
+class FileBody {
+ public:
+  FileBody() = default;
+
+  FileBody(std::shared_ptr<File> file, off_t offset, size_t length)
+      : file_(std::move(file)), offset_(offset), length_(length) {}
+
+  FileBody(const FileBody &) = default;
+  FileBody &operator=(const FileBody &) = default;
+  FileBody(FileBody &&) noexcept = default;
+  FileBody &operator=(FileBody &&) noexcept = default;
+  ~FileBody() = default;
+
+  [[nodiscard]] auto &file() const { return file_; }
+  [[nodiscard]] auto offset() const { return offset_; }
+  [[nodiscard]] auto length() const { return length_; }
+
+  [[nodiscard]] bool Empty() const { return !file_ || length_ == 0; }
+
+ private:
+  std::shared_ptr<File> file_;
+  off_t offset_ = 0;
+  size_t length_ = 0;
+};
+
+/**
+ * 整个文件在内存中的只读共享映射，析构时解除映射。用作响应体时，SendRespPack
+ * 直接发送映射的内存，不需要为每个响应分配缓冲区并复制文件内容。
+ *
+ * 文件在映射期间被原地截断时，访问超出新长度的部分会产生 SIGBUS，因此只应该
+ * 映射不会被原地修改的文件，例如通过重命名整体替换的静态资源。
+ */
+class MappedFile {
+ public:
+  MappedFile() = default;
+
+  /**
+   * MappedFile 不能被拷贝或移动。
+   */
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&) = delete;
+  MappedFile &operator=(MappedFile &&) = delete;
+
+  ~MappedFile();
+
+  [[nodiscard]] auto data() const { return data_; }
+  [[nodiscard]] auto size() const { return size_; }
+
+  /**
+   * 映射 file 的全部内容，并提示内核提前读取。文件为空或者映射失败时返回
+   * nullptr。
+   */
+  [[nodiscard]] static std::shared_ptr<const MappedFile> Map(const File &file);
+
+ private:
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+};
+
+}  // namespace ayaka
+
+#endif  // AYAKA_SRC_FILE_HPP_
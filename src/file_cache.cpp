@@ -0,0 +1,232 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "file_cache.hpp"
+
+#include <sys/stat.h>
+
+#include <atomic>
+#include <vector>
+
+#include "conditional.hpp"
+
+namespace ayaka {
+
+namespace {
+
+std::atomic<size_t> gLocalCapacity = FileCache::kDefaultCapacity;
+std::atomic<FileCache::Clock::rep> gLocalValid =
+    std::chrono::duration_cast<FileCache::Clock::duration>(
+        FileCache::kDefaultValid)
+        .count();
+std::atomic<size_t> gLocalMmapMaxFile = FileCache::kDefaultMmapMaxFile;
+
+/**
+ * 依次检查 files 中的文件，全部没有被修改时以 true 调用 done。
+ */
+struct StatReq {
+  uv_fs_t req{};
+  // 持有 files 中的文件。
+  std::shared_ptr<const CachedFile> cached;
+  std::vector<const CachedFile *> files;
+  size_t index = 0;
+  std::function<void(bool)> done;
+};
+
+bool Unchanged(const File &file, ino_t ino, off_t size, time_t mtime) {
+  return ino == file.ino() && static_cast<size_t>(size) == file.size() &&
+         mtime == file.mtime();
+}
+
+void UvOnStat(uv_fs_t *req);
+
+void StatNext(uv_loop_t *loop, StatReq *stat_req) {
+  const auto &path = stat_req->files[stat_req->index]->path();
+  if (uv_fs_stat(loop, &stat_req->req, path.c_str(), UvOnStat) < 0) {
+    stat_req->done(false);
+    delete stat_req;
+  }
+}
+
+void UvOnStat(uv_fs_t *req) {
+  auto *stat_req = static_cast<StatReq *>(req->data);
+  const auto &file = *stat_req->files[stat_req->index]->file();
+  auto unchanged =
+      req->result >= 0 &&
+      Unchanged(file, static_cast<ino_t>(req->statbuf.st_ino),
+                static_cast<off_t>(req->statbuf.st_size),
+                static_cast<time_t>(req->statbuf.st_mtim.tv_sec));
+  uv_fs_req_cleanup(req);
+  if (unchanged && ++stat_req->index < stat_req->files.size()) {
+    StatNext(req->loop, stat_req);
+    return;
+  }
+  stat_req->done(unchanged);
+  delete stat_req;
+}
+
+}  // namespace
+
+CachedFile::CachedFile(std::string path, std::shared_ptr<File> file,
+                       std::string mime)
+    : path_(std::move(path)), file_(std::move(file)), mime_(std::move(mime)) {
+  if (file_) {
+    etag_ = MakeETag(*file_);
+    last_modified_ = FormatHttpDate(file_->mtime());
+  }
+}
+
+CachedFile::CachedFile(std::string path, std::shared_ptr<File> file,
+                       std::string mime, Encoding encoding)
+    : CachedFile(std::move(path), std::move(file), std::move(mime)) {
+  encoding_ = encoding;
+  vary_ = true;
+}
+
+std::shared_ptr<const CachedFile> FileCache::Get(const std::string &key) {
+  auto iter = map_.find(key);
+  if (iter == map_.end()) {
+    ++nmisses_;
+    return nullptr;
+  }
+
+  auto node = iter->second;
+  auto now = Clock::now();
+  if (now - node->validated >= valid_) {
+    if (!Revalidate(*node->cached)) {
+      map_.erase(iter);
+      lru_.erase(node);
+      ++nmisses_;
+      return nullptr;
+    }
+    node->validated = now;
+  }
+
+  lru_.splice(lru_.begin(), lru_, node);
+  ++nhits_;
+  return node->cached;
+}
+
+void FileCache::GetAsync(uv_loop_t *loop, const std::string &key,
+                         OnGetCb on_get) {
+  auto iter = map_.find(key);
+  if (iter == map_.end()) {
+    ++nmisses_;
+    on_get(nullptr);
+    return;
+  }
+
+  auto node = iter->second;
+  if (Clock::now() - node->validated < valid_) {
+    lru_.splice(lru_.begin(), lru_, node);
+    ++nhits_;
+    on_get(node->cached);
+    return;
+  }
+
+  auto *stat_req = new StatReq;
+  stat_req->req.data = stat_req;
+  stat_req->cached = node->cached;
+  stat_req->files.push_back(node->cached.get());
+  for (size_t i = 0; i < kEncodings; ++i) {
+    const auto &variant = node->cached->variant(static_cast<Encoding>(i));
+    if (variant) {
+      stat_req->files.push_back(variant.get());
+    }
+  }
+  stat_req->done = [this, key, cached = node->cached,
+                    on_get = std::move(on_get)](bool unchanged) {
+    // 检查期间缓存项可能已经被替换或淘汰。
+    auto iter = map_.find(key);
+    auto current = iter != map_.end() && iter->second->cached == cached;
+    if (!unchanged) {
+      if (current) {
+        lru_.erase(iter->second);
+        map_.erase(iter);
+      }
+      ++nmisses_;
+      on_get(nullptr);
+      return;
+    }
+    if (current) {
+      iter->second->validated = Clock::now();
+      lru_.splice(lru_.begin(), lru_, iter->second);
+    }
+    ++nhits_;
+    on_get(cached);
+  };
+  StatNext(loop, stat_req);
+}
+
+void FileCache::Put(const std::string &key,
+                    std::shared_ptr<const CachedFile> cached) {
+  if (capacity_ == 0) {
+    return;
+  }
+
+  auto iter = map_.find(key);
+  if (iter != map_.end()) {
+    lru_.erase(iter->second);
+    map_.erase(iter);
+  }
+  while (lru_.size() >= capacity_) {
+    // 文件描述符在没有响应引用它之后才会关闭。
+    map_.erase(lru_.back().key);
+    lru_.pop_back();
+  }
+
+  lru_.push_front(Node{key, std::move(cached), Clock::now()});
+  map_[key] = lru_.begin();
+}
+
+void FileCache::Clear() {
+  map_.clear();
+  lru_.clear();
+}
+
+FileCache &FileCache::Local() {
+  thread_local FileCache cache(gLocalCapacity,
+                               Clock::duration(gLocalValid.load()),
+                               gLocalMmapMaxFile);
+  return cache;
+}
+
+void FileCache::SetLocalDefault(size_t capacity, Clock::duration valid,
+                                size_t mmap_max_file) {
+  gLocalCapacity = capacity;
+  gLocalValid = valid.count();
+  gLocalMmapMaxFile = mmap_max_file;
+}
+
+bool FileCache::Revalidate(const CachedFile &cached) {
+  struct stat st {};
+  if (stat(cached.path().c_str(), &st) == -1) {
+    return false;
+  }
+  if (!Unchanged(*cached.file(), st.st_ino, st.st_size, st.st_mtime)) {
+    return false;
+  }
+  for (size_t i = 0; i < kEncodings; ++i) {
+    const auto &variant = cached.variant(static_cast<Encoding>(i));
+    if (variant && !Revalidate(*variant)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace ayaka
@@ -0,0 +1,206 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef AYAKA_SRC_FILE_CACHE_HPP_
+#define AYAKA_SRC_FILE_CACHE_HPP_
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "encoding.hpp"
+#include "file.hpp"
+
+namespace ayaka {
+
+/**
+ * FileCache 中缓存的已打开文件，同时缓存由文件生成的 ETag 和 Last-Modified，
+ * 不需要为每个请求重新格式化。
+ *
+ * 文件可以有预压缩的变体，例如 foo.js 旁边的 foo.js.br。变体在创建缓存项时
+ * 打开，与原文件一起缓存，之后的请求不需要再检查变体是否存在。
+ */
+class CachedFile {
+ public:
+  CachedFile() = default;
+
+  /**
+   * path 是文件实际的路径，例如请求目录时对应的 index.html。
+   */
+  CachedFile(std::string path, std::shared_ptr<File> file, std::string mime);
+
+  /**
+   * 使用 encoding 编码的变体，mime 与原文件相同。
+   */
+  CachedFile(std::string path, std::shared_ptr<File> file, std::string mime,
+             Encoding encoding);
+
+  CachedFile(const CachedFile &) = default;
+  CachedFile &operator=(const CachedFile &) = default;
+  CachedFile(CachedFile &&) noexcept = default;
+  CachedFile &operator=(CachedFile &&) noexcept = default;
+  ~CachedFile() = default;
+
+  [[nodiscard]] auto &path() const { return path_; }
+  [[nodiscard]] auto &file() const { return file_; }
+  [[nodiscard]] auto &mime() const { return mime_; }
+  [[nodiscard]] auto &etag() const { return etag_; }
+  [[nodiscard]] auto &last_modified() const { return last_modified_; }
+  [[nodiscard]] auto encoding() const { return encoding_; }
+  /**
+   * 文件在内存中的映射，没有映射时为 nullptr。
+   */
+  [[nodiscard]] auto &mapped() const { return mapped_; }
+  /**
+   * 有变体的文件及其变体的响应都需要 Vary: Accept-Encoding。
+   */
+  [[nodiscard]] auto vary() const { return vary_; }
+
+  [[nodiscard]] auto &variant(Encoding encoding) const {
+    return variants_[static_cast<size_t>(encoding)];
+  }
+  void set_variant(Encoding encoding,
+                   std::shared_ptr<const CachedFile> variant) {
+    variants_[static_cast<size_t>(encoding)] = std::move(variant);
+    vary_ = true;
+  }
+
+  /**
+   * 把文件映射到内存，应该在放入 FileCache 之前调用。映射由缓存项持有，所有
+   * 响应共享，缓存项被淘汰并且没有响应引用时解除映射。
+   */
+  void Map() { mapped_ = MappedFile::Map(*file_); }
+
+ private:
+  std::string path_;
+  std::shared_ptr<File> file_;
+  std::string mime_;
+  std::string etag_;
+  std::string last_modified_;
+  std::shared_ptr<const MappedFile> mapped_;
+  Encoding encoding_ = Encoding::kIdentity;
+  bool vary_ = false;
+  std::array<std::shared_ptr<const CachedFile>, kEncodings> variants_;
+};
+
+/**
+ * 已打开文件的缓存，按照 LRU 淘汰，最多缓存 capacity 个文件。capacity 为 0
+ * 时禁用缓存。
+ *
+ * 在有效期 valid 内，缓存项不经任何系统调用直接返回；超过有效期后，使用 stat
+ * 检查文件及其变体是否被修改（inode、大小或修改时间变化）或删除。Get 在调用
+ * 线程中同步检查，GetAsync 在 libuv 的线程池中检查。
+ *
+ * 不超过 mmap_max_file 字节的文件可以映射到内存（见 CachedFile::Map），
+ * mmap_max_file 为 0 时不映射。
+ *
+ * 因为实现原因，FileCache 对象只能在同一个线程中使用。
+ */
+class FileCache {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using OnGetCb = std::function<void(std::shared_ptr<const CachedFile>)>;
+
+  FileCache() = default;
+
+  FileCache(size_t capacity, Clock::duration valid, size_t mmap_max_file = 0)
+      : capacity_(capacity), valid_(valid), mmap_max_file_(mmap_max_file) {}
+
+  /**
+   * FileCache 不能被拷贝或移动。
+   */
+  FileCache(const FileCache &) = delete;
+  FileCache &operator=(const FileCache &) = delete;
+  FileCache(FileCache &&) = delete;
+  FileCache &operator=(FileCache &&) = delete;
+
+  ~FileCache() = default;
+
+  [[nodiscard]] auto capacity() const { return capacity_; }
+  [[nodiscard]] auto valid() const { return valid_; }
+  [[nodiscard]] auto mmap_max_file() const { return mmap_max_file_; }
+  [[nodiscard]] auto Size() const { return lru_.size(); }
+  [[nodiscard]] auto nhits() const { return nhits_; }
+  [[nodiscard]] auto nmisses() const { return nmisses_; }
+
+  /**
+   * 返回 key 对应的缓存项。如果没有缓存或者文件已经被修改，返回 nullptr。
+   */
+  [[nodiscard]] std::shared_ptr<const CachedFile> Get(const std::string &key);
+
+  /**
+   * 与 Get 相同，但是超过有效期的缓存项在 libuv 的线程池中检查，不阻塞事件
+   * 循环。完成后在事件循环线程中调用 on_get，不需要检查时在返回之前调用。
+   */
+  void GetAsync(uv_loop_t *loop, const std::string &key, OnGetCb on_get);
+
+  /**
+   * 是否应该映射 file。禁用缓存时映射无法在请求之间共享，因此不映射。
+   */
+  [[nodiscard]] bool Mappable(const File &file) const {
+    return capacity_ > 0 && file.size() > 0 && file.size() <= mmap_max_file_;
+  }
+
+  void Put(const std::string &key, std::shared_ptr<const CachedFile> cached);
+
+  void Clear();
+
+  /**
+   * 当前线程的 FileCache。每个工作线程有自己的缓存，因此不需要加锁。
+   */
+  static FileCache &Local();
+
+  /**
+   * 设置之后创建的线程局部 FileCache 的参数，应该在工作线程启动之前调用。
+   */
+  static void SetLocalDefault(size_t capacity, Clock::duration valid,
+                              size_t mmap_max_file);
+
+  static constexpr size_t kDefaultCapacity = 1024;
+  static constexpr auto kDefaultValid = std::chrono::seconds(10);
+  static constexpr size_t kDefaultMmapMaxFile = 0;
+
+ private:
+  struct Node {
+    std::string key;
+    std::shared_ptr<const CachedFile> cached;
+    // 上一次确认文件没有被修改的时间。
+    Clock::time_point validated;
+  };
+
+  /**
+   * 文件没有被修改时返回 true。
+   */
+  [[nodiscard]] static bool Revalidate(const CachedFile &cached);
+
+  size_t capacity_ = kDefaultCapacity;
+  Clock::duration valid_ = kDefaultValid;
+  size_t mmap_max_file_ = kDefaultMmapMaxFile;
+  // 最近使用的缓存项位于链表头部。
+  std::list<Node> lru_;
+  std::unordered_map<std::string, std::list<Node>::iterator> map_;
+  size_t nhits_ = 0;
+  size_t nmisses_ = 0;
+};
+
+}  // namespace ayaka
+
+#endif  // AYAKA_SRC_FILE_CACHE_HPP_
@@ -0,0 +1,107 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "headers.hpp"
+
+namespace ayaka {
+
+namespace {
+
+constexpr std::array<std::string_view, kKnownHeaders> kHeaderNames = {
+    "Accept",
+    "Accept-Encoding",
+    "Accept-Ranges",
+    "Cache-Control",
+    "Connection",
+    "Content-Encoding",
+    "Content-Length",
+    "Content-Range",
+    "Content-Type",
+    "Date",
+    "ETag",
+    "Expect",
+    "Host",
+    "If-Match",
+    "If-Modified-Since",
+    "If-None-Match",
+    "If-Range",
+    "If-Unmodified-Since",
+    "Last-Modified",
+    "Range",
+    "Server",
+    "Transfer-Encoding",
+    "User-Agent",
+    "Vary",
+};
+
+constexpr size_t kHashSize = 64;
+
+/**
+ * 只用到长度、首字符和尾字符，系数是离线搜索出的、对 kHeaderNames 没有
+ * 冲突的一组值。c | 0x20 对字母来说就是转为小写，其他字符的结果不影响
+ * 正确性，因为命中之后还要比较完整的名称。
+ */
+constexpr size_t HeaderHash(std::string_view name) {
+  size_t first = static_cast<unsigned char>(name.front()) | 0x20U;
+  size_t last = static_cast<unsigned char>(name.back()) | 0x20U;
+  return (name.size() + 13 * first + 4 * last) % kHashSize;
+}
+
+constexpr auto kHeaderTable = [] {
+  std::array<Header, kHashSize> table{};
+  for (auto& header : table) {
+    header = Header::kUnknown;
+  }
+  for (size_t i = 0; i < kKnownHeaders; ++i) {
+    table[HeaderHash(kHeaderNames[i])] = static_cast<Header>(i);
+  }
+  return table;
+}();
+
+constexpr bool IsPerfect() {
+  for (size_t i = 0; i < kKnownHeaders; ++i) {
+    if (kHeaderTable[HeaderHash(kHeaderNames[i])] != static_cast<Header>(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static_assert(IsPerfect(), "HeaderHash has collisions");
+
+}  // namespace
+
+Header LookupHeader(std::string_view name) {
+  if (name.empty()) {
+    return Header::kUnknown;
+  }
+  auto header = kHeaderTable[HeaderHash(name)];
+  if (header != Header::kUnknown &&
+      StrEqualIgnoreCase(kHeaderNames[static_cast<size_t>(header)], name)) {
+    return header;
+  }
+  return Header::kUnknown;
+}
+
+std::string_view HeaderName(Header header) {
+  if (header == Header::kUnknown) {
+    return {};
+  }
+  return kHeaderNames[static_cast<size_t>(header)];
+}
+
+}  // namespace ayaka
@@ -0,0 +1,205 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef AYAKA_SRC_HEADERS_HPP_
+#define AYAKA_SRC_HEADERS_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "case.hpp"
+#include "error.hpp"
+
+namespace ayaka {
+
+/**
+ * 常用的 HTTP 头部，按名称的字典序排列。
+ */
+enum class Header : uint8_t {
+  kAccept,
+  kAcceptEncoding,
+  kAcceptRanges,
+  kCacheControl,
+  kConnection,
+  kContentEncoding,
+  kContentLength,
+  kContentRange,
+  kContentType,
+  kDate,
+  kETag,
+  kExpect,
+  kHost,
+  kIfMatch,
+  kIfModifiedSince,
+  kIfNoneMatch,
+  kIfRange,
+  kIfUnmodifiedSince,
+  kLastModified,
+  kRange,
+  kServer,
+  kTransferEncoding,
+  kUserAgent,
+  kVary,
+  kUnknown
+};
+
+inline constexpr size_t kKnownHeaders = static_cast<size_t>(Header::kUnknown);
+
+/**
+ * 使用完美哈希查找常用头部，忽略大小写，不是常用头部时返回 kUnknown。
+ */
+[[nodiscard]] Header LookupHeader(std::string_view name);
+
+/**
+ * 常用头部的规范名称，例如 Content-Length。
+ */
+[[nodiscard]] std::string_view HeaderName(Header header);
+
+/**
+ * 名称不区分大小写的 HTTP 头部。常用头部保存在以 Header 为下标的固定位置，
+ * 其余头部按插入顺序保存在 others_ 中。T 是 std::string_view 或者
+ * std::string，同时用作名称和值的类型。
+ */
+template <typename T>
+class BasicHeaders {
+ public:
+  BasicHeaders() = default;
+  BasicHeaders(const BasicHeaders&) = default;
+  BasicHeaders& operator=(const BasicHeaders&) = default;
+  BasicHeaders(BasicHeaders&&) noexcept = default;
+  BasicHeaders& operator=(BasicHeaders&&) noexcept = default;
+  ~BasicHeaders() = default;
+
+  [[nodiscard]] size_t size() const {
+    return __builtin_popcount(present_) + others_.size();
+  }
+  [[nodiscard]] bool empty() const { return present_ == 0 && others_.empty(); }
+  void clear() {
+    for (size_t i = 0; i < kKnownHeaders; ++i) {
+      known_[i] = T();
+    }
+    present_ = 0;
+    others_.clear();
+  }
+  /**
+   * 与 others_ 的 reserve 相同，预留非常用头部的空间。
+   */
+  void reserve(size_t n) { others_.reserve(n); }
+
+  /**
+   * 不存在时返回 nullptr。
+   */
+  [[nodiscard]] const T* Find(Header header) const {
+    return Has(header) ? &known_[Index(header)] : nullptr;
+  }
+  [[nodiscard]] const T* Find(std::string_view name) const {
+    auto header = LookupHeader(name);
+    if (header != Header::kUnknown) {
+      return Find(header);
+    }
+    for (const auto& [other_name, value] : others_) {
+      if (StrEqualIgnoreCase(other_name, name)) {
+        return &value;
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * 不存在时抛出 std::out_of_range。
+   */
+  [[nodiscard]] const T& at(std::string_view name) const {
+    const auto* value = Find(name);
+    if (value == nullptr) {
+      throw std::out_of_range("no such header");
+    }
+    return *value;
+  }
+
+  /**
+   * 不存在时插入空值。
+   */
+  T& operator[](Header header) {
+    AYAKA_TERM_IF(header == Header::kUnknown, "unknown header");
+    present_ |= Bit(header);
+    return known_[Index(header)];
+  }
+  T& operator[](std::string_view name) {
+    auto header = LookupHeader(name);
+    if (header != Header::kUnknown) {
+      return (*this)[header];
+    }
+    for (auto& [other_name, value] : others_) {
+      if (StrEqualIgnoreCase(other_name, name)) {
+        return value;
+      }
+    }
+    return others_.emplace_back(T(name), T()).second;
+  }
+
+  void Erase(Header header) {
+    if (header == Header::kUnknown) {
+      return;
+    }
+    present_ &= ~Bit(header);
+    known_[Index(header)] = T();
+  }
+
+  /**
+   * 依次以名称和值调用 fn，常用头部使用规范名称，排在其余头部之前。
+   */
+  template <typename Fn>
+  void ForEach(Fn&& fn) const {
+    for (size_t i = 0; i < kKnownHeaders; ++i) {
+      if ((present_ & (uint32_t{1} << i)) != 0) {
+        fn(HeaderName(static_cast<Header>(i)), known_[i]);
+      }
+    }
+    for (const auto& [name, value] : others_) {
+      fn(std::string_view(name), value);
+    }
+  }
+
+ private:
+  static_assert(kKnownHeaders <= 32, "present_ has 32 bits");
+
+  static size_t Index(Header header) { return static_cast<size_t>(header); }
+  static uint32_t Bit(Header header) { return uint32_t{1} << Index(header); }
+  [[nodiscard]] bool Has(Header header) const {
+    return header != Header::kUnknown && (present_ & Bit(header)) != 0;
+  }
+
+  std::array<T, kKnownHeaders> known_{};
+  uint32_t present_ = 0;
+  std::vector<std::pair<T, T>> others_;
+};
+
+/**
+ * 请求头部指向请求持有的数据，见 Request。
+ */
+using Headers = BasicHeaders<std::string_view>;
+using ResponseHeaders = BasicHeaders<std::string>;
+
+}  // namespace ayaka
+
+#endif  // AYAKA_SRC_HEADERS_HPP_
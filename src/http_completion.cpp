@@ -0,0 +1,73 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "http_completion.hpp"
+
+#include <utility>
+
+#include "http_except.hpp"
+
+namespace ayaka {
+
+HttpCompletion::HttpCompletion(std::shared_ptr<Loop> loop,
+                               std::shared_ptr<Request> req,
+                               std::shared_ptr<Response> resp, DoneCb done)
+    : state_(std::make_shared<State>()) {
+  state_->loop = std::move(loop);
+  state_->req = std::move(req);
+  state_->resp = std::move(resp);
+  state_->done = std::move(done);
+}
+
+void HttpCompletion::Finish() const {
+  if (Done()) {
+    return;
+  }
+  auto done = std::move(state_->done);
+  state_->done = nullptr;
+  done(nullptr);
+}
+
+void HttpCompletion::Fail(std::exception_ptr except) const {
+  if (Done()) {
+    return;
+  }
+  auto done = std::move(state_->done);
+  state_->done = nullptr;
+  done(std::move(except));
+}
+
+void HttpCompletion::Fail(HttpError error) const {
+  if (Done()) {
+    return;
+  }
+  state_->resp->Reset();
+  SetUpError(*state_->resp, error);
+  Finish();
+}
+
+HttpCompletion::State::~State() {
+  if (done) {
+    AYAKA_LOG_ERROR("{} {} was dropped without a response", req->method(),
+                    req->url().src());
+    resp->Reset();
+    SetUpError(*resp, HttpError::kInternalServerError);
+    done(nullptr);
+  }
+}
+
+}  // namespace ayaka
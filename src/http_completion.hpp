@@ -0,0 +1,104 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef AYAKA_SRC_HTTP_COMPLETION_HPP_
+#define AYAKA_SRC_HTTP_COMPLETION_HPP_
+
+#include <exception>
+#include <functional>
+#include <memory>
+
+#include "http_except.hpp"
+#include "loop.hpp"
+#include "request.hpp"
+#include "response.hpp"
+
+namespace ayaka {
+
+/**
+ * 异步处理请求时的完成对象。HttpHandler 填充 resp() 之后调用 Finish，或者调用
+ * Fail 返回错误响应，两者都可以在之后的事件循环迭代中调用。返回 4xx 等常见
+ * 错误时应该使用 Fail(HttpError)，它不需要创建异常对象。
+ *
+ * HttpCompletion 的副本共享同一个状态，只有第一次 Finish 或 Fail 有效。如果
+ * 所有副本都被销毁时仍未完成，视为处理失败，返回 500 响应。
+ *
+ * 因为实现原因，HttpCompletion 只能在 loop() 的线程中使用。
+ */
+class HttpCompletion {
+ public:
+  /**
+   * 完成时调用。处理失败时参数为失败的原因，否则为 nullptr。
+   */
+  using DoneCb = std::function<void(std::exception_ptr)>;
+
+  HttpCompletion() = default;
+
+  HttpCompletion(std::shared_ptr<Loop> loop, std::shared_ptr<Request> req,
+                 std::shared_ptr<Response> resp, DoneCb done);
+
+  HttpCompletion(const HttpCompletion &) = default;
+  HttpCompletion &operator=(const HttpCompletion &) = default;
+  HttpCompletion(HttpCompletion &&) noexcept = default;
+  HttpCompletion &operator=(HttpCompletion &&) noexcept = default;
+  ~HttpCompletion() = default;
+
+  [[nodiscard]] auto &loop() const { return state_->loop; }
+  [[nodiscard]] auto &req() const { return state_->req; }
+  [[nodiscard]] auto &resp() const { return state_->resp; }
+
+  [[nodiscard]] bool Done() const { return !state_ || !state_->done; }
+
+  void Finish() const;
+
+  /**
+   * except 为 HttpExcept 时使用其设置响应，否则返回 500 响应。
+   */
+  void Fail(std::exception_ptr except) const;
+
+  /**
+   * 不使用异常的错误路径：把 resp() 重置后设置为 error 对应的错误响应，然后
+   * 正常完成。
+   */
+  void Fail(HttpError error) const;
+
+  template <typename Except>
+  void Fail(const Except &except) const {
+    Fail(std::make_exception_ptr(except));
+  }
+
+ private:
+  struct State {
+    State() = default;
+    State(const State &) = delete;
+    State &operator=(const State &) = delete;
+    State(State &&) = delete;
+    State &operator=(State &&) = delete;
+    ~State();
+
+    std::shared_ptr<Loop> loop;
+    std::shared_ptr<Request> req;
+    std::shared_ptr<Response> resp;
+    DoneCb done;
+  };
+
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace ayaka
+
+#endif  // AYAKA_SRC_HTTP_COMPLETION_HPP_
@@ -0,0 +1,148 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <memory>
+#include <string_view>
+
+#include "http_except.hpp"
+
+namespace ayaka {
+
+namespace {
+
+Response::Body MakeBody(std::string_view html) {
+  return std::make_shared<std::vector<char>>(html.begin(), html.end());
+}
+
+// 错误页面在启动时生成一次，由所有错误响应共享，不能被修改。
+const Response::Body kBody400 = MakeBody(R"(<!DOCTYPE html>
+<html>
+
+<head>
+    <meta charset="utf-8">
+    <title>400 Bad Request</title>
+</head>
+
+<body>
+    <h1>400 Bad Request</h1>
+    <h2>Ayaka 0.0.0</h2>
+    <p>Your browser (or proxy) sent a request that this server could not understand.</p>
+</body>
+
+</html>
+)");
+const Response::Body kBody404 = MakeBody(R"(<!DOCTYPE html>
+<html>
+
+<head>
+    <meta charset="utf-8">
+    <title>404 Not Found</title>
+</head>
+
+<body>
+    <h1>404 Not Found</h1>
+    <h2>Ayaka 0.0.0</h2>
+    <p>The requested URL was not found on this server.</p>
+</body>
+
+</html>
+)");
+const Response::Body kBody405 = MakeBody(R"(<!DOCTYPE html>
+<html>
+
+<head>
+    <meta charset="utf-8">
+    <title>405 Method Not Allowed</title>
+</head>
+
+<body>
+    <h1>405 Method Not Allowed</h1>
+    <h2>Ayaka 0.0.0</h2>
+    <p>The method is not allowed for the requested URL.</p>
+</body>
+
+</html>
+)");
+const Response::Body kBody413 = MakeBody(R"(<!DOCTYPE html>
+<html>
+
+<head>
+    <meta charset="utf-8">
+    <title>413 Payload Too Large</title>
+</head>
+
+<body>
+    <h1>413 Payload Too Large</h1>
+    <h2>Ayaka 0.0.0</h2>
+    <p>The request body is larger than the server is willing to process.</p>
+</body>
+
+</html>
+)");
+const Response::Body kBody500 = MakeBody(R"(<!DOCTYPE html>
+<html>
+
+<head>
+    <meta charset="utf-8">
+    <title>500 Internal Server Error</title>
+</head>
+
+<body>
+    <h1>500 Internal Server Error</h1>
+    <h2>Ayaka 0.0.0</h2>
+    <p>The server encountered an internal error.</p>
+</body>
+
+</html>
+)");
+
+}  // namespace
+
+void SetUpError(Response& resp, HttpError error) {
+  const StatusLine* line = nullptr;
+  const Response::Body* body = nullptr;
+  switch (error) {
+    case HttpError::kBadRequest:
+      line = &kStatusBadRequest;
+      body = &kBody400;
+      break;
+    case HttpError::kNotFound:
+      line = &kStatusNotFound;
+      body = &kBody404;
+      break;
+    case HttpError::kMethodNotAllowed:
+      line = &kStatusMethodNotAllowed;
+      body = &kBody405;
+      break;
+    case HttpError::kPayloadTooLarge:
+      line = &kStatusPayloadTooLarge;
+      body = &kBody413;
+      break;
+    case HttpError::kNone:
+      AYAKA_LOG_ERROR("SetUpError() with HttpError::kNone");
+      [[fallthrough]];
+    case HttpError::kInternalServerError:
+      line = &kStatusInternalServerError;
+      body = &kBody500;
+      break;
+  }
+  resp.set_status(HttpStatus(*line));
+  resp.headers()[Header::kContentType] = "text/html";
+  resp.set_body(*body);
+}
+
+}  // namespace ayaka
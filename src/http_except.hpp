@@ -18,15 +18,40 @@
 #ifndef AYAKA_SRC_HTTP_EXCEPT_HPP_
 #define AYAKA_SRC_HTTP_EXCEPT_HPP_
 
+#include <cstdint>
 #include <exception>
 #include <memory>
 #include <stdexcept>
+#include <string_view>
 
 #include "logger.hpp"
 #include "response.hpp"
 
 namespace ayaka {
 
+/**
+ * 不使用异常的错误结果。解析器、路由和处理器通过它返回 4xx、5xx 错误，
+ * 不会抛出异常，kNone 表示没有错误。
+ */
+enum class HttpError : uint8_t {
+  kNone,
+  kBadRequest,
+  kNotFound,
+  kMethodNotAllowed,
+  kPayloadTooLarge,
+  kInternalServerError
+};
+
+/**
+ * 设置 error 对应的状态、Content-Type 和共享的错误页面，不会复制错误页面。
+ * error 不能是 kNone。
+ */
+void SetUpError(Response& resp, HttpError error);
+
+/**
+ * HttpExcept 及其子类是兼容层：仍然可以抛出它们或者传给 HttpCompletion::Fail，
+ * 但是服务器内部的错误路径都使用 HttpError。
+ */
 class HttpExcept : std::exception {
  public:
   HttpExcept() = default;
@@ -57,12 +82,14 @@ class Http400Except : public HttpExcept {
   Http400Except& operator=(Http400Except&&) noexcept = default;
   ~Http400Except() override = default;
 
-  void SetUp(std::shared_ptr<Response> resp) const override;
+  void SetUp(std::shared_ptr<Response> resp) const override {
+    SetUpError(*resp, HttpError::kBadRequest);
+  }
 };
 
 class Http404Except : public HttpExcept {
  public:
-  Http404Except(const std::string& method, const std::string& url) {
+  Http404Except(std::string_view method, const std::string& url) {
     AYAKA_LOG_INFO("{} {} 404", method, url);
   }
   Http404Except(const Http404Except&) = default;
@@ -71,12 +98,14 @@ class Http404Except : public HttpExcept {
   Http404Except& operator=(Http404Except&&) noexcept = default;
   ~Http404Except() override = default;
 
-  void SetUp(std::shared_ptr<Response> resp) const override;
+  void SetUp(std::shared_ptr<Response> resp) const override {
+    SetUpError(*resp, HttpError::kNotFound);
+  }
 };
 
 class Http405Except : public HttpExcept {
  public:
-  Http405Except(const std::string& method, const std::string& url) {
+  Http405Except(std::string_view method, const std::string& url) {
     AYAKA_LOG_INFO("{} {} 405", method, url);
   }
   Http405Except(const Http405Except&) = default;
@@ -85,7 +114,43 @@ class Http405Except : public HttpExcept {
   Http405Except& operator=(Http405Except&&) noexcept = default;
   ~Http405Except() override = default;
 
-  void SetUp(std::shared_ptr<Response> resp) const override;
+  void SetUp(std::shared_ptr<Response> resp) const override {
+    SetUpError(*resp, HttpError::kMethodNotAllowed);
+  }
+};
+
+/**
+ * 请求体超过了 ServerConf::max_body_size()。
+ */
+class Http413Except : public HttpExcept {
+ public:
+  Http413Except() { AYAKA_LOG_INFO("413 Payload Too Large"); }
+
+  Http413Except(const Http413Except&) = default;
+  Http413Except& operator=(const Http413Except&) = default;
+  Http413Except(Http413Except&&) noexcept = default;
+  Http413Except& operator=(Http413Except&&) noexcept = default;
+  ~Http413Except() override = default;
+
+  void SetUp(std::shared_ptr<Response> resp) const override {
+    SetUpError(*resp, HttpError::kPayloadTooLarge);
+  }
+};
+
+class Http500Except : public HttpExcept {
+ public:
+  Http500Except(std::string_view method, const std::string& url) {
+    AYAKA_LOG_INFO("{} {} 500", method, url);
+  }
+  Http500Except(const Http500Except&) = default;
+  Http500Except& operator=(const Http500Except&) = default;
+  Http500Except(Http500Except&&) noexcept = default;
+  Http500Except& operator=(Http500Except&&) noexcept = default;
+  ~Http500Except() override = default;
+
+  void SetUp(std::shared_ptr<Response> resp) const override {
+    SetUpError(*resp, HttpError::kInternalServerError);
+  }
 };
 
 }  // namespace ayaka
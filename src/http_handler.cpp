@@ -17,31 +17,57 @@
 
 #include "http_handler.hpp"
 
+#include <array>
+
 namespace ayaka {
 
 void HttpHandler::Handle(const std::shared_ptr<Request> &req,
                          std::shared_ptr<Response> &resp) {
-  if (req->method() == http_method::kGet) {
-    DoGet(req, resp);
-  } else if (req->method() == http_method::kPost) {
-    DoPost(req, resp);
-  } else if (req->method() == http_method::kPut) {
-    DoPut(req, resp);
-  } else if (req->method() == http_method::kDelete) {
-    DoDelete(req, resp);
-  } else if (req->method() == http_method::kHead) {
-    DoHead(req, resp);
-  } else if (req->method() == http_method::kOptions) {
-    DoOptions(req, resp);
-  } else if (req->method() == http_method::kConnect) {
-    DoConnect(req, resp);
-  } else if (req->method() == http_method::kTrace) {
-    DoTrace(req, resp);
-  } else if (req->method() == http_method::kPatch) {
-    DoPatch(req, resp);
-  } else {
-    throw Http405Except(req->method(), req->url().src());
+  using DoFn = void (HttpHandler::*)(const std::shared_ptr<Request> &,
+                                     std::shared_ptr<Response> &);
+  // 按 HttpMethod 的顺序排列。
+  static constexpr std::array<DoFn, kKnownMethods> kDoFns = {
+      &HttpHandler::DoGet,     &HttpHandler::DoPost,    &HttpHandler::DoPut,
+      &HttpHandler::DoDelete,  &HttpHandler::DoHead,    &HttpHandler::DoOptions,
+      &HttpHandler::DoConnect, &HttpHandler::DoTrace,   &HttpHandler::DoPatch};
+  auto method = static_cast<size_t>(req->method_id());
+  if (method >= kKnownMethods) {
+    SetUpError(*resp, HttpError::kMethodNotAllowed);
+    return;
+  }
+  (this->*kDoFns[method])(req, resp);
+}
+
+void HttpHandler::HandleAsync(const std::shared_ptr<Request> &req,
+                              HttpCompletion completion) {
+  if (req->body().done()) {
+    HandleSync(req, completion);
+    return;
+  }
+  req->body().ReadAll(
+      [this, req, completion](std::exception_ptr except) mutable {
+        if (except) {
+          completion.Fail(except);
+          return;
+        }
+        HandleSync(req, completion);
+      });
+}
+
+void HttpHandler::HandleSync(const std::shared_ptr<Request> &req,
+                             HttpCompletion &completion) {
+  // Handle 可能会替换 resp 指向的对象。
+  auto resp = completion.resp();
+  try {
+    Handle(req, resp);
+  } catch (const HttpExcept &except) {
+    completion.Fail(std::current_exception());
+    return;
+  }
+  if (resp != completion.resp()) {
+    *completion.resp() = *resp;
   }
+  completion.Finish();
 }
 
 }  // namespace ayaka
@@ -20,6 +20,7 @@
 
 #include <memory>
 
+#include "http_completion.hpp"
 #include "http_except.hpp"
 #include "request.hpp"
 #include "response.hpp"
@@ -38,49 +39,69 @@ class HttpHandler {
   virtual void Handle(const std::shared_ptr<Request>& req,
                       std::shared_ptr<Response>& resp);
 
-  virtual void DoGet(const std::shared_ptr<Request>& req,
-                     [[maybe_unused]] std::shared_ptr<Response>& resp) {
-    throw Http405Except(req->method(), req->url().src());
+  /**
+   * 异步处理请求。可以保存 completion，在之后的事件循环迭代中填充
+   * completion.resp() 并调用 Finish 或 Fail，从而不阻塞工作线程。
+   *
+   * 默认实现是同步 Handle 的适配器：等待完整的请求体之后调用 Handle，然后立即
+   * 完成。只重写 DoGet 等函数的 HttpHandler 不需要任何修改，可以通过
+   * req->body().content() 读取请求体。HttpHandler 需要比连接存活得更久。
+   */
+  virtual void HandleAsync(const std::shared_ptr<Request>& req,
+                           HttpCompletion completion);
+
+  /**
+   * 调用 Handle 并完成 completion。
+   */
+  void HandleSync(const std::shared_ptr<Request>& req,
+                  HttpCompletion& completion);
+
+  /**
+   * 默认在 resp 上生成 405 响应，不抛出异常。
+   */
+  virtual void DoGet([[maybe_unused]] const std::shared_ptr<Request>& req,
+                     std::shared_ptr<Response>& resp) {
+    SetUpError(*resp, HttpError::kMethodNotAllowed);
   }
 
-  virtual void DoPost(const std::shared_ptr<Request>& req,
-                      [[maybe_unused]] std::shared_ptr<Response>& resp) {
-    throw Http405Except(req->method(), req->url().src());
+  virtual void DoPost([[maybe_unused]] const std::shared_ptr<Request>& req,
+                      std::shared_ptr<Response>& resp) {
+    SetUpError(*resp, HttpError::kMethodNotAllowed);
   }
 
-  virtual void DoPut(const std::shared_ptr<Request>& req,
-                     [[maybe_unused]] std::shared_ptr<Response>& resp) {
-    throw Http405Except(req->method(), req->url().src());
+  virtual void DoPut([[maybe_unused]] const std::shared_ptr<Request>& req,
+                     std::shared_ptr<Response>& resp) {
+    SetUpError(*resp, HttpError::kMethodNotAllowed);
   }
 
-  virtual void DoDelete(const std::shared_ptr<Request>& req,
-                        [[maybe_unused]] std::shared_ptr<Response>& resp) {
-    throw Http405Except(req->method(), req->url().src());
+  virtual void DoDelete([[maybe_unused]] const std::shared_ptr<Request>& req,
+                        std::shared_ptr<Response>& resp) {
+    SetUpError(*resp, HttpError::kMethodNotAllowed);
   }
 
-  virtual void DoHead(const std::shared_ptr<Request>& req,
-                      [[maybe_unused]] std::shared_ptr<Response>& resp) {
-    throw Http405Except(req->method(), req->url().src());
+  virtual void DoHead([[maybe_unused]] const std::shared_ptr<Request>& req,
+                      std::shared_ptr<Response>& resp) {
+    SetUpError(*resp, HttpError::kMethodNotAllowed);
   }
 
-  virtual void DoOptions(const std::shared_ptr<Request>& req,
-                         [[maybe_unused]] std::shared_ptr<Response>& resp) {
-    throw Http405Except(req->method(), req->url().src());
+  virtual void DoOptions([[maybe_unused]] const std::shared_ptr<Request>& req,
+                         std::shared_ptr<Response>& resp) {
+    SetUpError(*resp, HttpError::kMethodNotAllowed);
   }
 
-  virtual void DoConnect(const std::shared_ptr<Request>& req,
-                         [[maybe_unused]] std::shared_ptr<Response>& resp) {
-    throw Http405Except(req->method(), req->url().src());
+  virtual void DoConnect([[maybe_unused]] const std::shared_ptr<Request>& req,
+                         std::shared_ptr<Response>& resp) {
+    SetUpError(*resp, HttpError::kMethodNotAllowed);
   }
 
-  virtual void DoTrace(const std::shared_ptr<Request>& req,
-                       [[maybe_unused]] std::shared_ptr<Response>& resp) {
-    throw Http405Except(req->method(), req->url().src());
+  virtual void DoTrace([[maybe_unused]] const std::shared_ptr<Request>& req,
+                       std::shared_ptr<Response>& resp) {
+    SetUpError(*resp, HttpError::kMethodNotAllowed);
   }
 
-  virtual void DoPatch(const std::shared_ptr<Request>& req,
-                       [[maybe_unused]] std::shared_ptr<Response>& resp) {
-    throw Http405Except(req->method(), req->url().src());
+  virtual void DoPatch([[maybe_unused]] const std::shared_ptr<Request>& req,
+                       std::shared_ptr<Response>& resp) {
+    SetUpError(*resp, HttpError::kMethodNotAllowed);
   }
 };
 
@@ -93,9 +114,9 @@ class Http404Handler : public HttpHandler {
   Http404Handler& operator=(Http404Handler&&) noexcept = default;
   ~Http404Handler() override = default;
 
-  void Handle(const std::shared_ptr<Request>& req,
-              [[maybe_unused]] std::shared_ptr<Response>& resp) override {
-    throw Http404Except(req->method(), req->url().src());
+  void Handle([[maybe_unused]] const std::shared_ptr<Request>& req,
+              std::shared_ptr<Response>& resp) override {
+    SetUpError(*resp, HttpError::kNotFound);
   }
 };
 
@@ -18,7 +18,92 @@
 #ifndef AYAKA_SRC_HTTP_METHOD_HPP_
 #define AYAKA_SRC_HTTP_METHOD_HPP_
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
+
+namespace ayaka {
+
+/**
+ * RFC 9110 中定义的方法和 PATCH，其他扩展方法都是 kUnknown。
+ */
+enum class HttpMethod : uint8_t {
+  kGet,
+  kPost,
+  kPut,
+  kDelete,
+  kHead,
+  kOptions,
+  kConnect,
+  kTrace,
+  kPatch,
+  kUnknown
+};
+
+inline constexpr size_t kKnownMethods =
+    static_cast<size_t>(HttpMethod::kUnknown);
+
+/**
+ * 先按长度和首字节缩小范围，最多再比较一次完整的 token。方法区分大小写。
+ */
+constexpr HttpMethod ParseMethod(std::string_view token) {
+  switch (token.size()) {
+    case 3:
+      if (token == "GET") {
+        return HttpMethod::kGet;
+      }
+      if (token == "PUT") {
+        return HttpMethod::kPut;
+      }
+      break;
+    case 4:
+      if (token[0] == 'P' && token == "POST") {
+        return HttpMethod::kPost;
+      }
+      if (token[0] == 'H' && token == "HEAD") {
+        return HttpMethod::kHead;
+      }
+      break;
+    case 5:
+      if (token[0] == 'T' && token == "TRACE") {
+        return HttpMethod::kTrace;
+      }
+      if (token[0] == 'P' && token == "PATCH") {
+        return HttpMethod::kPatch;
+      }
+      break;
+    case 6:
+      if (token == "DELETE") {
+        return HttpMethod::kDelete;
+      }
+      break;
+    case 7:
+      if (token[0] == 'O' && token == "OPTIONS") {
+        return HttpMethod::kOptions;
+      }
+      if (token[0] == 'C' && token == "CONNECT") {
+        return HttpMethod::kConnect;
+      }
+      break;
+    default:
+      break;
+  }
+  return HttpMethod::kUnknown;
+}
+
+/**
+ * kUnknown 返回 UNKNOWN。
+ */
+constexpr std::string_view MethodName(HttpMethod method) {
+  constexpr std::array<std::string_view, kKnownMethods + 1> kNames = {
+      "GET",     "POST",    "PUT",   "DELETE", "HEAD",
+      "OPTIONS", "CONNECT", "TRACE", "PATCH",  "UNKNOWN"};
+  return kNames[static_cast<size_t>(method)];
+}
+
+}  // namespace ayaka
 
 namespace ayaka::http_method {
 
@@ -17,19 +17,53 @@
 
 #include "http_parser.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <charconv>
+#include <limits>
 
 #include "case.hpp"
 #include "error.hpp"
-#include "http_except.hpp"
+#include "scan.hpp"
 
 namespace ayaka {
 
+namespace {
+
+/**
+ * 返回十六进制数字的值，不是十六进制数字时返回 -1。
+ */
+int HexValue(char ch) {
+  if (ch >= '0' && ch <= '9') {
+    return ch - '0';
+  }
+  if (ch >= 'a' && ch <= 'f') {
+    return ch - 'a' + 10;
+  }
+  if (ch >= 'A' && ch <= 'F') {
+    return ch - 'A' + 10;
+  }
+  return -1;
+}
+
+/**
+ * HeaderParser 已经跳过了头部值开头的空白，这里去掉结尾的空白。
+ */
+std::string_view TrimRight(std::string_view str) {
+  auto last = str.find_last_not_of(" \t");
+  return last == std::string_view::npos ? std::string_view()
+                                        : str.substr(0, last + 1);
+}
+
+}  // namespace
+
 RequestStartLineParser::RequestStartLineParser(
     RequestStartLineParser&& other) noexcept
-    : method_(std::move(other.method_)),
-      url_(std::move(other.url_)),
-      version_(std::move(other.version_)),
+    : head_(other.head_),
+      method_(other.method_),
+      method_id_(other.method_id_),
+      url_(other.url_),
+      version_(other.version_),
       state_(other.state_) {
   other.state_ = State::kMoved;
 }
@@ -38,74 +72,90 @@ RequestStartLineParser& RequestStartLineParser::operator=(
     RequestStartLineParser&& other) noexcept {
   if (this != &other) {
     state_ = other.state_;
-    method_ = std::move(other.method_);
-    url_ = std::move(other.url_);
-    version_ = std::move(other.version_);
+    head_ = other.head_;
+    method_ = other.method_;
+    method_id_ = other.method_id_;
+    url_ = other.url_;
+    version_ = other.version_;
     other.state_ = State::kMoved;
   }
   return *this;
 }
 
-void RequestStartLineParser::Step(char ch) {
-  switch (state_) {
-    case State::kMethod:
-      if (ch == ' ' || ch == '\t') {
+size_t RequestStartLineParser::Exec(std::string_view head, size_t pos) {
+  head_ = head;
+  // 处于 token 中的状态使用 ScanFor 直接跳到分隔符，其余状态逐字节处理。
+  for (; pos < head.size(); ++pos) {
+    switch (state_) {
+      case State::kMethod:
+        pos = ScanFor(head, pos, ' ', '\t');
+        if (pos == head.size()) {
+          return pos;
+        }
+        method_.end = pos;
+        method_id_ = ParseMethod(method_.In(head));
         state_ = State::kMethodSpace;
-      } else {
-        method_.push_back(ch);
-      }
-      break;
-    case State::kMethodSpace:
-      if (!(ch == ' ' || ch == '\t')) {
-        url_.push_back(ch);
-        state_ = State::kUrl;
-      }
-      break;
-    case State::kUrl:
-      if (ch == ' ' || ch == '\t') {
+        break;
+      case State::kMethodSpace:
+        if (!(head[pos] == ' ' || head[pos] == '\t')) {
+          url_.begin = pos;
+          state_ = State::kUrl;
+        }
+        break;
+      case State::kUrl:
+        pos = ScanFor(head, pos, ' ', '\t');
+        if (pos == head.size()) {
+          return pos;
+        }
+        url_.end = pos;
         state_ = State::kUrlSpace;
-      } else {
-        url_.push_back(ch);
-      }
-      break;
-    case State::kUrlSpace:
-      if (!(ch == ' ' || ch == '\t')) {
-        version_.push_back(ch);
-        state_ = State::kVersion;
-      }
-      break;
-    case State::kVersion:
-      if (ch == '\r') {
+        break;
+      case State::kUrlSpace:
+        if (!(head[pos] == ' ' || head[pos] == '\t')) {
+          version_.begin = pos;
+          state_ = State::kVersion;
+        }
+        break;
+      case State::kVersion:
+        pos = ScanFor(head, pos, '\r');
+        if (pos == head.size()) {
+          return pos;
+        }
+        version_.end = pos;
         state_ = State::kNewLine;
-      } else {
-        version_.push_back(ch);
-      }
-      break;
-    case State::kNewLine:
-      if (ch == '\n') {
-        state_ = State::kDone;
-      } else {
-        throw Http400Except();
-      }
-      break;
-    case State::kDone:
-      AYAKA_LOG_CRITICAL("should call Reset()");
-    case State::kMoved:
-      AYAKA_LOG_CRITICAL("use after move");
+        break;
+      case State::kNewLine:
+        if (head[pos] == '\n') {
+          state_ = State::kDone;
+          return pos + 1;
+        }
+        state_ = State::kError;
+        return pos;
+      case State::kDone:
+      case State::kError:
+        AYAKA_LOG_CRITICAL("should call Reset()");
+      case State::kMoved:
+        AYAKA_LOG_CRITICAL("use after move");
+    }
   }
+  return pos;
 }
 
 void RequestStartLineParser::Reset() {
   AYAKA_TERM_IF(state_ == State::kMoved, "use after move");
-  method_.clear();
-  url_.clear();
-  version_.clear();
+  head_ = {};
+  method_ = {};
+  method_id_ = HttpMethod::kUnknown;
+  url_ = {};
+  version_ = {};
   state_ = State::kMethod;
 }
 
 HeaderParser::HeaderParser(HeaderParser&& other) noexcept
-    : name_(std::move(other.name_)),
-      value_(std::move(other.value_)),
+    : headers_(std::move(other.headers_)),
+      fields_(std::move(other.fields_)),
+      name_(other.name_),
+      value_(other.value_),
       state_(other.state_) {
   other.state_ = State::kMoved;
 }
@@ -113,80 +163,257 @@ HeaderParser::HeaderParser(HeaderParser&& other) noexcept
 HeaderParser& HeaderParser::operator=(HeaderParser&& other) noexcept {
   if (this != &other) {
     state_ = other.state_;
-    name_ = std::move(other.name_);
-    value_ = std::move(other.value_);
+    headers_ = std::move(other.headers_);
+    fields_ = std::move(other.fields_);
+    name_ = other.name_;
+    value_ = other.value_;
     other.state_ = State::kMoved;
   }
   return *this;
 }
 
-void HeaderParser::Step(char ch) {
-  switch (state_) {
-    case State::kLineStart:
-      if (ch == '\r') {
-        state_ = State::kEmptyNewLine;
-      } else {
-        name_.push_back(ch);
-        state_ = State::kName;
-      }
-      break;
-    case State::kEmptyNewLine:
-      if (ch == '\n') {
+size_t HeaderParser::Exec(std::string_view head, size_t pos) {
+  for (; pos < head.size(); ++pos) {
+    switch (state_) {
+      case State::kLineStart:
+        if (head[pos] == '\r') {
+          state_ = State::kEmptyNewLine;
+        } else {
+          name_.begin = pos;
+          state_ = State::kName;
+        }
+        break;
+      case State::kEmptyNewLine:
+        if (head[pos] != '\n') {
+          state_ = State::kError;
+          return pos;
+        }
+        for (const auto& [name, value] : fields_) {
+          if (!AddField(name.In(head), value.In(head))) {
+            state_ = State::kError;
+            return pos;
+          }
+        }
         state_ = State::kDone;
-      } else {
-        throw Http400Except();
-      }
-      break;
-    case State::kName:
-      if (ch == ':') {
+        return pos + 1;
+      case State::kName:
+        pos = ScanFor(head, pos, ':');
+        if (pos == head.size()) {
+          return pos;
+        }
+        name_.end = pos;
         state_ = State::kNameSpace;
-      } else {
-        name_.push_back(ch);
-      }
-      break;
-    case State::kNameSpace:
-      if (!(ch == ' ' || ch == '\t')) {
-        value_.push_back(ch);
-        state_ = State::kValue;
-      }
-      break;
-    case State::kValue:
-      if (ch == '\r') {
+        break;
+      case State::kNameSpace:
+        if (!(head[pos] == ' ' || head[pos] == '\t')) {
+          value_.begin = pos;
+          state_ = State::kValue;
+        }
+        break;
+      case State::kValue:
+        pos = ScanFor(head, pos, '\r');
+        if (pos == head.size()) {
+          return pos;
+        }
+        value_.end = pos;
         state_ = State::kNewLine;
-      } else {
-        value_.push_back(ch);
-      }
-      break;
-    case State::kNewLine:
-      if (ch == '\n') {
-        StrLower(name_);
-        headers_[std::move(name_)] = std::move(value_);
-        name_.clear();
-        value_.clear();
+        break;
+      case State::kNewLine:
+        if (head[pos] != '\n') {
+          state_ = State::kError;
+          return pos;
+        }
+        fields_.emplace_back(name_, value_);
         state_ = State::kLineStart;
-      } else {
-        throw Http400Except();
-      }
-      break;
-    case State::kDone:
-      AYAKA_LOG_CRITICAL("should call Reset()");
-    case State::kMoved:
-      AYAKA_LOG_CRITICAL("use after move");
+        break;
+      case State::kDone:
+      case State::kError:
+        AYAKA_LOG_CRITICAL("should call Reset()");
+      case State::kMoved:
+        AYAKA_LOG_CRITICAL("use after move");
+    }
   }
+  return pos;
+}
+
+bool HeaderParser::AddField(std::string_view name, std::string_view value) {
+  auto header = LookupHeader(name);
+  if (header == Header::kContentLength || header == Header::kTransferEncoding) {
+    // 值不同的多个 Content-Length，或者多个 Transfer-Encoding（chunked 重复
+    // 或者不是最后一个编码）会让前后的代理对请求体的边界产生分歧，可能导致
+    // 请求走私，必须拒绝（RFC 9112 6.3）。
+    const auto* prev = headers_.Find(header);
+    if (prev != nullptr && (header == Header::kTransferEncoding ||
+                            TrimRight(*prev) != TrimRight(value))) {
+      return false;
+    }
+  }
+  headers_[name] = value;
+  return true;
 }
 
 void HeaderParser::Reset() {
   AYAKA_TERM_IF(state_ == State::kMoved, "use after move");
-  name_.clear();
-  value_.clear();
   headers_.clear();
+  fields_.clear();
+  name_ = {};
+  value_ = {};
   state_ = State::kLineStart;
 }
 
+BodyParser::BodyParser(BodyParser&& other) noexcept
+    : state_(other.state_),
+      error_(other.error_),
+      max_size_(other.max_size_),
+      remaining_(other.remaining_),
+      decoded_(other.decoded_),
+      ndigits_(other.ndigits_) {
+  other.state_ = State::kMoved;
+}
+
+BodyParser& BodyParser::operator=(BodyParser&& other) noexcept {
+  if (this != &other) {
+    state_ = other.state_;
+    error_ = other.error_;
+    max_size_ = other.max_size_;
+    remaining_ = other.remaining_;
+    decoded_ = other.decoded_;
+    ndigits_ = other.ndigits_;
+    other.state_ = State::kMoved;
+  }
+  return *this;
+}
+
+void BodyParser::StartLength(uint64_t length) {
+  AYAKA_TERM_IF(state_ == State::kMoved, "use after move");
+  remaining_ = length;
+  state_ = State::kLength;
+}
+
+void BodyParser::StartChunked() {
+  AYAKA_TERM_IF(state_ == State::kMoved, "use after move");
+  remaining_ = 0;
+  decoded_ = 0;
+  ndigits_ = 0;
+  state_ = State::kChunkSize;
+}
+
+size_t BodyParser::Exec(const char* data, size_t len, RequestBody& body) {
+  size_t pos = 0;
+  while (pos < len) {
+    switch (state_) {
+      case State::kLength:
+      case State::kChunkData: {
+        auto n = std::min<uint64_t>(remaining_, len - pos);
+        body.Append({data + pos, n});
+        pos += n;
+        remaining_ -= n;
+        if (remaining_ == 0) {
+          if (state_ == State::kLength) {
+            state_ = State::kDone;
+            return pos;
+          }
+          state_ = State::kChunkDataCr;
+        }
+        break;
+      }
+      case State::kChunkSize: {
+        auto ch = data[pos++];
+        auto digit = HexValue(ch);
+        if (digit >= 0) {
+          // 15 个十六进制数字已经远远超过任何合理的块大小。
+          if (ndigits_ == 15) {
+            return Fail(HttpError::kBadRequest, pos);
+          }
+          remaining_ = remaining_ * 16 + digit;
+          ++ndigits_;
+        } else if (ndigits_ == 0) {
+          return Fail(HttpError::kBadRequest, pos);
+        } else if (ch == '\r') {
+          state_ = State::kChunkSizeNewLine;
+        } else if (ch == ';' || ch == ' ' || ch == '\t') {
+          state_ = State::kChunkExt;
+        } else {
+          return Fail(HttpError::kBadRequest, pos);
+        }
+        break;
+      }
+      case State::kChunkExt:
+        // 忽略块扩展。
+        pos = ScanFor({data, len}, pos, '\r');
+        if (pos < len) {
+          ++pos;
+          state_ = State::kChunkSizeNewLine;
+        }
+        break;
+      case State::kChunkSizeNewLine:
+        if (data[pos++] != '\n') {
+          return Fail(HttpError::kBadRequest, pos);
+        }
+        if (remaining_ == 0) {
+          state_ = State::kTrailerLineStart;
+          break;
+        }
+        // 在接收块的数据之前检查大小。
+        if (max_size_ > 0 && decoded_ + remaining_ > max_size_) {
+          return Fail(HttpError::kPayloadTooLarge, pos);
+        }
+        decoded_ += remaining_;
+        state_ = State::kChunkData;
+        break;
+      case State::kChunkDataCr:
+        if (data[pos++] != '\r') {
+          return Fail(HttpError::kBadRequest, pos);
+        }
+        state_ = State::kChunkDataNewLine;
+        break;
+      case State::kChunkDataNewLine:
+        if (data[pos++] != '\n') {
+          return Fail(HttpError::kBadRequest, pos);
+        }
+        remaining_ = 0;
+        ndigits_ = 0;
+        state_ = State::kChunkSize;
+        break;
+      case State::kTrailerLineStart:
+        state_ = data[pos++] == '\r' ? State::kEmptyNewLine : State::kTrailer;
+        break;
+      case State::kTrailer:
+        // 忽略 trailer 中的头部。
+        pos = ScanFor({data, len}, pos, '\r');
+        if (pos < len) {
+          ++pos;
+          state_ = State::kTrailerNewLine;
+        }
+        break;
+      case State::kTrailerNewLine:
+      case State::kEmptyNewLine:
+        if (data[pos++] != '\n') {
+          return Fail(HttpError::kBadRequest, pos);
+        }
+        if (state_ == State::kEmptyNewLine) {
+          state_ = State::kDone;
+          return pos;
+        }
+        state_ = State::kTrailerLineStart;
+        break;
+      case State::kDone:
+      case State::kError:
+        AYAKA_LOG_CRITICAL("should call StartLength() or StartChunked()");
+      case State::kMoved:
+        AYAKA_LOG_CRITICAL("use after move");
+    }
+  }
+  return pos;
+}
+
 RequestParser::RequestParser(RequestParser&& other) noexcept
     : rslp_(std::move(other.rslp_)),
       hp_(std::move(other.hp_)),
-      state_(other.state_) {
+      body_parser_(std::move(other.body_parser_)),
+      req_(std::move(other.req_)),
+      state_(other.state_),
+      error_(other.error_) {
   other.state_ = State::kMoved;
 }
 
@@ -195,50 +422,131 @@ RequestParser& RequestParser::operator=(RequestParser&& other) noexcept {
     state_ = other.state_;
     rslp_ = std::move(other.rslp_);
     hp_ = std::move(other.hp_);
+    body_parser_ = std::move(other.body_parser_);
+    req_ = std::move(other.req_);
+    error_ = other.error_;
     other.state_ = State::kMoved;
   }
   return *this;
 }
 
-void RequestParser::Step(char ch) {
+size_t RequestParser::Parse(std::string_view head, size_t pos) {
   switch (state_) {
     case State::kStartLine:
-      rslp_.Step(ch);
-      if (rslp_.state() == RequestStartLineParser::State::kDone) {
-        req_->set_method(rslp_.method());
-        req_->set_url(Url(rslp_.url()));
-        req_->set_version(rslp_.version());
-        state_ = State::kHeader;
-        // 检查 URL 是否合法。
-        if (!req_->url().valid()) {
-          throw Http400Except();
-        }
+      pos = rslp_.Exec(head, pos);
+      if (rslp_.state() == RequestStartLineParser::State::kError) {
+        Fail(HttpError::kBadRequest);
+        return pos;
       }
-      break;
+      if (rslp_.state() != RequestStartLineParser::State::kDone) {
+        return pos;
+      }
+      // 尽早检查 URL 是否合法。
+      req_->set_url(Url(rslp_.url()));
+      if (!req_->url().valid()) {
+        Fail(HttpError::kBadRequest);
+        return pos;
+      }
+      state_ = State::kHeader;
+      [[fallthrough]];
     case State::kHeader:
-      hp_.Step(ch);
-      if (hp_.state() == HeaderParser::State::kDone) {
+      pos = hp_.Exec(head, pos);
+      if (hp_.state() == HeaderParser::State::kError) {
+        Fail(HttpError::kBadRequest);
+      } else if (hp_.state() == HeaderParser::State::kDone) {
+        // 此时 head 的地址不会再改变。
+        rslp_.Rebase(head);
+        req_->set_method(rslp_.method_id(), rslp_.method());
+        req_->set_version(rslp_.version());
         req_->set_headers(hp_.headers());
-        state_ = State::kDone;
-        return;
+        StartBody();
       }
-      break;
+      return pos;
+    case State::kBody:
     case State::kDone:
+    case State::kError:
       AYAKA_LOG_CRITICAL("should call Reset()");
     case State::kMoved:
       AYAKA_LOG_CRITICAL("use after move");
   }
+  return pos;
 }
 
-size_t RequestParser::Exec(const char* data, size_t len) {
-  for (auto i = 0; i < len; i++) {
-    Step(data[i]);
-    if (state_ == State::kDone) {
-      if (!req_->url().valid()) {
-        throw Http400Except();
-      }
-      return i + 1;
+void RequestParser::StartBody() {
+  const auto& headers = req_->headers();
+  const auto* transfer_encoding = headers.Find(Header::kTransferEncoding);
+  const auto* content_length = headers.Find(Header::kContentLength);
+  if (transfer_encoding != nullptr) {
+    // 同时出现两者可能是请求走私，直接拒绝。只支持 chunked 一种编码，
+    // 因此 "chunked, chunked" 和 "chunked, gzip" 等也被拒绝。
+    if (content_length != nullptr ||
+        !StrEqualIgnoreCase(TrimRight(*transfer_encoding), "chunked")) {
+      Fail(HttpError::kBadRequest);
+      return;
     }
+    body_parser_.StartChunked();
+    req_->body() = RequestBody(RequestBody::kChunked);
+    state_ = State::kBody;
+    return;
+  }
+
+  if (content_length != nullptr) {
+    auto value = TrimRight(*content_length);
+    uint64_t length = 0;
+    auto [ptr, ec] =
+        std::from_chars(value.data(), value.data() + value.size(), length);
+    if (value.empty() || ec != std::errc() ||
+        ptr != value.data() + value.size() ||
+        length > std::numeric_limits<int64_t>::max()) {
+      Fail(HttpError::kBadRequest);
+      return;
+    }
+    auto max_size = body_parser_.max_size();
+    if (max_size > 0 && length > max_size) {
+      Fail(HttpError::kPayloadTooLarge);
+      return;
+    }
+    if (length > 0) {
+      body_parser_.StartLength(length);
+      req_->body() = RequestBody(static_cast<int64_t>(length));
+      state_ = State::kBody;
+      return;
+    }
+  }
+  state_ = State::kDone;
+}
+
+size_t RequestParser::Exec(const char* data, size_t len, const BufRef& buf) {
+  if (state_ == State::kBody) {
+    auto nparsed = body_parser_.Exec(data, len, req_->body());
+    if (body_parser_.state() == BodyParser::State::kError) {
+      Fail(body_parser_.error());
+    } else if (body_parser_.state() == BodyParser::State::kDone) {
+      state_ = State::kDone;
+      req_->body().Finish();
+    }
+    return nparsed;
+  }
+
+  auto& head = req_->head();
+  if (head.empty() && !buf.Empty()) {
+    auto end = Parse({data, len}, 0);
+    if (!InHead()) {
+      req_->set_buf(buf);
+      return end;
+    }
+    // 请求头部跨越多次读取，复制已经收到的部分，之前的偏移仍然有效。
+    head.assign(data, data + len);
+    return len;
+  }
+
+  auto old_size = head.size();
+  head.insert(head.end(), data, data + len);
+  auto end = Parse({head.data(), head.size()}, old_size);
+  if (!InHead()) {
+    // 之后的数据属于下一个请求。
+    head.resize(end);
+    return end - old_size;
   }
   return len;
 }
@@ -248,6 +556,7 @@ void RequestParser::Reset() {
   hp_.Reset();
   req_ = std::make_shared<Request>();
   state_ = State::kStartLine;
+  error_ = HttpError::kNone;
 }
 
 }  // namespace ayaka
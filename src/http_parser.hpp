@@ -18,15 +18,32 @@
 #ifndef AYAKA_SRC_HTTP_PARSER_HPP_
 #define AYAKA_SRC_HTTP_PARSER_HPP_
 
+#include <cstdint>
 #include <memory>
 #include <stdexcept>
-#include <unordered_map>
+#include <string_view>
+#include <utility>
+#include <vector>
 
+#include "http_except.hpp"
 #include "request.hpp"
 #include "response.hpp"
 
 namespace ayaka {
 
+/**
+ * 请求头部中的一段数据，用相对于请求开头的偏移表示。请求头部被复制到其他
+ * 地址后偏移仍然有效。
+ */
+struct HeadSpan {
+  [[nodiscard]] std::string_view In(std::string_view head) const {
+    return head.substr(begin, end - begin);
+  }
+
+  size_t begin = 0;
+  size_t end = 0;
+};
+
 class RequestStartLineParser {
  public:
   enum class State {
@@ -37,6 +54,7 @@ class RequestStartLineParser {
     kVersion,
     kNewLine,
     kDone,
+    kError,
     kMoved
   };
 
@@ -52,23 +70,41 @@ class RequestStartLineParser {
   RequestStartLineParser& operator=(RequestStartLineParser&& other) noexcept;
   ~RequestStartLineParser() = default;
 
-  [[nodiscard]] auto& method() const { return method_; }
-  [[nodiscard]] auto& url() const { return url_; }
-  [[nodiscard]] auto& version() const { return version_; }
+  /**
+   * 以下结果指向最近一次传给 Exec 的 head。
+   */
+  [[nodiscard]] auto method() const { return method_.In(head_); }
+  [[nodiscard]] auto method_id() const { return method_id_; }
+  [[nodiscard]] auto url() const { return url_.In(head_); }
+  [[nodiscard]] auto version() const { return version_.In(head_); }
   [[nodiscard]] auto state() const { return state_; }
 
-  void Step(char ch);
+  /**
+   * head 是从请求开头到目前为止收到的全部数据，从 pos 处继续解析。两次调用
+   * 之间 head 可以被复制到其他地址，但是已经解析的部分不能改变。
+   *
+   * 返回解析结束的位置：完成时是起始行之后的位置，否则是 head.size()。
+   * 格式错误时状态变为 kError，不会抛出异常。
+   */
+  size_t Exec(std::string_view head, size_t pos = 0);
+  /**
+   * 完成后 head 被复制到其他地址时，使结果指向新的 head。
+   */
+  void Rebase(std::string_view head) { head_ = head; }
   void Reset();
 
  private:
-  std::string method_;
-  std::string url_;
-  std::string version_;
+  std::string_view head_;
+  HeadSpan method_;
+  HttpMethod method_id_ = HttpMethod::kUnknown;
+  HeadSpan url_;
+  HeadSpan version_;
   State state_ = State::kMethod;
 };
 
 /**
- * HeaderParser 会将 HTTP 请求头部的名称转换为小写。
+ * HeaderParser 完成时通过 LookupHeader 把常用头部放入 Headers 的固定位置，
+ * 其余头部的名称保持原样，查找时忽略大小写。
  */
 class HeaderParser {
  public:
@@ -80,6 +116,7 @@ class HeaderParser {
     kValue,
     kNewLine,
     kDone,
+    kError,
     kMoved
   };
 
@@ -95,22 +132,116 @@ class HeaderParser {
   HeaderParser& operator=(HeaderParser&& other) noexcept;
   ~HeaderParser() = default;
 
-  void Step(char ch);
+  /**
+   * 与 RequestStartLineParser::Exec 相同，完成时返回头部之后的位置。
+   */
+  size_t Exec(std::string_view head, size_t pos = 0);
   void Reset();
 
   [[nodiscard]] auto state() const { return state_; }
+  /**
+   * 完成后才有效，指向最后一次传给 Exec 的 head。
+   */
   [[nodiscard]] auto&& headers() { return std::move(headers_); }
 
  private:
-  std::unordered_map<std::string, std::string> headers_;
-  std::string name_;
-  std::string value_;
+  /**
+   * 把一个头部字段加入 headers_。出现可能导致请求走私的重复字段时返回 false。
+   */
+  [[nodiscard]] bool AddField(std::string_view name, std::string_view value);
+
+  Headers headers_;
+  // 已经解析的头部，完成时才转换为 headers_，因为 head 的地址可能改变。
+  std::vector<std::pair<HeadSpan, HeadSpan>> fields_;
+  HeadSpan name_;
+  HeadSpan value_;
   State state_ = State::kLineStart;
 };
 
+/**
+ * 解析 Content-Length 或者 Transfer-Encoding: chunked 的请求体，解码出的数据
+ * 直接指向传入的数据，通过 RequestBody::Append 传递。
+ */
+class BodyParser {
+ public:
+  enum class State {
+    kLength,
+    kChunkSize,
+    kChunkExt,
+    kChunkSizeNewLine,
+    kChunkData,
+    kChunkDataCr,
+    kChunkDataNewLine,
+    kTrailerLineStart,
+    kTrailer,
+    kTrailerNewLine,
+    kEmptyNewLine,
+    kDone,
+    kError,
+    kMoved
+  };
+
+  BodyParser() = default;
+
+  /**
+   * BodyParser 只能移动，不能拷贝。
+   */
+  BodyParser(const BodyParser&) = delete;
+  BodyParser& operator=(const BodyParser&) = delete;
+
+  BodyParser(BodyParser&& other) noexcept;
+  BodyParser& operator=(BodyParser&& other) noexcept;
+  ~BodyParser() = default;
+
+  [[nodiscard]] auto state() const { return state_; }
+  /**
+   * 状态为 kError 时有效。
+   */
+  [[nodiscard]] auto error() const { return error_; }
+  /**
+   * 为 0 时不限制请求体的大小。
+   */
+  [[nodiscard]] auto max_size() const { return max_size_; }
+  void set_max_size(uint64_t max_size) { max_size_ = max_size; }
+
+  /**
+   * 开始解析长度为 length 的请求体，length 必须大于 0。
+   */
+  void StartLength(uint64_t length);
+  void StartChunked();
+
+  /**
+   * 返回消耗的字节数，完成时之后的数据属于下一个请求。chunked 的请求体超过
+   * max_size() 时 error() 为 kPayloadTooLarge，格式错误时为 kBadRequest，
+   * 两种情况下状态都变为 kError。
+   */
+  size_t Exec(const char* data, size_t len, RequestBody& body);
+
+ private:
+  size_t Fail(HttpError error, size_t pos) {
+    state_ = State::kError;
+    error_ = error;
+    return pos;
+  }
+
+  State state_ = State::kDone;
+  HttpError error_ = HttpError::kNone;
+  uint64_t max_size_ = 0;
+  // Content-Length 剩余的字节数，或者当前块剩余的字节数。
+  uint64_t remaining_ = 0;
+  // chunked 请求体已经解码的字节数。
+  uint64_t decoded_ = 0;
+  int ndigits_ = 0;
+};
+
+/**
+ * 请求头部完整地位于一次读取的数据中时，Request 中的 method、version 和
+ * headers 直接指向接收缓冲区，不会发生复制；只有请求头部跨越多次读取时，
+ * 才会将其复制到 Request::head() 中。
+ */
 class RequestParser {
  public:
-  enum class State { kStartLine, kHeader, kDone, kMoved };
+  enum class State { kStartLine, kHeader, kBody, kDone, kError, kMoved };
 
   RequestParser() = default;
 
@@ -128,17 +259,56 @@ class RequestParser {
   [[nodiscard]] auto& req() const { return req_; }
   [[nodiscard]] auto& req() { return req_; }
   [[nodiscard]] auto state() const { return state_; }
+  /**
+   * 状态为 kError 时有效，用于生成错误响应。
+   */
+  [[nodiscard]] auto error() const { return error_; }
+  /**
+   * 还没有收到完整的请求头部。请求头部完成后状态变为 kBody 或者 kDone，
+   * 此时就可以处理请求，请求体随后被传递到 Request::body()。
+   */
+  [[nodiscard]] bool InHead() const {
+    return state_ == State::kStartLine || state_ == State::kHeader;
+  }
+  [[nodiscard]] auto max_body_size() const { return body_parser_.max_size(); }
+  /**
+   * 为 0 时不限制请求体的大小。
+   */
+  void set_max_body_size(uint64_t max_body_size) {
+    body_parser_.set_max_size(max_body_size);
+  }
 
-  [[nodiscard]] size_t Exec(const char* data, size_t len);
+  /**
+   * 返回消耗的字节数，请求头部完成时停止，请求体完成时也会停止。buf 是 data
+   * 所在的接收缓冲区，请求会持有它直到被释放；buf 为空时 data 总是被复制。
+   *
+   * 请求格式错误或者请求体过大时不会抛出异常，而是把状态变为 kError，之后
+   * 必须调用 Reset。
+   */
+  [[nodiscard]] size_t Exec(const char* data, size_t len,
+                            const BufRef& buf = {});
   void Reset();
 
  private:
-  void Step(char ch);
+  /**
+   * 从 pos 处继续解析 head，返回解析结束的位置。
+   */
+  size_t Parse(std::string_view head, size_t pos);
+  /**
+   * 根据 Transfer-Encoding 和 Content-Length 决定是否有请求体。
+   */
+  void StartBody();
+  void Fail(HttpError error) {
+    state_ = State::kError;
+    error_ = error;
+  }
 
   RequestStartLineParser rslp_;
   HeaderParser hp_;
+  BodyParser body_parser_;
   std::shared_ptr<Request> req_ = std::make_shared<Request>();
   State state_ = State::kStartLine;
+  HttpError error_ = HttpError::kNone;
 };
 
 }  // namespace ayaka
@@ -19,9 +19,48 @@
 #define AYAKA_SRC_HTTP_STATUS_HPP_
 
 #include <string>
+#include <string_view>
+#include <utility>
 
 namespace ayaka {
 
+/**
+ * 预先格式化的状态行，在编译期生成。
+ */
+struct StatusLine {
+  std::string_view code;
+  std::string_view msg;
+  // HTTP/1.1 的完整状态行，包括结尾的 \r\n。
+  std::string_view line;
+};
+
+#define AYAKA_STATUS_LINE(code, msg) \
+  StatusLine { code, msg, "HTTP/1.1 " code " " msg "\r\n" }
+
+inline constexpr StatusLine kStatusOk = AYAKA_STATUS_LINE("200", "OK");
+inline constexpr StatusLine kStatusPartialContent =
+    AYAKA_STATUS_LINE("206", "Partial Content");
+inline constexpr StatusLine kStatusNotModified =
+    AYAKA_STATUS_LINE("304", "Not Modified");
+inline constexpr StatusLine kStatusBadRequest =
+    AYAKA_STATUS_LINE("400", "Bad Request");
+inline constexpr StatusLine kStatusNotFound =
+    AYAKA_STATUS_LINE("404", "Not Found");
+inline constexpr StatusLine kStatusMethodNotAllowed =
+    AYAKA_STATUS_LINE("405", "Method Not Allowed");
+inline constexpr StatusLine kStatusPayloadTooLarge =
+    AYAKA_STATUS_LINE("413", "Payload Too Large");
+inline constexpr StatusLine kStatusRangeNotSatisfiable =
+    AYAKA_STATUS_LINE("416", "Range Not Satisfiable");
+inline constexpr StatusLine kStatusInternalServerError =
+    AYAKA_STATUS_LINE("500", "Internal Server Error");
+
+#undef AYAKA_STATUS_LINE
+
+/**
+ * 预定义的状态只保存指向 StatusLine 的指针，构造和拷贝都不分配内存。
+ * 通过 code 和 msg 构造的自定义状态保存它们的副本，没有预先格式化的状态行。
+ */
 class HttpStatus {
  public:
   HttpStatus() = default;
@@ -29,23 +68,49 @@ class HttpStatus {
   HttpStatus(std::string code, std::string msg)
       : code_(std::move(code)), msg_(std::move(msg)) {}
 
+  explicit constexpr HttpStatus(const StatusLine& line) : line_(&line) {}
+
   HttpStatus(const HttpStatus&) = default;
   HttpStatus& operator=(const HttpStatus&) = default;
   HttpStatus(HttpStatus&&) noexcept = default;
   HttpStatus& operator=(HttpStatus&&) noexcept = default;
   ~HttpStatus() = default;
 
-  static auto Ok() { return std::move(HttpStatus("200", "OK")); }
-  static auto BadRequest() { return std::move(HttpStatus("400", "Bad Request")); }
-  static auto NotFound() { return std::move(HttpStatus("404", "Not Found")); }
-  static auto MethodNotAllowed() {
-    return std::move(HttpStatus("405", "Method Not Allowed"));
+  static HttpStatus Ok() { return HttpStatus(kStatusOk); }
+  static HttpStatus PartialContent() {
+    return HttpStatus(kStatusPartialContent);
+  }
+  static HttpStatus NotModified() { return HttpStatus(kStatusNotModified); }
+  static HttpStatus BadRequest() { return HttpStatus(kStatusBadRequest); }
+  static HttpStatus NotFound() { return HttpStatus(kStatusNotFound); }
+  static HttpStatus MethodNotAllowed() {
+    return HttpStatus(kStatusMethodNotAllowed);
+  }
+  static HttpStatus PayloadTooLarge() {
+    return HttpStatus(kStatusPayloadTooLarge);
+  }
+  static HttpStatus RangeNotSatisfiable() {
+    return HttpStatus(kStatusRangeNotSatisfiable);
+  }
+  static HttpStatus InternalServerError() {
+    return HttpStatus(kStatusInternalServerError);
   }
 
-  [[nodiscard]] auto& code() const { return code_; }
-  [[nodiscard]] auto& msg() const { return msg_; }
+  [[nodiscard]] std::string_view code() const {
+    return line_ != nullptr ? line_->code : code_;
+  }
+  [[nodiscard]] std::string_view msg() const {
+    return line_ != nullptr ? line_->msg : msg_;
+  }
+  /**
+   * HTTP/1.1 的完整状态行，自定义状态返回空字符串。
+   */
+  [[nodiscard]] std::string_view line() const {
+    return line_ != nullptr ? line_->line : std::string_view();
+  }
 
  private:
+  const StatusLine* line_ = nullptr;
   std::string code_;
   std::string msg_;
 };
@@ -40,6 +40,15 @@ class Location {
    */
   [[nodiscard]] virtual bool Match(const std::string &path) const = 0;
 
+  /**
+   * Router 中的键，经过 std::filesystem::path::lexically_normal 转换。
+   */
+  [[nodiscard]] virtual const std::string &key() const = 0;
+  /**
+   * 为 true 时匹配以 key() 开头的路径，否则只匹配与 key() 相同的路径。
+   */
+  [[nodiscard]] virtual bool prefix() const = 0;
+
   [[nodiscard]] auto &handler() const { return handler_; }
   void set_handler(std::shared_ptr<HttpHandler> handler) {
     handler_ = std::move(handler);
@@ -72,9 +81,14 @@ class PathLocation : public Location {
    * path 应该是被 std::filesystem::path::lexically_normal 转换过的。
    */
   [[nodiscard]] bool Match(const std::string &path) const override {
-    return path == path_.string();
+    return path == path_.native();
   }
 
+  [[nodiscard]] const std::string &key() const override {
+    return path_.native();
+  }
+  [[nodiscard]] bool prefix() const override { return false; }
+
  private:
   std::filesystem::path path_;
 };
@@ -101,8 +115,13 @@ class DirLocation : public Location {
     if (dir_.empty()) {
       return false;
     }
-    return path.rfind(dir_.string(), 0) == 0;
+    return path.rfind(dir_.native(), 0) == 0;
+  }
+
+  [[nodiscard]] const std::string &key() const override {
+    return dir_.native();
   }
+  [[nodiscard]] bool prefix() const override { return true; }
 
  private:
   std::filesystem::path dir_;
@@ -24,6 +24,14 @@ namespace ayaka {
 Loop::Loop() : uv_loop_(new uv_loop_t) {
   auto status = uv_loop_init(uv_loop_);
   AYAKA_TERM_IF(status < 0, "uv_loop_init() failed: {}", uv_strerror(status));
+  uv_loop_->data = this;
+
+  status = uv_async_init(uv_loop_, &async_, UvOnAsync);
+  AYAKA_TERM_IF(status < 0, "uv_async_init() failed: {}", uv_strerror(status));
+  async_.data = this;
+  uv_unref(reinterpret_cast<uv_handle_t *>(&async_));
+
+  timer_wheel_ = std::make_unique<TimerWheel>(uv_loop_);
 }
 
 Loop::~Loop() {
@@ -42,6 +50,26 @@ void Loop::Run() const {
 
 void Loop::Once() const { uv_run(uv_loop_, UV_RUN_ONCE); }
 
+void Loop::Post(std::function<void()> func) {
+  {
+    std::lock_guard<std::mutex> lock(posted_mutex_);
+    posted_.push_back(std::move(func));
+  }
+  uv_async_send(&async_);
+}
+
+void Loop::UvOnAsync(uv_async_t *handle) {
+  auto *loop = static_cast<Loop *>(handle->data);
+  std::vector<std::function<void()>> posted;
+  {
+    std::lock_guard<std::mutex> lock(loop->posted_mutex_);
+    posted.swap(loop->posted_);
+  }
+  for (auto &func : posted) {
+    func();
+  }
+}
+
 void Loop::UvWalkClose(uv_handle_t *handle, [[maybe_unused]] void *arg) {
   if (uv_is_closing(handle) != 0) {
     return;
@@ -20,10 +20,19 @@
 
 #include <uv.h>
 
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <vector>
+
+#include "buf_pool.hpp"
+#include "timer_wheel.hpp"
 
 namespace ayaka {
 
+/**
+ * uv_loop()->data 指向 Loop 对象本身。
+ */
 class Loop {
  public:
   Loop();
@@ -39,14 +48,37 @@ class Loop {
   ~Loop();
 
   [[nodiscard]] auto uv_loop() const { return uv_loop_; }
+  /**
+   * 该事件循环上所有 Tcp 共用的接收缓冲区池。
+   */
+  [[nodiscard]] auto &buf_pool() const { return buf_pool_; }
+  [[nodiscard]] auto &buf_pool() { return buf_pool_; }
+  /**
+   * 该事件循环上所有连接共用的时间轮。
+   */
+  [[nodiscard]] auto &timer_wheel() const { return *timer_wheel_; }
 
   void Run() const;
   void Once() const;
 
+  /**
+   * 在事件循环的线程中调用 func。可以在任意线程中调用，但是不能在 Loop 析构
+   * 之后调用。Post 不会使事件循环保持运行，如果事件循环中没有其他活跃的 handle
+   * 或请求，func 不会被调用。
+   */
+  void Post(std::function<void()> func);
+
  private:
   static void UvWalkClose(uv_handle_t *handle, void *arg);
+  static void UvOnAsync(uv_async_t *handle);
 
   uv_loop_t *uv_loop_;
+  BufPool buf_pool_;
+  std::unique_ptr<TimerWheel> timer_wheel_;
+  // 用于唤醒事件循环，不会阻止 Run 返回。
+  uv_async_t async_{};
+  std::mutex posted_mutex_;
+  std::vector<std::function<void()>> posted_;
 };
 
 }  // namespace ayaka
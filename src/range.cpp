@@ -0,0 +1,120 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "range.hpp"
+
+#include <algorithm>
+#include <charconv>
+
+#include "case.hpp"
+
+namespace ayaka {
+
+namespace {
+
+/**
+ * str 必须全部是数字。
+ */
+bool ParseSize(std::string_view str, size_t& value) {
+  if (str.empty()) {
+    return false;
+  }
+  const auto* end = str.data() + str.size();
+  auto result = std::from_chars(str.data(), end, value);
+  return result.ec == std::errc() && result.ptr == end;
+}
+
+}  // namespace
+
+RangeResult ParseRange(std::string_view value, size_t size,
+                       std::vector<ByteRange>& ranges) {
+  ranges.clear();
+  value = TrimOws(value);
+  constexpr std::string_view kUnit = "bytes=";
+  if (value.size() < kUnit.size() ||
+      !StrEqualIgnoreCase(value.substr(0, kUnit.size()), kUnit)) {
+    return RangeResult::kNone;
+  }
+  value.remove_prefix(kUnit.size());
+
+  size_t nspecs = 0;
+  while (!value.empty()) {
+    auto comma = value.find(',');
+    auto spec = TrimOws(value.substr(0, comma));
+    value = comma == std::string_view::npos ? std::string_view()
+                                            : value.substr(comma + 1);
+    // 列表中允许有空的元素。
+    if (spec.empty()) {
+      continue;
+    }
+    if (++nspecs > kMaxRanges) {
+      return RangeResult::kNone;
+    }
+    auto dash = spec.find('-');
+    if (dash == std::string_view::npos) {
+      return RangeResult::kNone;
+    }
+    auto first_str = spec.substr(0, dash);
+    auto last_str = spec.substr(dash + 1);
+
+    if (first_str.empty()) {
+      // 最后 suffix 个字节。
+      size_t suffix = 0;
+      if (!ParseSize(last_str, suffix)) {
+        return RangeResult::kNone;
+      }
+      if (suffix > 0 && size > 0) {
+        auto length = std::min(suffix, size);
+        ranges.push_back({size - length, length});
+      }
+      continue;
+    }
+
+    size_t first = 0;
+    if (!ParseSize(first_str, first)) {
+      return RangeResult::kNone;
+    }
+    auto last = size - 1;
+    if (!last_str.empty()) {
+      size_t value_last = 0;
+      if (!ParseSize(last_str, value_last) || value_last < first) {
+        return RangeResult::kNone;
+      }
+      last = std::min(last, value_last);
+    }
+    if (first < size) {
+      ranges.push_back({first, last - first + 1});
+    }
+  }
+
+  if (nspecs == 0) {
+    return RangeResult::kNone;
+  }
+  return ranges.empty() ? RangeResult::kUnsatisfiable : RangeResult::kOk;
+}
+
+std::string ContentRange(const ByteRange& range, size_t size) {
+  return "bytes " + std::to_string(range.offset) + "-" +
+         std::to_string(range.offset + range.length - 1) + "/" +
+         std::to_string(size);
+}
+
+std::string UnsatisfiedRange(size_t size) {
+  return "bytes */" + std::to_string(size);
+}
+
+}  // namespace ayaka
@@ -0,0 +1,73 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef AYAKA_SRC_RANGE_HPP_
+#define AYAKA_SRC_RANGE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ayaka {
+
+/**
+ * 内容中 [offset, offset + length) 范围的字节。
+ */
+struct ByteRange {
+  size_t offset = 0;
+  size_t length = 0;
+};
+
+enum class RangeResult : uint8_t {
+  /**
+   * Range 无法解析或者范围太多，应该忽略 Range 返回完整的内容。
+   */
+  kNone,
+  kOk,
+  /**
+   * 所有范围都在内容之外，应该返回 416。
+   */
+  kUnsatisfiable,
+};
+
+/**
+ * 一个 Range 最多包含的范围数，超过时忽略 Range，避免大量的小范围放大响应。
+ */
+inline constexpr size_t kMaxRanges = 16;
+
+/**
+ * 解析单位为 bytes 的 Range 头部，size 是完整内容的长度。返回 kOk 时，ranges
+ * 按照请求中的顺序保存所有可以满足的范围，结尾超出内容的范围会被截断。
+ */
+[[nodiscard]] RangeResult ParseRange(std::string_view value, size_t size,
+                                     std::vector<ByteRange>& ranges);
+
+/**
+ * Content-Range 的值，例如 bytes 0-499/1234。
+ */
+[[nodiscard]] std::string ContentRange(const ByteRange& range, size_t size);
+
+/**
+ * 416 响应中 Content-Range 的值，例如 bytes * /1234（没有空格）。
+ */
+[[nodiscard]] std::string UnsatisfiedRange(size_t size);
+
+}  // namespace ayaka
+
+#endif  // AYAKA_SRC_RANGE_HPP_
@@ -0,0 +1,65 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "request.hpp"
+
+#include "case.hpp"
+
+namespace ayaka {
+
+namespace {
+
+/**
+ * 判断以逗号分隔的 Connection 头部中是否含有 token，忽略大小写。
+ */
+bool HasConnectionToken(std::string_view connection, std::string_view token) {
+  std::string_view::size_type start = 0;
+  while (start <= connection.size()) {
+    auto end = connection.find(',', start);
+    if (end == std::string_view::npos) {
+      end = connection.size();
+    }
+    auto first = connection.find_first_not_of(" \t", start);
+    auto last = connection.find_last_not_of(" \t", end - 1);
+    if (first != std::string_view::npos && first < end && last >= first &&
+        StrEqualIgnoreCase(connection.substr(first, last - first + 1),
+                           token)) {
+      return true;
+    }
+    start = end + 1;
+  }
+  return false;
+}
+
+}  // namespace
+
+bool Request::KeepAlive() const {
+  std::string_view connection;
+  if (const auto* value = headers_.Find(Header::kConnection)) {
+    connection = *value;
+  }
+
+  if (version_ == "HTTP/1.1") {
+    return !HasConnectionToken(connection, "close");
+  }
+  if (version_ == "HTTP/1.0") {
+    return HasConnectionToken(connection, "keep-alive");
+  }
+  return false;
+}
+
+}  // namespace ayaka
@@ -20,38 +20,89 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 
+#include "buf_pool.hpp"
+#include "headers.hpp"
 #include "http_method.hpp"
+#include "request_body.hpp"
 #include "url.hpp"
 
 namespace ayaka {
 
+/**
+ * 扩展方法的名称、version 和 headers 都是 std::string_view，指向请求所持有的
+ * 接收缓冲区 buf() 或者请求跨越多次读取时复制出的 head()。直接调用 setter
+ * 时，调用者需要保证数据的生命周期长于 Request，例如使用字符串字面量。
+ */
 class Request {
  public:
-  Request() : method_(http_method::kUnknown) {}
-  Request(const Request&) = default;
-  Request& operator=(const Request&) = default;
+  Request() = default;
+
+  /**
+   * Request 中的 std::string_view 可能指向自身的 head_，所以不能拷贝。
+   * 移动 std::vector 不会改变数据的地址。
+   */
+  Request(const Request&) = delete;
+  Request& operator=(const Request&) = delete;
   Request(Request&&) noexcept = default;
   Request& operator=(Request&&) noexcept = default;
   ~Request() = default;
 
-  [[nodiscard]] auto& method() const { return method_; }
-  void set_method(std::string method) { method_ = std::move(method); }
+  /**
+   * 方法的名称。常用方法返回静态字符串，扩展方法返回请求中的原始 token。
+   */
+  [[nodiscard]] std::string_view method() const {
+    return method_id_ == HttpMethod::kUnknown ? method_
+                                              : MethodName(method_id_);
+  }
+  [[nodiscard]] auto method_id() const { return method_id_; }
+  /**
+   * 只有扩展方法才保存 token。
+   */
+  void set_method(HttpMethod method_id, std::string_view token = {}) {
+    method_id_ = method_id;
+    method_ = method_id == HttpMethod::kUnknown ? token : std::string_view();
+  }
+  void set_method(std::string_view method) {
+    set_method(ParseMethod(method), method);
+  }
   [[nodiscard]] auto& url() const { return url_; }
   [[nodiscard]] auto& url() { return url_; }
   void set_url(Url url) { url_ = std::move(url); }
   [[nodiscard]] auto& version() const { return version_; }
-  void set_version(std::string version) { version_ = std::move(version); }
+  void set_version(std::string_view version) { version_ = version; }
+  [[nodiscard]] auto& headers() const { return headers_; }
   [[nodiscard]] auto& headers() { return headers_; }
-  void set_headers(std::unordered_map<std::string, std::string> headers) {
-    headers_ = std::move(headers);
-  }
+  void set_headers(Headers headers) { headers_ = std::move(headers); }
+  [[nodiscard]] auto& buf() const { return buf_; }
+  void set_buf(BufRef buf) { buf_ = std::move(buf); }
+  [[nodiscard]] auto& head() const { return head_; }
+  [[nodiscard]] auto& head() { return head_; }
+  /**
+   * 处理器被调用时请求体可能还没有接收完毕，见 RequestBody。
+   */
+  [[nodiscard]] auto& body() const { return body_; }
+  [[nodiscard]] auto& body() { return body_; }
+
+  /**
+   * 根据 HTTP 版本和 Connection 头部判断客户端是否希望保持连接：
+   * 1. HTTP/1.1 默认保持连接，除非 Connection 中包含 close
+   * 2. HTTP/1.0 默认关闭连接，除非 Connection 中包含 keep-alive
+   * 3. 其他版本一律关闭连接
+   */
+  [[nodiscard]] bool KeepAlive() const;
 
  private:
-  std::string method_;
+  HttpMethod method_id_ = HttpMethod::kUnknown;
+  std::string_view method_ = MethodName(HttpMethod::kUnknown);
   Url url_;
-  std::string version_;
-  std::unordered_map<std::string, std::string> headers_;
+  std::string_view version_;
+  Headers headers_;
+  BufRef buf_;
+  std::vector<char> head_;
+  RequestBody body_;
 };
 
 }  // namespace ayaka
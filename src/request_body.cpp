@@ -0,0 +1,97 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "request_body.hpp"
+
+#include <utility>
+
+#include "error.hpp"
+
+namespace ayaka {
+
+void RequestBody::Read(OnDataCb on_data, OnEndCb on_end) {
+  AYAKA_TERM_IF(mode_ != Mode::kBuffer, "the request body is already read");
+  mode_ = Mode::kRead;
+  on_data_ = std::move(on_data);
+  on_end_ = std::move(on_end);
+  if (!content_.empty()) {
+    on_data_({content_.data(), content_.size()});
+    content_.clear();
+    content_.shrink_to_fit();
+  }
+  if (done_) {
+    End();
+  }
+}
+
+void RequestBody::ReadAll(OnEndCb on_end) {
+  AYAKA_TERM_IF(mode_ != Mode::kBuffer, "the request body is already read");
+  mode_ = Mode::kReadAll;
+  on_end_ = std::move(on_end);
+  if (done_) {
+    End();
+  }
+}
+
+void RequestBody::Discard() {
+  AYAKA_TERM_IF(mode_ != Mode::kBuffer, "the request body is already read");
+  mode_ = Mode::kDiscard;
+  content_.clear();
+  content_.shrink_to_fit();
+}
+
+void RequestBody::Append(std::string_view data) {
+  nreceived_ += data.size();
+  switch (mode_) {
+    case Mode::kBuffer:
+    case Mode::kReadAll:
+      content_.insert(content_.end(), data.begin(), data.end());
+      break;
+    case Mode::kRead:
+      on_data_(data);
+      break;
+    case Mode::kDiscard:
+      break;
+  }
+}
+
+void RequestBody::Finish() {
+  done_ = true;
+  End();
+}
+
+void RequestBody::Abort(std::exception_ptr except) {
+  if (done_) {
+    return;
+  }
+  done_ = true;
+  except_ = std::move(except);
+  content_.clear();
+  End();
+}
+
+void RequestBody::End() {
+  if (on_end_) {
+    // on_end 可能会释放持有 RequestBody 的 Request。
+    auto on_end = std::move(on_end_);
+    on_end_ = nullptr;
+    on_data_ = nullptr;
+    on_end(except_);
+  }
+}
+
+}  // namespace ayaka
@@ -0,0 +1,116 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef AYAKA_SRC_REQUEST_BODY_HPP_
+#define AYAKA_SRC_REQUEST_BODY_HPP_
+
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+namespace ayaka {
+
+/**
+ * 请求体。Downstream 在收到请求头部后就调用处理器，请求体随后逐块到达。
+ * 处理器可以用 Read 以流的方式接收数据，或者用 ReadAll 等待完整的请求体。
+ *
+ * 处理器开始读取之前到达的数据会被暂存，暂存的数据不会超过
+ * ServerConf::max_body_size()。不关心请求体的处理器可以调用 Discard。
+ *
+ * 因为实现原因，RequestBody 只能在事件循环的线程中使用。
+ */
+class RequestBody {
+ public:
+  using OnDataCb = std::function<void(std::string_view)>;
+  /**
+   * 参数为 nullptr 表示请求体已经完整接收，否则表示接收失败的原因，例如
+   * Http413Except 或者连接被关闭。
+   */
+  using OnEndCb = std::function<void(std::exception_ptr)>;
+
+  /**
+   * 没有请求体。
+   */
+  RequestBody() = default;
+
+  /**
+   * length 为 Content-Length，或者 kChunked。
+   */
+  explicit RequestBody(int64_t length) : length_(length), done_(false) {}
+
+  /**
+   * RequestBody 只能移动，不能拷贝。
+   */
+  RequestBody(const RequestBody &) = delete;
+  RequestBody &operator=(const RequestBody &) = delete;
+  RequestBody(RequestBody &&) noexcept = default;
+  RequestBody &operator=(RequestBody &&) noexcept = default;
+  ~RequestBody() = default;
+
+  [[nodiscard]] auto length() const { return length_; }
+  [[nodiscard]] auto nreceived() const { return nreceived_; }
+  [[nodiscard]] bool Empty() const { return length_ == 0; }
+  [[nodiscard]] auto done() const { return done_; }
+  /**
+   * ReadAll 完成后为完整的请求体。
+   */
+  [[nodiscard]] auto &content() const { return content_; }
+
+  /**
+   * 先传递已经暂存的数据，之后每收到一块数据调用一次 on_data。data 只在回调
+   * 期间有效。Read、ReadAll 和 Discard 只能调用其中一个，并且只能调用一次。
+   */
+  void Read(OnDataCb on_data, OnEndCb on_end);
+  /**
+   * 将完整的请求体保存在 content() 中，之后调用 on_end。
+   */
+  void ReadAll(OnEndCb on_end);
+  /**
+   * 丢弃已经暂存的和之后到达的数据。
+   */
+  void Discard();
+
+  /**
+   * 以下由 RequestParser 和 Downstream 调用。
+   */
+  void Append(std::string_view data);
+  void Finish();
+  void Abort(std::exception_ptr except);
+
+  // 使用 Transfer-Encoding: chunked，长度未知。
+  static constexpr int64_t kChunked = -1;
+
+ private:
+  enum class Mode { kBuffer, kRead, kReadAll, kDiscard };
+
+  void End();
+
+  int64_t length_ = 0;
+  uint64_t nreceived_ = 0;
+  bool done_ = true;
+  std::exception_ptr except_;
+  Mode mode_ = Mode::kBuffer;
+  std::vector<char> content_;
+  OnDataCb on_data_;
+  OnEndCb on_end_;
+};
+
+}  // namespace ayaka
+
+#endif  // AYAKA_SRC_REQUEST_BODY_HPP_
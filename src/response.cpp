@@ -35,14 +35,58 @@ std::string Response::GetDate(const time_t* tloc) {
   return {buf};
 }
 
+std::string_view Response::CachedDate() {
+  struct Cache {
+    time_t time = -1;
+    char buf[32] = {};
+    size_t len = 0;
+  };
+  thread_local Cache cache;
+  auto now = time(nullptr);
+  if (now != cache.time) {
+    tm tm{};
+    gmtime_r(&now, &tm);
+    cache.len = strftime(cache.buf, sizeof(cache.buf),
+                         "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    cache.time = now;
+  }
+  return {cache.buf, cache.len};
+}
+
+std::string_view Response::ServerName() { return "Ayaka/" AYAKA_VERSION; }
+
+size_t Response::BodySize() const {
+  if (!parts_.empty()) {
+    size_t size = 0;
+    for (const auto& part : parts_) {
+      size += part.data.size() + part.file.length();
+    }
+    return size;
+  }
+  if (file_body_.file()) {
+    return file_body_.length();
+  }
+  if (mapped_body_) {
+    return mapped_body_->size();
+  }
+  return body_ ? body_->size() : 0;
+}
+
 std::shared_ptr<Response> Response::Default() {
   auto resp = std::make_shared<Response>();
-  resp->version_ = "HTTP/1.1";
-  resp->status_ = std::move(HttpStatus::Ok());
-  resp->headers_["Connection"] = "close";
-  resp->headers_["Date"] = GetDate();
-  resp->headers_["Server"] = "Ayaka/" AYAKA_VERSION;
+  resp->Reset();
   return resp;
 }
 
+void Response::Reset() {
+  version_ = "HTTP/1.1";
+  status_ = HttpStatus::Ok();
+  headers_.clear();
+  headers_[Header::kConnection] = "close";
+  body_.reset();
+  mapped_body_.reset();
+  file_body_ = FileBody();
+  parts_.clear();
+}
+
 }  // namespace ayaka
@@ -20,14 +20,26 @@
 
 #include <cstdint>
 #include <memory>
-#include <unordered_map>
+#include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include "file.hpp"
+#include "headers.hpp"
 #include "http_status.hpp"
 
 namespace ayaka {
 
+/**
+ * 多段响应体中的一段，先发送 data，再通过 sendfile 发送 file。用于
+ * multipart/byteranges，各段之间的分隔符和头部保存在 data 中。
+ */
+struct BodyPart {
+  std::string data;
+  FileBody file;
+};
+
 class Response {
  public:
   using Body = std::shared_ptr<std::vector<char>>;
@@ -37,9 +49,10 @@ class Response {
    * 1. 将 HTTP 版本设置为 HTTP/1.1
    * 2. 将响应状态码设置为 200 OK
    * 3. Connection 设置为 close
-   * 4. Date 设置为当前时间
-   * 5. Server 设置为 Ayaka/{AYAKA_VERSION}
-   * 6. 不初始化 body
+   * 4. 不初始化 body
+   *
+   * Date 和 Server 不保存在 headers 中，发送时由 SendRespPack 使用 CachedDate
+   * 和 ServerName 添加，除非处理器显式设置了它们。
    */
   static std::shared_ptr<Response> Default();
 
@@ -50,27 +63,74 @@ class Response {
   Response& operator=(Response&&) noexcept = default;
   ~Response() = default;
 
+  /**
+   * 恢复为 Default 创建时的状态，用于在已有的对象上生成错误响应。
+   */
+  void Reset();
+
   [[nodiscard]] auto& version() const { return version_; }
   void set_version(std::string version) { version_ = std::move(version); }
   [[nodiscard]] auto& status() const { return status_; }
   void set_status(HttpStatus status) { status_ = std::move(status); }
   [[nodiscard]] auto& headers() const { return headers_; }
   [[nodiscard]] auto& headers() { return headers_; }
-  void set_headers(std::unordered_map<std::string, std::string> headers) {
+  void set_headers(ResponseHeaders headers) {
     headers_ = std::move(headers);
   }
   [[nodiscard]] auto& body() const { return body_; }
   [[nodiscard]] auto& body() { return body_; }
   void set_body(Body body) { body_ = std::move(body); }
+  /**
+   * 设置了 mapped_body 时，body 被忽略，映射的内存与头部一起发送。
+   */
+  [[nodiscard]] auto& mapped_body() const { return mapped_body_; }
+  void set_mapped_body(std::shared_ptr<const MappedFile> mapped_body) {
+    mapped_body_ = std::move(mapped_body);
+  }
+  /**
+   * 设置了 file_body 时，body 和 mapped_body 被忽略，响应体在头部发送之后通过
+   * sendfile 发送。
+   */
+  [[nodiscard]] auto& file_body() const { return file_body_; }
+  void set_file_body(FileBody file_body) { file_body_ = std::move(file_body); }
+  /**
+   * 设置了 parts 时，其他响应体都被忽略，各段按顺序发送。
+   */
+  [[nodiscard]] auto& parts() const { return parts_; }
+  void set_parts(std::vector<BodyPart> parts) { parts_ = std::move(parts); }
+
+  /**
+   * 响应体中有需要在头部之后通过 sendfile 发送的内容。
+   */
+  [[nodiscard]] bool HasFileBody() const {
+    return !file_body_.Empty() || !parts_.empty();
+  }
+
+  /**
+   * 响应体的长度，用于设置 Content-Length。
+   */
+  [[nodiscard]] size_t BodySize() const;
 
   static std::string GetDate(const time_t* tloc = nullptr);
+  /**
+   * 当前线程缓存的 Date 值，秒数变化后第一次调用时才重新格式化，同一个工作
+   * 线程上的所有响应共享。返回值在本线程下一次调用之前有效。
+   */
+  static std::string_view CachedDate();
+  /**
+   * Ayaka/{AYAKA_VERSION}。
+   */
+  static std::string_view ServerName();
 
  private:
   std::string version_;
   HttpStatus status_;
-  std::unordered_map<std::string, std::string> headers_;
+  ResponseHeaders headers_;
   // 发送 HTTP 响应时，根据 body 的长度自动设置 Content-Length。
   Body body_;
+  std::shared_ptr<const MappedFile> mapped_body_;
+  FileBody file_body_;
+  std::vector<BodyPart> parts_;
 };
 
 }  // namespace ayaka
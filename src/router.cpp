@@ -17,17 +17,71 @@
 
 #include "router.hpp"
 
+#include <algorithm>
 #include <memory>
 
 namespace ayaka {
 
 std::shared_ptr<HttpHandler> Router::Route(const std::string& path) const {
-  for (const auto& location : locations_) {
-    if (location->Match(path)) {
-      return location->handler();
+  const auto* node = &root_;
+  const auto* best = &root_.prefix;
+  std::string_view rest = path;
+  while (!rest.empty()) {
+    auto i = node->firsts.find(rest.front());
+    if (i == std::string::npos) {
+      return *best;
     }
+    const auto& child = node->children[i];
+    if (!rest.starts_with(child.label)) {
+      return *best;
+    }
+    rest.remove_prefix(child.label.size());
+    node = &child;
+    if (node->prefix) {
+      best = &node->prefix;
+    }
+  }
+  return node->exact ? node->exact : *best;
+}
+
+void Router::AddLocation(const std::shared_ptr<Location>& location) {
+  std::string_view key = location->key();
+  // 与以前的 DirLocation::Match 一致，空的目录不匹配任何路径。
+  if (key.empty() && location->prefix()) {
+    return;
+  }
+  auto* node = &root_;
+  while (!key.empty()) {
+    auto i = node->firsts.find(key.front());
+    if (i == std::string::npos) {
+      node->firsts.push_back(key.front());
+      node = &node->children.emplace_back();
+      node->label = key;
+      break;
+    }
+    auto& child = node->children[i];
+    auto common = static_cast<size_t>(
+        std::mismatch(child.label.begin(), child.label.end(), key.begin(),
+                      key.end())
+            .first -
+        child.label.begin());
+    if (common < child.label.size()) {
+      // 在分叉处拆分节点，原来的节点成为新节点唯一的子节点。
+      auto tail = std::move(child);
+      tail.label.erase(0, common);
+      child = Node();
+      child.label = key.substr(0, common);
+      child.firsts.push_back(tail.label.front());
+      child.children.push_back(std::move(tail));
+    }
+    key.remove_prefix(common);
+    node = &child;
+  }
+
+  auto& handler = location->prefix() ? node->prefix : node->exact;
+  if (!handler) {
+    handler = location->handler();
   }
-  return std::move(std::make_shared<Http404Handler>());
 }
 
 }  // namespace ayaka
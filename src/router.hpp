@@ -19,6 +19,8 @@
 #define AYAKA_SRC_ROUTER_HPP_
 
 #include <memory>
+#include <string>
+#include <string_view>
 #include <vector>
 
 #include "http_except.hpp"
@@ -27,6 +29,10 @@
 
 namespace ayaka {
 
+/**
+ * Router 把所有 Location 的键保存在一棵压缩前缀树（radix tree）中，路由时只需
+ * 从根节点沿着路径向下查找一次，耗时与 Location 的数量无关。
+ */
 class Router {
  public:
   Router() = default;
@@ -37,19 +43,40 @@ class Router {
   ~Router() = default;
 
   /**
-   * 进行 URL 路由，返回匹配到的 HttpHandler 对象。如果没有匹配到，则抛出
-   * Http404Except 异常。当有多个匹配的 Location
-   * 时，则返回第一个（按照添加顺序）。
+   * 进行 URL 路由，返回匹配到的 HttpHandler 对象。如果没有匹配到，则返回
+   * nullptr，由调用者生成 404 响应。与路径相同的 PathLocation 优先，其次是
+   * 键最长的 DirLocation。
    */
   [[nodiscard]] std::shared_ptr<HttpHandler> Route(
       const std::string& path) const;
 
-  void AddLocation(const std::shared_ptr<Location>& location) {
-    locations_.push_back(location);
-  }
+  /**
+   * 把 location 加入前缀树。键相同的 Location 只有先加入的有效。
+   */
+  void AddLocation(const std::shared_ptr<Location>& location);
 
  private:
-  std::vector<std::shared_ptr<Location>> locations_;
+  /**
+   * 前缀树的节点。从根节点到该节点的所有 label 连接起来就是该节点的键。
+   */
+  struct Node {
+    std::string label;
+    /**
+     * 子节点 label 的第一个字节，与 children 一一对应。
+     */
+    std::string firsts;
+    std::vector<Node> children;
+    /**
+     * 键与路径相同时使用的处理器。
+     */
+    std::shared_ptr<HttpHandler> exact;
+    /**
+     * 路径以键开头时使用的处理器。
+     */
+    std::shared_ptr<HttpHandler> prefix;
+  };
+
+  Node root_;
 };
 
 }  // namespace ayaka
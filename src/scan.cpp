@@ -0,0 +1,118 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "scan.hpp"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace ayaka {
+
+namespace detail {
+
+size_t ScanScalar(const char *data, size_t len, char ch1, char ch2) {
+  for (size_t i = 0; i < len; ++i) {
+    if (data[i] == ch1 || data[i] == ch2) {
+      return i;
+    }
+  }
+  return len;
+}
+
+#if defined(__x86_64__)
+
+size_t ScanSse2(const char *data, size_t len, char ch1, char ch2) {
+  auto needle1 = _mm_set1_epi8(ch1);
+  auto needle2 = _mm_set1_epi8(ch2);
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    auto chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    auto eq = _mm_or_si128(_mm_cmpeq_epi8(chunk, needle1),
+                           _mm_cmpeq_epi8(chunk, needle2));
+    auto mask = static_cast<unsigned>(_mm_movemask_epi8(eq));
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return i + ScanScalar(data + i, len - i, ch1, ch2);
+}
+
+__attribute__((target("avx2"))) size_t ScanAvx2(const char *data,
+                                                size_t len, char ch1,
+                                                char ch2) {
+  auto needle1 = _mm256_set1_epi8(ch1);
+  auto needle2 = _mm256_set1_epi8(ch2);
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    auto chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+    auto eq = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, needle1),
+                              _mm256_cmpeq_epi8(chunk, needle2));
+    auto mask = static_cast<unsigned>(_mm256_movemask_epi8(eq));
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  // 剩余不足 32 个字节的部分交给 SSE2。
+  return i + ScanSse2(data + i, len - i, ch1, ch2);
+}
+
+bool CpuHasAvx2() { return __builtin_cpu_supports("avx2") != 0; }
+
+#endif
+
+}  // namespace detail
+
+namespace {
+
+using ScanFn = size_t (*)(const char *, size_t, char, char);
+
+struct ScanImpl {
+  ScanFn fn;
+  const char *name;
+};
+
+ScanImpl SelectScanImpl() {
+#if defined(__x86_64__)
+  if (detail::CpuHasAvx2()) {
+    return {detail::ScanAvx2, "avx2"};
+  }
+  return {detail::ScanSse2, "sse2"};
+#else
+  return {detail::ScanScalar, "scalar"};
+#endif
+}
+
+const ScanImpl &GetScanImpl() {
+  static const auto kImpl = SelectScanImpl();
+  return kImpl;
+}
+
+}  // namespace
+
+size_t ScanFor(std::string_view str, size_t pos, char ch1, char ch2) {
+  if (pos >= str.size()) {
+    return str.size();
+  }
+  return pos + GetScanImpl().fn(str.data() + pos, str.size() - pos, ch1, ch2);
+}
+
+const char *ScanImplName() { return GetScanImpl().name; }
+
+}  // namespace ayaka
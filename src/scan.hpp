@@ -0,0 +1,67 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef AYAKA_SRC_SCAN_HPP_
+#define AYAKA_SRC_SCAN_HPP_
+
+#include <cstddef>
+#include <string_view>
+
+namespace ayaka {
+
+/**
+ * 返回 str 中从 pos 开始第一个等于 ch1 或 ch2 的字符的位置，没有则返回
+ * str.size()。
+ *
+ * 在 x86-64 上根据 CPU 在运行时选择 AVX2 或 SSE2 实现，每次比较 32 或 16 个
+ * 字节，其他平台使用逐字节比较。
+ */
+[[nodiscard]] size_t ScanFor(std::string_view str, size_t pos, char ch1,
+                             char ch2);
+
+[[nodiscard]] inline size_t ScanFor(std::string_view str, size_t pos,
+                                    char ch) {
+  return ScanFor(str, pos, ch, ch);
+}
+
+/**
+ * 运行时选择的实现的名称，用于日志和基准测试。
+ */
+[[nodiscard]] const char *ScanImplName();
+
+namespace detail {
+
+/**
+ * 以下是 ScanFor 的各个实现，data 和 len 是 str 从 pos 开始的部分，返回相对
+ * 于 data 的位置。只用于测试和基准测试。
+ */
+[[nodiscard]] size_t ScanScalar(const char *data, size_t len, char ch1,
+                                char ch2);
+
+#if defined(__x86_64__)
+[[nodiscard]] size_t ScanSse2(const char *data, size_t len, char ch1,
+                              char ch2);
+[[nodiscard]] size_t ScanAvx2(const char *data, size_t len, char ch1,
+                              char ch2);
+[[nodiscard]] bool CpuHasAvx2();
+#endif
+
+}  // namespace detail
+
+}  // namespace ayaka
+
+#endif  // AYAKA_SRC_SCAN_HPP_
@@ -17,6 +17,9 @@
 
 #include "send_pack.hpp"
 
+#include <charconv>
+#include <cstring>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 
@@ -26,6 +29,77 @@ namespace {
 
 thread_local std::unordered_map<uv_write_t*, SendPack*> gSendPackMap;
 
+/**
+ * out 为 nullptr 时只计算长度，用于先确定头部的总长度再一次性分配内存。
+ */
+class HeadWriter {
+ public:
+  explicit HeadWriter(char* out) : out_(out) {}
+
+  [[nodiscard]] auto size() const { return size_; }
+
+  void Append(std::string_view str) {
+    if (out_ != nullptr) {
+      memcpy(out_ + size_, str.data(), str.size());
+    }
+    size_ += str.size();
+  }
+
+ private:
+  char* out_;
+  size_t size_ = 0;
+};
+
+/**
+ * 1xx、204 和 304 响应不能带有 Content-Length。
+ */
+bool NeedContentLength(const HttpStatus& status) {
+  auto code = status.code();
+  return !(code.empty() || code[0] == '1' || code == "204" || code == "304");
+}
+
+void WriteHead(const Response& resp, HeadWriter& writer) {
+  auto line = resp.status().line();
+  if (!line.empty() && resp.version() == "HTTP/1.1") {
+    writer.Append(line);
+  } else {
+    writer.Append(resp.version());
+    writer.Append(" ");
+    writer.Append(resp.status().code());
+    writer.Append(" ");
+    writer.Append(resp.status().msg());
+    writer.Append("\r\n");
+  }
+  resp.headers().ForEach(
+      [&writer](std::string_view name, const std::string& value) {
+        writer.Append(name);
+        writer.Append(": ");
+        writer.Append(value);
+        writer.Append("\r\n");
+      });
+  if (resp.headers().Find(Header::kDate) == nullptr) {
+    writer.Append("Date: ");
+    writer.Append(Response::CachedDate());
+    writer.Append("\r\n");
+  }
+  if (resp.headers().Find(Header::kServer) == nullptr) {
+    writer.Append("Server: ");
+    writer.Append(Response::ServerName());
+    writer.Append("\r\n");
+  }
+  if (resp.headers().Find(Header::kContentLength) == nullptr &&
+      NeedContentLength(resp.status())) {
+    char buf[24];
+    auto result = std::to_chars(buf, buf + sizeof(buf), resp.BodySize());
+    writer.Append(HeaderName(Header::kContentLength));
+    writer.Append(": ");
+    writer.Append({buf, static_cast<size_t>(result.ptr - buf)});
+    writer.Append("\r\n");
+  }
+  // HTTP headers 后要加一个空行。
+  writer.Append("\r\n");
+}
+
 }  // namespace
 
 SendPack::SendPack(SendPack&& other) noexcept
@@ -48,91 +122,88 @@ SendPack& SendPack::operator=(SendPack&& other) noexcept {
 
 void SendPack::UvOnWrite(uv_write_t* req, int status) {
   auto* send_pack = gSendPackMap.at(req);
-  send_pack->on_finish_(status);
+  // 回调中可能会释放 send_pack，所以先拷贝一份。
+  auto on_finish = send_pack->on_finish_;
+  on_finish(status);
 }
 
 SendRespPack::SendRespPack() { gSendPackMap[uv_write_] = this; }
 
-SendRespPack::SendRespPack(std::shared_ptr<Response> resp)
-    : resp_(std::move(resp)) {
+SendRespPack::SendRespPack(std::shared_ptr<Response> resp, BufPool* pool)
+    : SendRespPack(std::vector<std::shared_ptr<Response>>{std::move(resp)},
+                   pool) {}
+
+SendRespPack::SendRespPack(std::vector<std::shared_ptr<Response>> resps,
+                           BufPool* pool)
+    : resps_(std::move(resps)) {
   uv_write_ = new uv_write_t;
   gSendPackMap[uv_write_] = this;
-  SetUpBufs();
+  SetUpBufs(pool);
 }
 
 SendRespPack::~SendRespPack() { gSendPackMap.erase(uv_write_); }
 
-void SendRespPack::SetUpBufs() {
-  AddVersionBufs();
-  AddStatusCodeBufs();
-  AddStatusMsgBufs();
-  AddHeadersBufs();
-
-  // HTTP headers 后要加一个空行。
-  uv_buf_t buf;
-  buf.base = const_cast<char*>("\r\n");
-  buf.len = 2;
-  bufs_.push_back(buf);
-
-  AddBodyBufs();
-}
-
-void SendRespPack::AddVersionBufs() {
-  uv_buf_t buf;
-  buf.base = const_cast<char*>(resp_->version().c_str());
-  buf.len = resp_->version().size();
-  bufs_.push_back(buf);
-  buf.base = const_cast<char*>(" ");
-  buf.len = 1;
-  bufs_.push_back(buf);
-}
+void SendRespPack::SetUpBufs(BufPool* pool) {
+  // Date 的长度是固定的，两次调用 WriteHead 之间秒数变化不影响总长度。
+  HeadWriter counter(nullptr);
+  for (const auto& resp : resps_) {
+    WriteHead(*resp, counter);
+  }
+  char* head = nullptr;
+  if (pool != nullptr && counter.size() <= pool->buf_size()) {
+    head = pool->Acquire();
+    head_ref_ = BufRef(*pool, head);
+    pool->Release(head);
+  } else {
+    head_.resize(counter.size());
+    head = head_.data();
+  }
 
-void SendRespPack::AddStatusCodeBufs() {
-  uv_buf_t buf;
-  buf.base = const_cast<char*>(resp_->status().code().c_str());
-  buf.len = resp_->status().code().size();
-  bufs_.push_back(buf);
-  buf.base = const_cast<char*>(" ");
-  buf.len = 1;
-  bufs_.push_back(buf);
+  HeadWriter writer(head);
+  for (const auto& resp : resps_) {
+    auto begin = writer.size();
+    WriteHead(*resp, writer);
+    AddBuf(head + begin, writer.size() - begin);
+    // 文件响应体由 Tcp::SendFile 发送，多段响应体在这里只发送第一段的 data。
+    if (!resp->parts().empty()) {
+      const auto& data = resp->parts().front().data;
+      if (!data.empty()) {
+        AddBuf(data.data(), data.size());
+      }
+      continue;
+    }
+    if (resp->file_body().file()) {
+      continue;
+    }
+    if (const auto& mapped = resp->mapped_body()) {
+      // 直接指向映射的内存，resps_ 保证映射在发送完成之前有效。
+      AddBuf(mapped->data(), mapped->size());
+    } else if (resp->body() && !resp->body()->empty()) {
+      AddBuf(resp->body()->data(), resp->body()->size());
+    }
+  }
 }
 
-void SendRespPack::AddStatusMsgBufs() {
+SendBufPack::SendBufPack(std::shared_ptr<Response> resp, std::string_view data)
+    : resp_(std::move(resp)) {
+  uv_write_ = new uv_write_t;
+  gSendPackMap[uv_write_] = this;
   uv_buf_t buf;
-  buf.base = const_cast<char*>(resp_->status().msg().c_str());
-  buf.len = resp_->status().msg().size();
-  bufs_.push_back(buf);
-  buf.base = const_cast<char*>("\r\n");
-  buf.len = 2;
+  buf.base = const_cast<char*>(data.data());
+  buf.len = data.size();
   bufs_.push_back(buf);
 }
 
-void SendRespPack::AddHeadersBufs() {
-  for (const auto& header : resp_->headers()) {
-    uv_buf_t buf;
-    buf.base = const_cast<char*>(header.first.c_str());
-    buf.len = header.first.size();
-    bufs_.push_back(buf);
-    buf.base = const_cast<char*>(": ");
-    buf.len = 2;
-    bufs_.push_back(buf);
-    buf.base = const_cast<char*>(header.second.c_str());
-    buf.len = header.second.size();
-    bufs_.push_back(buf);
-    buf.base = const_cast<char*>("\r\n");
-    buf.len = 2;
-    bufs_.push_back(buf);
-  }
-}
+SendBufPack::~SendBufPack() { gSendPackMap.erase(uv_write_); }
 
-void SendRespPack::AddBodyBufs() {
-  if (!resp_->body() || resp_->body()->empty()) {
+void SendRespPack::AddBuf(const char* base, size_t len) {
+  if (!bufs_.empty() && bufs_.back().base + bufs_.back().len == base) {
+    bufs_.back().len += len;
     return;
   }
-
   uv_buf_t buf;
-  buf.base = const_cast<char*>(resp_->body()->data());
-  buf.len = resp_->body()->size();
+  buf.base = const_cast<char*>(base);
+  buf.len = len;
   bufs_.push_back(buf);
 }
 
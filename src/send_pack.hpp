@@ -21,7 +21,11 @@
 #include <uv.h>
 
 #include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
 
+#include "buf_pool.hpp"
 #include "response.hpp"
 
 namespace ayaka {
@@ -66,11 +70,29 @@ class SendPack {
   OnFinishCb on_finish_;
 };
 
+/**
+ * SendRespPack 可以包含多个 HTTP 响应，这些响应按顺序通过一次 uv_write 发送。
+ *
+ * 所有响应的起始行和头部被依次写入同一块连续的内存，每个响应体作为单独的
+ * uv_buf_t，因此 n 个响应最多需要 2n 个 uv_buf_t。没有设置 Content-Length
+ * 的响应会根据 BodySize() 自动添加，1xx、204 和 304 响应除外。
+ */
 class SendRespPack : public SendPack {
  public:
   SendRespPack();
 
-  explicit SendRespPack(std::shared_ptr<Response> resp);
+  /**
+   * 头部能够放入 pool 的一个缓冲区时使用 pool，否则单独分配内存。pool 可以为
+   * nullptr，否则必须比 SendRespPack 存活得更久。
+   */
+  explicit SendRespPack(std::shared_ptr<Response> resp,
+                        BufPool *pool = nullptr);
+
+  /**
+   * resps 不能为空。
+   */
+  explicit SendRespPack(std::vector<std::shared_ptr<Response>> resps,
+                        BufPool *pool = nullptr);
 
   /**
    * SendRespPack 只能被移动，不能被拷贝。
@@ -83,16 +105,45 @@ class SendRespPack : public SendPack {
 
   ~SendRespPack() override;
 
-  [[nodiscard]] auto resp() const { return resp_; }
+  /**
+   * 返回第一个响应。
+   */
+  [[nodiscard]] std::shared_ptr<Response> resp() const {
+    return resps_.empty() ? nullptr : resps_.front();
+  }
+  [[nodiscard]] auto &resps() const { return resps_; }
 
  private:
-  void SetUpBufs();
-  void AddVersionBufs();
-  void AddStatusCodeBufs();
-  void AddStatusMsgBufs();
-  void AddHeadersBufs();
-  void AddBodyBufs();
+  void SetUpBufs(BufPool *pool);
+  /**
+   * 与上一个 uv_buf_t 相邻时合并。
+   */
+  void AddBuf(const char *base, size_t len);
+
+  std::vector<std::shared_ptr<Response>> resps_;
+  // 头部位于 head_ref_ 引用的缓冲区或者 head_ 中。
+  BufRef head_ref_;
+  std::vector<char> head_;
+};
 
+/**
+ * 发送 resp 所持有的一段数据，例如多段响应体中第一段之后各段的 data。resp
+ * 保证 data 在发送完成之前有效。
+ */
+class SendBufPack : public SendPack {
+ public:
+  SendBufPack(std::shared_ptr<Response> resp, std::string_view data);
+
+  /**
+   * SendBufPack 只能被移动，不能被拷贝。
+   */
+  SendBufPack(const SendBufPack &) = delete;
+  SendBufPack &operator=(const SendBufPack &) = delete;
+  SendBufPack(SendBufPack &&) noexcept = default;
+  SendBufPack &operator=(SendBufPack &&) noexcept = default;
+  ~SendBufPack() override;
+
+ private:
   std::shared_ptr<Response> resp_;
 };
 
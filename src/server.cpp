@@ -25,7 +25,11 @@
 #include <utility>
 
 #include "case.hpp"
+#include "compress_cache.hpp"
+#include "compression.hpp"
+#include "content_cache.hpp"
 #include "error.hpp"
+#include "file_cache.hpp"
 #include "inet_addr.hpp"
 #include "location.hpp"
 #include "logger.hpp"
@@ -37,15 +41,26 @@ Server::Server(Conf conf)
     : conf_(std::move(conf)), router_(std::make_shared<Router>()) {
   mime_ = std::make_shared<Mime>();
   mime_->Load(conf_.http().mime());
+  FileCache::SetLocalDefault(
+      conf_.http().open_file_cache_size(),
+      std::chrono::seconds(conf_.http().open_file_cache_valid()),
+      conf_.http().mmap_max_file());
+  ContentCache::SetLocalDefault(conf_.http().content_cache_size(),
+                                conf_.http().content_cache_max_file());
+  CompressOptions compress_options;
+  compress_options.set_level(conf_.http().compression_level());
+  compress_options.set_min_size(conf_.http().compression_min_size());
+  compress_options.set_max_size(conf_.http().compression_max_size());
+  CompressOptions::SetGlobal(compress_options);
+  CompressCache::SetLocalDefault(conf_.http().compress_cache_size());
 
   LiftFdLimit();
   SetUpRouter();
 
-  auto listen_addr = conf_.server().listen().ToInetAddr();
   auto worker_threads = conf_.server().worker_threads();
 
   for (int i = 0; i < worker_threads; ++i) {
-    workers_.push_back(std::make_shared<Worker>(listen_addr, router_));
+    workers_.push_back(std::make_shared<Worker>(conf_.server(), router_));
   }
 }
 
@@ -17,15 +17,405 @@
 
 #include "static_handler.hpp"
 
-#include <fcntl.h>
-#include <unistd.h>
-
+#include <cinttypes>
+#include <cstdio>
 #include <filesystem>
+#include <functional>
+#include <random>
 #include <string>
 #include <system_error>
+#include <vector>
+
+#include "compress_cache.hpp"
+#include "compression.hpp"
+#include "conditional.hpp"
+#include "content_cache.hpp"
+#include "encoding.hpp"
+#include "file.hpp"
+#include "file_cache.hpp"
+#include "range.hpp"
 
 namespace ayaka {
 
+namespace {
+
+/**
+ * cached 是否可能在运行时被压缩。这样的文件即使不压缩，响应也取决于
+ * Accept-Encoding。
+ */
+bool MayCompress(const CachedFile& cached) {
+  return cached.encoding() == Encoding::kIdentity &&
+         Compressible(cached.mime()) &&
+         CompressOptions::Global().Admit(cached.file()->size());
+}
+
+/**
+ * 运行时压缩 cached 使用的编码，不压缩时返回 kIdentity。范围总是针对未压缩
+ * 的内容，因此请求范围时不压缩。
+ */
+Encoding RuntimeEncoding(const Request& req, const CachedFile& cached) {
+  if (!MayCompress(cached) || req.headers().Find(Header::kRange) != nullptr) {
+    return Encoding::kIdentity;
+  }
+  const auto* accept = req.headers().Find(Header::kAcceptEncoding);
+  return accept == nullptr ? Encoding::kIdentity : SelectCompression(*accept);
+}
+
+/**
+ * 设置 Accept-Ranges、ETag 和 Last-Modified，encoding 是运行时压缩使用的编码。
+ * 如果 req 的条件表明客户端的副本仍然有效，则生成没有响应体的 304 响应并返回
+ * true。
+ */
+bool SetValidators(const Request& req, const CachedFile& cached,
+                   Encoding encoding, Response& resp) {
+  auto& headers = resp.headers();
+  if (cached.vary() || MayCompress(cached)) {
+    headers[Header::kVary] = "Accept-Encoding";
+  }
+  if (encoding == Encoding::kIdentity) {
+    encoding = cached.encoding();
+    headers[Header::kETag] = cached.etag();
+  } else {
+    // 压缩后的内容与原文件不同，需要不同的强 ETag。
+    headers[Header::kETag] = CompressedETag(cached.etag(), encoding);
+  }
+  if (encoding != Encoding::kIdentity) {
+    headers[Header::kContentEncoding] = EncodingName(encoding);
+  }
+  headers[Header::kAcceptRanges] = "bytes";
+  headers[Header::kLastModified] = cached.last_modified();
+  if (!NotModified(req, headers[Header::kETag], cached.file()->mtime())) {
+    return false;
+  }
+  resp.set_status(HttpStatus::NotModified());
+  return true;
+}
+
+/**
+ * multipart/byteranges 的分隔符。每个线程从随机数开始递增，同一个分隔符出现在
+ * 文件内容中的可能性可以忽略。
+ */
+std::string MakeBoundary() {
+  thread_local uint64_t counter = std::random_device()();
+  char buf[24];
+  auto len = snprintf(buf, sizeof(buf), "%016" PRIx64, ++counter);
+  return {buf, static_cast<size_t>(len)};
+}
+
+/**
+ * 多个范围使用 multipart/byteranges，每个范围的头部保存在对应 BodyPart 的 data
+ * 中，最后一段只有结尾的分隔符。
+ */
+void SetMultipart(const std::vector<ByteRange>& ranges,
+                  const CachedFile& cached, Response& resp) {
+  const auto& file = cached.file();
+  auto boundary = MakeBoundary();
+  resp.headers()[Header::kContentType] =
+      "multipart/byteranges; boundary=" + boundary;
+  std::vector<BodyPart> parts;
+  parts.reserve(ranges.size() + 1);
+  for (const auto& range : ranges) {
+    std::string data = parts.empty() ? "--" : "\r\n--";
+    data += boundary;
+    data += "\r\nContent-Type: ";
+    data += cached.mime();
+    data += "\r\nContent-Range: ";
+    data += ContentRange(range, file->size());
+    data += "\r\n\r\n";
+    parts.push_back(
+        {std::move(data),
+         FileBody(file, static_cast<off_t>(range.offset), range.length)});
+  }
+  parts.push_back({"\r\n--" + boundary + "--\r\n", FileBody()});
+  resp.set_parts(std::move(parts));
+}
+
+/**
+ * 处理 Range 请求。只返回请求的范围时生成 206 或 416 响应并返回 true，范围内
+ * 的内容在发送时通过 sendfile 直接从文件读取，不经过 ContentCache。
+ */
+bool SetRange(const Request& req, const CachedFile& cached, Response& resp) {
+  const auto* value = req.headers().Find(Header::kRange);
+  const auto& file = cached.file();
+  if (value == nullptr || !IfRangeMatch(req, cached.etag(), file->mtime())) {
+    return false;
+  }
+  std::vector<ByteRange> ranges;
+  switch (ParseRange(*value, file->size(), ranges)) {
+    case RangeResult::kNone:
+      return false;
+    case RangeResult::kUnsatisfiable:
+      resp.set_status(HttpStatus::RangeNotSatisfiable());
+      resp.headers()[Header::kContentRange] = UnsatisfiedRange(file->size());
+      return true;
+    case RangeResult::kOk:
+      break;
+  }
+
+  resp.set_status(HttpStatus::PartialContent());
+  if (ranges.size() > 1) {
+    SetMultipart(ranges, cached, resp);
+    return true;
+  }
+  const auto& range = ranges.front();
+  resp.headers()[Header::kContentType] = cached.mime();
+  resp.headers()[Header::kContentRange] = ContentRange(range, file->size());
+  resp.set_file_body(
+      FileBody(file, static_cast<off_t>(range.offset), range.length));
+  return true;
+}
+
+/**
+ * 设置不能放入 ContentCache 的文件的响应体。优先使用 FileCache 缓存项持有的
+ * 映射，否则使用 sendfile 发送。
+ */
+void SetLargeBody(const CachedFile& cached, Response& resp) {
+  if (const auto& mapped = cached.mapped()) {
+    resp.set_mapped_body(mapped);
+    return;
+  }
+  const auto& file = cached.file();
+  resp.set_file_body(FileBody(file, 0, file->size()));
+}
+
+/**
+ * 运行时压缩失败时改为发送未压缩的内容。
+ */
+void ClearEncoding(const CachedFile& cached, Response& resp) {
+  resp.headers().Erase(Header::kContentEncoding);
+  resp.headers()[Header::kETag] = cached.etag();
+}
+
+/**
+ * 使用 cached 设置响应体。小文件的内容从 ContentCache 中获取，直接作为
+ * 共享的响应体；其他文件使用 sendfile 发送。条件请求命中或者请求范围时不读取
+ * 整个文件。
+ *
+ * 需要运行时压缩时，压缩结果从 CompressCache 中获取，每个文件的每个版本只压缩
+ * 一次。
+ */
+void SetBody(const Request& req, const CachedFile& cached,
+             const std::shared_ptr<Response>& resp) {
+  auto encoding = RuntimeEncoding(req, cached);
+  if (SetValidators(req, cached, encoding, *resp) ||
+      SetRange(req, cached, *resp)) {
+    return;
+  }
+  resp->headers()[Header::kContentType] = cached.mime();
+
+  const auto& file = cached.file();
+  if (encoding != Encoding::kIdentity) {
+    auto& compress_cache = CompressCache::Local();
+    auto content = compress_cache.Get(cached.path(), encoding, *file);
+    if (!content) {
+      content = CompressFile(encoding, *file);
+      if (content) {
+        compress_cache.Put(cached.path(), encoding, *file, content);
+      }
+    }
+    if (content) {
+      resp->set_body(std::move(content));
+      return;
+    }
+    ClearEncoding(cached, *resp);
+  }
+
+  auto& cache = ContentCache::Local();
+  if (cache.Admit(*file)) {
+    auto content = cache.Get(cached.path(), *file);
+    if (!content) {
+      content = file->ReadAll();
+      if (content) {
+        cache.Put(cached.path(), *file, content);
+      }
+    }
+    if (content) {
+      resp->set_body(std::move(content));
+      return;
+    }
+  }
+
+  SetLargeBody(cached, *resp);
+}
+
+/**
+ * 与 SetBody 相同，但是在 libuv 的线程池中压缩文件。
+ */
+void SetCompressedAsync(std::shared_ptr<const CachedFile> cached,
+                        Encoding encoding, HttpCompletion completion) {
+  const auto& file = cached->file();
+  auto content = CompressCache::Local().Get(cached->path(), encoding, *file);
+  if (content) {
+    completion.resp()->set_body(std::move(content));
+    completion.Finish();
+    return;
+  }
+
+  auto* loop = completion.loop()->uv_loop();
+  CompressFileAsync(
+      loop, file, encoding,
+      [cached, encoding,
+       completion = std::move(completion)](Response::Body content) {
+        const auto& file = cached->file();
+        const auto& resp = completion.resp();
+        if (content) {
+          CompressCache::Local().Put(cached->path(), encoding, *file,
+                                     content);
+          resp->set_body(std::move(content));
+        } else {
+          ClearEncoding(*cached, *resp);
+          resp->set_file_body(FileBody(file, 0, file->size()));
+        }
+        completion.Finish();
+      });
+}
+
+/**
+ * 与 SetBody 相同，但是在 libuv 的线程池中读取文件内容，之后完成 completion。
+ */
+void SetBodyAsync(std::shared_ptr<const CachedFile> cached,
+                  HttpCompletion completion) {
+  const auto& resp = completion.resp();
+  const auto& req = *completion.req();
+  auto encoding = RuntimeEncoding(req, *cached);
+  if (SetValidators(req, *cached, encoding, *resp) ||
+      SetRange(req, *cached, *resp)) {
+    completion.Finish();
+    return;
+  }
+  resp->headers()[Header::kContentType] = cached->mime();
+  if (encoding != Encoding::kIdentity) {
+    SetCompressedAsync(std::move(cached), encoding, std::move(completion));
+    return;
+  }
+
+  const auto& file = cached->file();
+  auto& cache = ContentCache::Local();
+  if (!cache.Admit(*file)) {
+    SetLargeBody(*cached, *resp);
+    completion.Finish();
+    return;
+  }
+  auto content = cache.Get(cached->path(), *file);
+  if (content) {
+    resp->set_body(std::move(content));
+    completion.Finish();
+    return;
+  }
+
+  auto* loop = completion.loop()->uv_loop();
+  File::ReadAllAsync(loop, file,
+                     [cached, completion = std::move(completion)](
+                         std::shared_ptr<std::vector<char>> content) {
+                       const auto& file = cached->file();
+                       const auto& resp = completion.resp();
+                       if (content) {
+                         ContentCache::Local().Put(cached->path(), *file,
+                                                   content);
+                         resp->set_body(std::move(content));
+                       } else {
+                         resp->set_file_body(FileBody(file, 0, file->size()));
+                       }
+                       completion.Finish();
+                     });
+}
+
+/**
+ * 根据 Accept-Encoding 选择 cached 的变体，没有可用的变体时返回 cached。
+ */
+std::shared_ptr<const CachedFile> SelectVariant(
+    const Request& req, std::shared_ptr<const CachedFile> cached) {
+  if (!cached->vary()) {
+    return cached;
+  }
+  const auto* accept = req.headers().Find(Header::kAcceptEncoding);
+  if (accept == nullptr) {
+    return cached;
+  }
+  auto accepted = AcceptedEncodings(*accept);
+  for (size_t i = 0; i < kEncodings; ++i) {
+    auto encoding = static_cast<Encoding>(i);
+    const auto& variant = cached->variant(encoding);
+    if (variant && (accepted & EncodingBit(encoding)) != 0) {
+      return variant;
+    }
+  }
+  return cached;
+}
+
+/**
+ * 中等大小的文件放不进 ContentCache，如果 FileCache 允许，映射到内存后随缓存项
+ * 一起缓存，之后的响应直接发送映射的内存。
+ */
+void MapFile(CachedFile& cached) {
+  const auto& file = *cached.file();
+  if (!ContentCache::Local().Admit(file) && FileCache::Local().Mappable(file)) {
+    cached.Map();
+  }
+}
+
+/**
+ * 创建 path 对应的缓存项，并在需要时映射文件。
+ */
+std::shared_ptr<CachedFile> MakeCachedFile(
+    std::string path, std::shared_ptr<File> file, std::string mime,
+    Encoding encoding = Encoding::kIdentity) {
+  auto cached =
+      encoding == Encoding::kIdentity
+          ? std::make_shared<CachedFile>(std::move(path), std::move(file),
+                                         std::move(mime))
+          : std::make_shared<CachedFile>(std::move(path), std::move(file),
+                                         std::move(mime), encoding);
+  MapFile(*cached);
+  return cached;
+}
+
+/**
+ * 打开 cached 旁边的预压缩文件，例如 foo.js.br，作为 cached 的变体。
+ */
+void OpenVariants(CachedFile& cached) {
+  for (size_t i = 0; i < kEncodings; ++i) {
+    auto encoding = static_cast<Encoding>(i);
+    auto path = cached.path() + std::string(EncodingSuffix(encoding));
+    if (auto file = File::Open(path)) {
+      cached.set_variant(encoding,
+                         MakeCachedFile(path, file, cached.mime(), encoding));
+    }
+  }
+}
+
+/**
+ * 与 OpenVariants 相同，但是在 libuv 的线程池中依次打开各个变体，完成后在
+ * 事件循环线程中调用 done。
+ */
+void OpenVariantsAsync(uv_loop_t* loop, std::shared_ptr<CachedFile> cached,
+                       std::function<void(std::shared_ptr<CachedFile>)> done,
+                       size_t index = 0) {
+  if (index == kEncodings) {
+    done(std::move(cached));
+    return;
+  }
+  auto encoding = static_cast<Encoding>(index);
+  auto path = cached->path() + std::string(EncodingSuffix(encoding));
+  File::OpenAsync(loop, path,
+                  [loop, path, encoding, index, cached = std::move(cached),
+                   done = std::move(done)](std::shared_ptr<File> file) {
+                    if (file) {
+                      cached->set_variant(
+                          encoding,
+                          MakeCachedFile(path, file, cached->mime(), encoding));
+                    }
+                    OpenVariantsAsync(loop, cached, done, index + 1);
+                  });
+}
+
+const std::string& MimeOf(const Mime& mime, const std::filesystem::path& path) {
+  std::string ext = path.extension().string();
+  return ext.empty() ? mime.GetMime("") : mime.GetMime(ext.substr(1));
+}
+
+}  // namespace
+
 StaticPathHandler::StaticPathHandler(std::string path,
                                      const std::shared_ptr<Mime>& mime) {
   auto p = std::filesystem::path(std::move(path));
@@ -49,52 +439,149 @@ StaticDirHandler::StaticDirHandler(std::string url, std::string root,
 
 void StaticPathHandler::DoGet(const std::shared_ptr<Request>& req,
                               std::shared_ptr<Response>& resp) {
-  resp->headers()["Content-Type"] = mime_;
-  try {
-    auto file_size = std::filesystem::file_size(path_);
-    resp->body() = std::make_shared<std::vector<char>>(file_size);
-    auto fd = open(path_.c_str(), O_RDONLY);
-    if (fd == -1) {
-      throw Http404Except(req->method(), req->url().src());
-    }
-    auto read_size = read(fd, resp->body()->data(), file_size);
-    if (read_size == -1) {
-      throw Http404Except(req->method(), req->url().src());
+  auto& cache = FileCache::Local();
+  auto cached = cache.Get(path_.string());
+  if (!cached) {
+    auto file = File::Open(path_.string());
+    if (!file) {
+      SetUpError(*resp, HttpError::kNotFound);
+      return;
     }
-  } catch (const std::filesystem::filesystem_error& except) {
-    throw Http404Except(req->method(), req->url().src());
+    cached = MakeCachedFile(path_.string(), file, mime_);
+    cache.Put(path_.string(), cached);
+  }
+
+  SetBody(*req, *cached, resp);
+}
+
+void StaticPathHandler::HandleAsync(const std::shared_ptr<Request>& req,
+                                    HttpCompletion completion) {
+  if (req->method_id() != HttpMethod::kGet) {
+    HttpHandler::HandleAsync(req, std::move(completion));
+    return;
   }
+
+  auto key = path_.string();
+  auto* loop = completion.loop()->uv_loop();
+  FileCache::Local().GetAsync(
+      loop, key,
+      [loop, key, mime = mime_, completion = std::move(completion)](
+          std::shared_ptr<const CachedFile> cached) {
+        if (cached) {
+          SetBodyAsync(std::move(cached), completion);
+          return;
+        }
+        File::OpenAsync(loop, key,
+                        [key, mime, completion](std::shared_ptr<File> file) {
+                          if (!file) {
+                            completion.Fail(HttpError::kNotFound);
+                            return;
+                          }
+                          auto cached = MakeCachedFile(key, file, mime);
+                          FileCache::Local().Put(key, cached);
+                          SetBodyAsync(std::move(cached), completion);
+                        });
+      });
+}
+
+std::string StaticDirHandler::Resolve(const Request& req) const {
+  auto relative =
+      std::filesystem::path(req.url().path()).lexically_relative(url_);
+  return (root_ / relative).lexically_normal().string();
 }
 
 void StaticDirHandler::DoGet(const std::shared_ptr<Request>& req,
                              std::shared_ptr<Response>& resp) {
-  try {
-    auto relative =
-        std::filesystem::path(req->url().path()).lexically_relative(url_);
-    auto path = (root_ / relative).lexically_normal();
-    if (std::filesystem::is_directory(path)) {
-      path /= "index.html";
-    }
+  auto path = Resolve(*req);
 
-    std::string ext = path.extension().string();
-    if (ext.empty()) {
-      resp->headers()["Content-Type"] = mime_->GetMime("");
-    } else {
-      resp->headers()["Content-Type"] = mime_->GetMime(ext.substr(1));
+  // 缓存命中时不需要任何与路径相关的系统调用。
+  auto& cache = FileCache::Local();
+  auto cached = cache.Get(path);
+  if (!cached) {
+    cached = Open(path);
+    if (!cached) {
+      SetUpError(*resp, HttpError::kNotFound);
+      return;
     }
+    cache.Put(path, cached);
+  }
+
+  SetBody(*req, *SelectVariant(*req, std::move(cached)), resp);
+}
+
+void StaticDirHandler::HandleAsync(const std::shared_ptr<Request>& req,
+                                   HttpCompletion completion) {
+  if (req->method_id() != HttpMethod::kGet) {
+    HttpHandler::HandleAsync(req, std::move(completion));
+    return;
+  }
+
+  auto path = Resolve(*req);
+  auto* loop = completion.loop()->uv_loop();
+  // 打开成功后打开预压缩的变体，之后缓存并设置响应体。
+  auto serve = [loop, path, mime = mime_, completion](
+                   const std::string& file_path, std::shared_ptr<File> file) {
+    auto cached =
+        MakeCachedFile(file_path, std::move(file), MimeOf(*mime, file_path));
+    OpenVariantsAsync(loop, std::move(cached),
+                      [path, completion](std::shared_ptr<CachedFile> cached) {
+                        FileCache::Local().Put(path, cached);
+                        SetBodyAsync(
+                            SelectVariant(*completion.req(), std::move(cached)),
+                            completion);
+                      });
+  };
+  // 不是普通文件时，尝试打开目录中的 index.html。
+  auto open = [loop, path, completion, serve]() {
+    File::OpenAsync(loop, path, [loop, path, completion,
+                                 serve](std::shared_ptr<File> file) {
+      if (file) {
+        serve(path, std::move(file));
+        return;
+      }
+      auto index = (std::filesystem::path(path) / "index.html").string();
+      File::OpenAsync(
+          loop, index,
+          [index, completion, serve](std::shared_ptr<File> file) {
+            if (!file) {
+              completion.Fail(HttpError::kNotFound);
+              return;
+            }
+            serve(index, std::move(file));
+          });
+    });
+  };
+  FileCache::Local().GetAsync(
+      loop, path,
+      [completion, open](std::shared_ptr<const CachedFile> cached) {
+        if (cached) {
+          SetBodyAsync(SelectVariant(*completion.req(), std::move(cached)),
+                       completion);
+          return;
+        }
+        open();
+      });
+}
 
-    auto file_size = std::filesystem::file_size(path);
-    resp->body() = std::make_shared<std::vector<char>>(file_size);
-    auto fd = open(path.c_str(), O_RDONLY);
-    if (fd == -1) {
-      throw Http404Except(req->method(), req->url().src());
+std::shared_ptr<CachedFile> StaticDirHandler::Open(
+    const std::string& path) const {
+  try {
+    auto file_path = std::filesystem::path(path);
+    if (std::filesystem::is_directory(file_path)) {
+      file_path /= "index.html";
     }
-    auto read_size = read(fd, resp->body()->data(), file_size);
-    if (read_size == -1) {
-      throw Http404Except(req->method(), req->url().src());
+
+    auto file = File::Open(file_path.string());
+    if (!file) {
+      return nullptr;
     }
+
+    auto cached = MakeCachedFile(file_path.string(), file,
+                                 MimeOf(*mime_, file_path));
+    OpenVariants(*cached);
+    return cached;
   } catch (const std::filesystem::filesystem_error& except) {
-    throw Http404Except(req->method(), req->url().src());
+    return nullptr;
   }
 }
 
@@ -21,6 +21,7 @@
 #include <memory>
 #include <string>
 
+#include "file_cache.hpp"
 #include "http_handler.hpp"
 #include "mime.hpp"
 
@@ -45,11 +46,21 @@ class StaticPathHandler : public HttpHandler {
   void DoGet(const std::shared_ptr<Request>& req,
              std::shared_ptr<Response>& resp) override;
 
+  /**
+   * GET 请求在 libuv 的线程池中打开和读取文件，其他请求同 HttpHandler。
+   */
+  void HandleAsync(const std::shared_ptr<Request>& req,
+                   HttpCompletion completion) override;
+
  private:
   std::filesystem::path path_;
   std::string mime_;
 };
 
+/**
+ * 如果文件旁边有预压缩的版本（.br、.zst 或 .gz），根据 Accept-Encoding 选择
+ * 其中之一发送，并设置 Content-Encoding 和 Vary。
+ */
 class StaticDirHandler : public HttpHandler {
  public:
   /**
@@ -62,7 +73,23 @@ class StaticDirHandler : public HttpHandler {
   void DoGet(const std::shared_ptr<Request>& req,
              std::shared_ptr<Response>& resp) override;
 
+  /**
+   * GET 请求在 libuv 的线程池中打开和读取文件，其他请求同 HttpHandler。
+   */
+  void HandleAsync(const std::shared_ptr<Request>& req,
+                   HttpCompletion completion) override;
+
  private:
+  /**
+   * 请求的 URL 对应的本地路径。
+   */
+  [[nodiscard]] std::string Resolve(const Request& req) const;
+  /**
+   * 打开 path 对应的文件及其预压缩的变体，如果 path 是目录，则打开目录中的
+   * index.html。失败时返回 nullptr。
+   */
+  [[nodiscard]] std::shared_ptr<CachedFile> Open(const std::string& path) const;
+
   std::filesystem::path root_;
   std::filesystem::path url_;
   std::shared_ptr<Mime> mime_;
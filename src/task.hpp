@@ -0,0 +1,214 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef AYAKA_SRC_TASK_HPP_
+#define AYAKA_SRC_TASK_HPP_
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+#include "logger.hpp"
+
+namespace ayaka {
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+template <typename T>
+class TaskPromiseBase {
+ public:
+  /**
+   * 协程结束时恢复等待它的协程。
+   */
+  class FinalAwaiter {
+   public:
+    [[nodiscard]] bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<Promise> handle) noexcept {
+      auto continuation = handle.promise().continuation();
+      return continuation ? continuation : std::noop_coroutine();
+    }
+
+    void await_resume() const noexcept {}
+  };
+
+  std::suspend_always initial_suspend() noexcept { return {}; }
+  FinalAwaiter final_suspend() noexcept { return {}; }
+  void unhandled_exception() { except_ = std::current_exception(); }
+
+  [[nodiscard]] auto continuation() const { return continuation_; }
+  void set_continuation(std::coroutine_handle<> continuation) {
+    continuation_ = continuation;
+  }
+
+  void RethrowIfFailed() const {
+    if (except_) {
+      std::rethrow_exception(except_);
+    }
+  }
+
+ private:
+  std::coroutine_handle<> continuation_;
+  std::exception_ptr except_;
+};
+
+template <typename T>
+class TaskPromise : public TaskPromiseBase<T> {
+ public:
+  Task<T> get_return_object();
+
+  void return_value(T value) { value_ = std::move(value); }
+
+  T Result() {
+    this->RethrowIfFailed();
+    return std::move(*value_);
+  }
+
+ private:
+  std::optional<T> value_;
+};
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase<void> {
+ public:
+  Task<void> get_return_object();
+
+  void return_void() {}
+
+  void Result() { RethrowIfFailed(); }
+};
+
+}  // namespace detail
+
+/**
+ * 惰性启动的协程。Task 被 co_await 时才开始执行，执行完成后恢复等待它的协程，
+ * 协程中未捕获的异常在 co_await 处重新抛出。
+ *
+ * Task 本身不切换线程：协程在调用 co_await 的线程中开始执行，之后在唤醒它的
+ * 回调所在的线程（通常是事件循环的线程）中继续执行。
+ */
+template <typename T>
+class Task {
+ public:
+  using promise_type = detail::TaskPromise<T>;
+
+  Task() = default;
+
+  explicit Task(std::coroutine_handle<promise_type> handle)
+      : handle_(handle) {}
+
+  /**
+   * Task 只能移动，不能拷贝。
+   */
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+
+  Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+  Task &operator=(Task &&other) noexcept {
+    if (this != &other) {
+      if (handle_) {
+        handle_.destroy();
+      }
+      handle_ = std::exchange(other.handle_, {});
+    }
+    return *this;
+  }
+
+  ~Task() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  [[nodiscard]] bool Done() const { return !handle_ || handle_.done(); }
+
+  auto operator co_await() const noexcept {
+    class Awaiter {
+     public:
+      explicit Awaiter(std::coroutine_handle<promise_type> handle)
+          : handle_(handle) {}
+
+      [[nodiscard]] bool await_ready() const noexcept {
+        return !handle_ || handle_.done();
+      }
+
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<> awaiting) noexcept {
+        handle_.promise().set_continuation(awaiting);
+        return handle_;
+      }
+
+      T await_resume() { return handle_.promise().Result(); }
+
+     private:
+      std::coroutine_handle<promise_type> handle_;
+    };
+    return Awaiter(handle_);
+  }
+
+ private:
+  std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+  return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+  return Task<void>(
+      std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+/**
+ * 立即开始执行、结束后自动销毁的协程，用于实现 Spawn。
+ */
+class DetachedTask {
+ public:
+  class promise_type {
+   public:
+    DetachedTask get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() {
+      AYAKA_LOG_CRITICAL("unhandled exception in a spawned task");
+    }
+  };
+};
+
+inline DetachedTask RunDetached(Task<void> task) { co_await task; }
+
+}  // namespace detail
+
+/**
+ * 在当前线程中开始执行 task，不等待它完成。task 在第一次挂起时 Spawn 返回，
+ * 之后由唤醒它的回调继续执行，完成后自动销毁。task 中未捕获的异常会终止程序。
+ */
+inline void Spawn(Task<void> task) { detail::RunDetached(std::move(task)); }
+
+}  // namespace ayaka
+
+#endif  // AYAKA_SRC_TASK_HPP_
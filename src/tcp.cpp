@@ -17,8 +17,12 @@
 
 #include "tcp.hpp"
 
+#include <sys/sendfile.h>
 #include <sys/socket.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <cstdint>
 #include <utility>
 
 #include "uv.h"
@@ -44,6 +48,7 @@ Tcp::Tcp(Tcp &&other) noexcept
       on_accept_(std::move(other.on_accept_)),
       on_close_(std::move(other.on_close_)),
       on_recv_(std::move(other.on_recv_)),
+      on_send_progress_(std::move(other.on_send_progress_)),
       closed_(other.closed_) {
   other.uv_tcp_ = nullptr;
   other.closed_ = true;
@@ -56,6 +61,7 @@ Tcp &Tcp::operator=(Tcp &&other) noexcept {
     on_accept_ = std::move(other.on_accept_);
     on_close_ = std::move(other.on_close_);
     on_recv_ = std::move(other.on_recv_);
+    on_send_progress_ = std::move(other.on_send_progress_);
     closed_ = other.closed_;
 
     other.uv_tcp_ = nullptr;
@@ -67,6 +73,7 @@ Tcp &Tcp::operator=(Tcp &&other) noexcept {
 Tcp::~Tcp() {
   AYAKA_TERM_IF(!closed_, "Tcp must be closed before destruction");
   gTcpMap.erase(uv_tcp_);
+  delete uv_tcp_;
 }
 
 void Tcp::Bind(const InetAddr &addr) {
@@ -89,8 +96,14 @@ void Tcp::Listen() {
 void Tcp::Send(const std::shared_ptr<SendPack> &send_pack,
                std::function<void()> on_finish) {
   send_packs_[send_pack] = std::move(on_finish);
+  // 捕获 weak_ptr，避免 send_pack 通过自身的回调引用自己而无法释放。
   send_pack->set_on_finish(
-      [this, send_pack](int status) { OnSendFinish(send_pack, status); });
+      [this, weak_pack = std::weak_ptr<SendPack>(send_pack)](int status) {
+        auto pack = weak_pack.lock();
+        if (pack) {
+          OnSendFinish(pack, status);
+        }
+      });
   auto status = uv_write(
       send_pack->uv_write(), reinterpret_cast<uv_stream_t *>(uv_tcp_),
       static_cast<const std::shared_ptr<SendPack> &>(send_pack)->bufs().data(),
@@ -98,6 +111,123 @@ void Tcp::Send(const std::shared_ptr<SendPack> &send_pack,
   AYAKA_TERM_IF(status != 0, "uv_write failed: {}", UvLastError(status));
 }
 
+void Tcp::SendFile(FileBody file_body, std::function<void()> on_finish) {
+  AYAKA_TERM_IF(sending_file_, "another SendFile is in progress");
+  AYAKA_TERM_IF(uv_tcp_->write_queue_size != 0,
+                "SendFile while uv_write is in progress");
+  send_file_body_ = std::move(file_body);
+  on_send_file_finish_ = std::move(on_finish);
+  sending_file_ = true;
+  ContinueSendFile();
+}
+
+void Tcp::ContinueSendFile() {
+  int socket_fd = -1;
+  auto status = uv_fileno(reinterpret_cast<uv_handle_t *>(uv_tcp_), &socket_fd);
+  AYAKA_TERM_IF(status != 0, "uv_fileno failed: {}", UvLastError(status));
+
+  size_t nsent = 0;
+  while (!send_file_body_.Empty()) {
+    if (nsent >= kMaxSendFileBurst) {
+      // 避免一个大文件长时间占用事件循环，等到下一轮循环再继续发送。
+      on_send_progress_();
+      WaitWritable();
+      return;
+    }
+    const auto &file = send_file_body_.file();
+    auto offset = send_file_body_.offset();
+    auto length = send_file_body_.length();
+    auto n = sendfile(socket_fd, file->fd(), &offset,
+                      std::min(length, kMaxSendFileBurst));
+    if (n > 0) {
+      nsent += n;
+      send_file_body_ = FileBody(file, offset, length - n);
+      continue;
+    }
+    if (n == -1 && errno == EINTR) {
+      continue;
+    }
+    if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      if (nsent > 0) {
+        on_send_progress_();
+      }
+      WaitWritable();
+      return;
+    }
+    // n 为 0 表示文件在发送过程中被截断了。
+    AYAKA_LOG_DEBUG("sendfile failed: {}",
+                    n == 0 ? "unexpected end of file" : LastError());
+    Close();
+    return;
+  }
+
+  if (writable_poll_ != nullptr) {
+    uv_poll_stop(writable_poll_);
+  }
+  send_file_body_ = FileBody();
+  sending_file_ = false;
+  auto on_finish = std::move(on_send_file_finish_);
+  on_send_file_finish_ = nullptr;
+  if (on_finish) {
+    on_finish();
+  }
+}
+
+void Tcp::WaitWritable() {
+  if (writable_poll_ == nullptr) {
+    int socket_fd = -1;
+    auto status =
+        uv_fileno(reinterpret_cast<uv_handle_t *>(uv_tcp_), &socket_fd);
+    AYAKA_TERM_IF(status != 0, "uv_fileno failed: {}", UvLastError(status));
+    // libuv 不允许 uv_tcp_t 和 uv_poll_t 使用同一个文件描述符，
+    // 所以监听它的副本。
+    auto poll_fd = dup(socket_fd);
+    if (poll_fd == -1) {
+      AYAKA_LOG_ERROR("dup failed: {}", LastError());
+      Close();
+      return;
+    }
+    writable_poll_ = new uv_poll_t;
+    status = uv_poll_init(loop_->uv_loop(), writable_poll_, poll_fd);
+    AYAKA_TERM_IF(status != 0, "uv_poll_init failed: {}", UvLastError(status));
+    writable_poll_->data = this;
+  }
+  auto status = uv_poll_start(writable_poll_, UV_WRITABLE, OnWritable);
+  AYAKA_TERM_IF(status != 0, "uv_poll_start failed: {}", UvLastError(status));
+}
+
+void Tcp::CloseWritablePoll() {
+  if (writable_poll_ == nullptr) {
+    return;
+  }
+  int poll_fd = -1;
+  uv_fileno(reinterpret_cast<uv_handle_t *>(writable_poll_), &poll_fd);
+  // 关闭后 data 用于保存需要关闭的文件描述符。
+  writable_poll_->data =
+      reinterpret_cast<void *>(static_cast<intptr_t>(poll_fd));
+  uv_close(reinterpret_cast<uv_handle_t *>(writable_poll_),
+           OnWritablePollClose);
+  writable_poll_ = nullptr;
+}
+
+void Tcp::PauseRecv() {
+  if (closed_) {
+    return;
+  }
+  uv_read_stop(reinterpret_cast<uv_stream_t *>(uv_tcp_));
+}
+
+void Tcp::ResumeRecv() {
+  if (closed_ ||
+      (uv_is_closing(reinterpret_cast<uv_handle_t *>(uv_tcp_)) != 0)) {
+    return;
+  }
+  auto status = uv_read_start(reinterpret_cast<uv_stream_t *>(uv_tcp_),
+                              OnAlloc, OnRecv);
+  AYAKA_TERM_IF(status != 0 && status != UV_EALREADY,
+                "uv_read_start failed: {}", UvLastError(status));
+}
+
 std::shared_ptr<Tcp> Tcp::Accept() {
   auto client = std::make_shared<Tcp>(loop_);
   auto status = uv_accept(reinterpret_cast<uv_stream_t *>(uv_tcp_),
@@ -106,11 +236,19 @@ std::shared_ptr<Tcp> Tcp::Accept() {
   return client;
 }
 
+bool Tcp::Closing() const {
+  return closed_ ||
+         (uv_is_closing(reinterpret_cast<uv_handle_t *>(uv_tcp_)) != 0);
+}
+
 void Tcp::Close() {
-  if (closed_ ||
-      (uv_is_closing(reinterpret_cast<uv_handle_t *>(uv_tcp_)) != 0)) {
+  if (Closing()) {
     return;
   }
+  CloseWritablePoll();
+  send_file_body_ = FileBody();
+  on_send_file_finish_ = nullptr;
+  sending_file_ = false;
   uv_close(reinterpret_cast<uv_handle_t *>(uv_tcp_), OnClose);
 }
 
@@ -133,7 +271,8 @@ void Tcp::ReuseAddr() {
 
 void Tcp::OnSendFinish(const std::shared_ptr<SendPack> &send_pack, int status) {
   if (status != 0) {
-    AYAKA_LOG_CRITICAL("uv_write failed: {}", UvLastError(status));
+    AYAKA_LOG_DEBUG("uv_write failed: {}", UvLastError(status));
+    send_packs_.erase(send_pack);
     Close();
     return;
   }
@@ -145,10 +284,11 @@ void Tcp::OnSendFinish(const std::shared_ptr<SendPack> &send_pack, int status) {
   send_packs_.erase(send_pack);
 }
 
-void Tcp::OnAlloc(uv_handle_t * /*handle*/, size_t /*suggested_size*/,
+void Tcp::OnAlloc(uv_handle_t *handle, size_t /*suggested_size*/,
                   uv_buf_t *buf) {
-  buf->base = new char[kDefaultBufSize];
-  buf->len = kDefaultBufSize;
+  auto &buf_pool = static_cast<Loop *>(handle->loop->data)->buf_pool();
+  buf->base = buf_pool.Acquire();
+  buf->len = buf_pool.buf_size();
 }
 
 void Tcp::OnConn(uv_stream_t *server, int status) {
@@ -163,21 +303,41 @@ void Tcp::OnConn(uv_stream_t *server, int status) {
 void Tcp::OnClose(uv_handle_t *handle) {
   auto *listener = gTcpMap.at(reinterpret_cast<uv_tcp_t *>(handle));
   listener->closed_ = true;
-  listener->on_close_();
+  // on_close_ 可能会释放 Tcp 本身。
+  auto on_close = std::move(listener->on_close_);
+  on_close();
 }
 
-void Tcp::OnRecv(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf) {
-  if (nread == 0) {
+void Tcp::OnWritable(uv_poll_t *handle, int status, int /*events*/) {
+  auto *tcp = static_cast<Tcp *>(handle->data);
+  if (status != 0) {
+    AYAKA_LOG_DEBUG("uv_poll failed: {}", UvLastError(status));
+    tcp->Close();
     return;
   }
+  tcp->ContinueSendFile();
+}
+
+void Tcp::OnWritablePollClose(uv_handle_t *handle) {
+  auto poll_fd = static_cast<int>(reinterpret_cast<intptr_t>(handle->data));
+  if (poll_fd != -1) {
+    close(poll_fd);
+  }
+  delete reinterpret_cast<uv_poll_t *>(handle);
+}
+
+void Tcp::OnRecv(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf) {
   auto *tcp = gTcpMap.at(reinterpret_cast<uv_tcp_t *>(stream));
-  if (nread == UV_EOF) {
+  if (nread > 0) {
+    tcp->on_recv_(buf->base, nread);
+  } else if (nread < 0) {
+    // 保持连接时，客户端随时可能关闭或重置连接，这不是服务器的错误。
+    if (nread != UV_EOF) {
+      AYAKA_LOG_DEBUG("uv_read failed: {}", UvLastError(nread));
+    }
     tcp->Close();
-    return;
   }
-  AYAKA_TERM_IF(nread < 0, "uv_tcp_read failed: {}", uv_strerror(nread));
-  tcp->on_recv_(buf->base, nread);
-  delete[] buf->base;
+  static_cast<Loop *>(stream->loop->data)->buf_pool().Release(buf->base);
 }
 
 }  // namespace ayaka
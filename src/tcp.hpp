@@ -26,6 +26,7 @@
 #include <unordered_map>
 
 #include "error.hpp"
+#include "file.hpp"
 #include "inet_addr.hpp"
 #include "loop.hpp"
 #include "send_pack.hpp"
@@ -59,28 +60,63 @@ class Tcp {
 
   ~Tcp();
 
+  [[nodiscard]] auto &loop() const { return loop_; }
+
   [[nodiscard]] auto &on_accept() const { return on_accept_; }
   void set_on_accept(OnAcceptCb on_accept) {
     on_accept_ = std::move(on_accept);
   }
 
   /**
-   * on_close() 在 uv_tcp_ 关闭后调用，用于释放相关资源。
+   * on_close() 在 uv_tcp_ 关闭后调用，用于释放相关资源，可以在其中释放 Tcp
+   * 本身。
    */
   [[nodiscard]] auto &on_close() const { return on_close_; }
   void set_on_close(OnCloseCb on_close) { on_close_ = std::move(on_close); }
 
+  /**
+   * on_recv() 的 buf 是 loop()->buf_pool() 中缓冲区的起始地址，回调返回后
+   * 缓冲区被释放。需要在回调之后继续使用数据时，可以用 BufRef 持有缓冲区。
+   */
   [[nodiscard]] auto &on_recv() const { return on_recv_; }
   void set_on_recv(OnRecvCb on_recv) { on_recv_ = std::move(on_recv); }
 
+  /**
+   * SendFile 在等待 socket 可写之前，如果已经发送了一部分数据，调用
+   * on_send_progress。用于实现发送超时。
+   */
+  [[nodiscard]] auto &on_send_progress() const { return on_send_progress_; }
+  void set_on_send_progress(std::function<void()> on_send_progress) {
+    on_send_progress_ = std::move(on_send_progress);
+  }
+
   [[nodiscard]] auto closed() const { return closed_; }
+  /**
+   * 已经关闭或者正在关闭，此时不能再调用 Send 或 SendFile。
+   */
+  [[nodiscard]] bool Closing() const;
 
-  [[nodiscard]] auto Pending() const { return send_packs_.size(); }
+  [[nodiscard]] auto Pending() const {
+    return send_packs_.size() + (sending_file_ ? 1 : 0);
+  }
 
   void Bind(const InetAddr &addr);
   void Listen();
   void Send(const std::shared_ptr<SendPack> &send_pack,
             std::function<void()> on_finish);
+  /**
+   * 通过 sendfile 发送 file_body 的内容，不将文件读入用户空间。完成后调用
+   * on_finish，发送失败时关闭连接并且不调用 on_finish。
+   *
+   * 调用者需要保证此时没有未完成的 Send 或 SendFile，并且在 on_finish
+   * 被调用之前不再调用 Send 或 SendFile。
+   */
+  void SendFile(FileBody file_body, std::function<void()> on_finish);
+  /**
+   * 暂停和恢复接收数据，用于在待发送的响应过多时对客户端施加背压。
+   */
+  void PauseRecv();
+  void ResumeRecv();
   /**
    * Close 可以重复调用，但是不会有任何效果。
    */
@@ -91,15 +127,21 @@ class Tcp {
   void ReuseAddr();
   [[nodiscard]] std::shared_ptr<Tcp> Accept();
   void OnSendFinish(const std::shared_ptr<SendPack> &send_pack, int status);
+  void ContinueSendFile();
+  void WaitWritable();
+  void CloseWritablePoll();
 
   static void OnAlloc(uv_handle_t *handle, size_t suggested_size,
                       uv_buf_t *buf);
   static void OnClose(uv_handle_t *handle);
   static void OnConn(uv_stream_t *server, int status);
   static void OnRecv(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf);
+  static void OnWritable(uv_poll_t *handle, int status, int events);
+  static void OnWritablePollClose(uv_handle_t *handle);
 
   static constexpr int kDefaultBacklog = 511;
-  static constexpr int kDefaultBufSize = 1024;
+  // 每次连续调用 sendfile 最多发送的字节数，超过后让出事件循环。
+  static constexpr size_t kMaxSendFileBurst = 1024 * 1024;
 
   uv_tcp_t *uv_tcp_ = nullptr;
   std::shared_ptr<Loop> loop_;
@@ -108,6 +150,13 @@ class Tcp {
   OnAcceptCb on_accept_ = [](const std::shared_ptr<Tcp> &) {};
   OnCloseCb on_close_ = []() {};
   OnRecvCb on_recv_ = [](const char *, size_t) {};
+  std::function<void()> on_send_progress_ = []() {};
+  // 剩余待发送的文件内容。
+  FileBody send_file_body_;
+  std::function<void()> on_send_file_finish_;
+  // 监听 socket 可写事件的 uv_poll_t，用于 sendfile 返回 EAGAIN 的情况。
+  uv_poll_t *writable_poll_ = nullptr;
+  bool sending_file_ = false;
   bool closed_ = true;
 };
 
@@ -0,0 +1,161 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "timer_wheel.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "error.hpp"
+
+namespace ayaka {
+
+void WheelTimer::Cancel() {
+  if (wheel_ == nullptr) {
+    return;
+  }
+  auto *wheel = wheel_;
+  Unlink();
+  wheel->OnCancel();
+}
+
+void WheelTimer::Unlink() {
+  prev_->next_ = next_;
+  next_->prev_ = prev_;
+  prev_ = this;
+  next_ = this;
+  wheel_ = nullptr;
+}
+
+TimerWheel::TimerWheel(uv_loop_t *loop, std::chrono::milliseconds tick)
+    : loop_(loop), tick_(tick) {
+  auto status = uv_timer_init(loop_, &uv_timer_);
+  AYAKA_TERM_IF(status < 0, "uv_timer_init() failed: {}", uv_strerror(status));
+  uv_timer_.data = this;
+  start_ = uv_now(loop_);
+}
+
+TimerWheel::~TimerWheel() {
+  for (auto &level : slots_) {
+    for (auto &slot : level) {
+      while (slot.next_ != &slot) {
+        slot.next_->Unlink();
+      }
+    }
+  }
+}
+
+void TimerWheel::Start(WheelTimer &timer, std::chrono::milliseconds timeout,
+                       std::function<void()> on_timeout) {
+  timer.Cancel();
+  if (size_ == 0) {
+    // 没有定时器时 uv_timer_t 是停止的，直接跳到当前的刻度。
+    uv_update_time(loop_);
+    now_ = Elapsed();
+    uv_timer_start(&uv_timer_, UvOnTimer, tick_.count(), tick_.count());
+  }
+
+  auto nticks = (timeout.count() + tick_.count() - 1) / tick_.count();
+  timer.expire_ = now_ + std::max<uint64_t>(nticks, 1);
+  timer.on_timeout_ = std::move(on_timeout);
+  Link(timer);
+  ++size_;
+}
+
+void TimerWheel::Link(WheelTimer &timer) {
+  constexpr uint64_t kMaxTicks = (uint64_t(1) << (kSlotBits * kLevels)) - 1;
+  auto diff = timer.expire_ > now_ ? timer.expire_ - now_ : 0;
+  if (diff > kMaxTicks) {
+    timer.expire_ = now_ + kMaxTicks;
+    diff = kMaxTicks;
+  }
+
+  int level = 0;
+  while (level < kLevels - 1 &&
+         diff >= (uint64_t(1) << (kSlotBits * (level + 1)))) {
+    ++level;
+  }
+  auto index = (std::max(timer.expire_, now_) >> (kSlotBits * level)) &
+               (kSlots - 1);
+  auto &slot = slots_[level][index];
+
+  timer.wheel_ = this;
+  timer.prev_ = slot.prev_;
+  timer.next_ = &slot;
+  slot.prev_->next_ = &timer;
+  slot.prev_ = &timer;
+}
+
+void TimerWheel::OnCancel() {
+  --size_;
+  if (size_ == 0) {
+    uv_timer_stop(&uv_timer_);
+  }
+}
+
+void TimerWheel::Tick() {
+  ++now_;
+
+  // 低层转完一圈时，将高层对应槽中的定时器下放。
+  for (int level = 1; level < kLevels; ++level) {
+    if ((now_ & ((uint64_t(1) << (kSlotBits * level)) - 1)) != 0) {
+      break;
+    }
+    auto index = (now_ >> (kSlotBits * level)) & (kSlots - 1);
+    auto &slot = slots_[level][index];
+    while (slot.next_ != &slot) {
+      auto *timer = slot.next_;
+      timer->Unlink();
+      Link(*timer);
+    }
+  }
+
+  // 先将到期的定时器移到局部链表中，回调中可能会启动或取消其他定时器。
+  auto &slot = slots_[0][now_ & (kSlots - 1)];
+  WheelTimer expired;
+  if (slot.next_ != &slot) {
+    expired.next_ = slot.next_;
+    expired.prev_ = slot.prev_;
+    expired.next_->prev_ = &expired;
+    expired.prev_->next_ = &expired;
+    slot.next_ = &slot;
+    slot.prev_ = &slot;
+  }
+  while (expired.next_ != &expired) {
+    auto *timer = expired.next_;
+    auto on_timeout = std::move(timer->on_timeout_);
+    timer->Cancel();
+    on_timeout();
+  }
+}
+
+uint64_t TimerWheel::Elapsed() const {
+  return (uv_now(loop_) - start_) / tick_.count();
+}
+
+void TimerWheel::UvOnTimer(uv_timer_t *handle) {
+  auto *wheel = static_cast<TimerWheel *>(handle->data);
+  auto elapsed = wheel->Elapsed();
+  while (wheel->now_ < elapsed && wheel->size_ > 0) {
+    wheel->Tick();
+  }
+  if (wheel->size_ == 0) {
+    wheel->now_ = elapsed;
+  }
+}
+
+}  // namespace ayaka
@@ -0,0 +1,145 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef AYAKA_SRC_TIMER_WHEEL_HPP_
+#define AYAKA_SRC_TIMER_WHEEL_HPP_
+
+#include <uv.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+namespace ayaka {
+
+class TimerWheel;
+
+/**
+ * 由 TimerWheel 管理的定时器，通常作为连接等对象的成员。WheelTimer 析构时
+ * 自动取消。
+ */
+class WheelTimer {
+ public:
+  WheelTimer() = default;
+
+  /**
+   * WheelTimer 被链接在 TimerWheel 中，不能被拷贝或移动。
+   */
+  WheelTimer(const WheelTimer &) = delete;
+  WheelTimer &operator=(const WheelTimer &) = delete;
+  WheelTimer(WheelTimer &&) = delete;
+  WheelTimer &operator=(WheelTimer &&) = delete;
+
+  ~WheelTimer() { Cancel(); }
+
+  [[nodiscard]] bool Active() const { return wheel_ != nullptr; }
+
+  /**
+   * 取消定时器。定时器没有启动时什么也不做。
+   */
+  void Cancel();
+
+ private:
+  friend class TimerWheel;
+
+  void Unlink();
+
+  TimerWheel *wheel_ = nullptr;
+  // 到期时 TimerWheel 的刻度。
+  uint64_t expire_ = 0;
+  std::function<void()> on_timeout_;
+  // 同一个槽中的定时器组成双向循环链表，槽本身是链表的哨兵节点。
+  WheelTimer *prev_ = this;
+  WheelTimer *next_ = this;
+};
+
+/**
+ * 分层时间轮。每个事件循环只使用一个 uv_timer_t 驱动所有的 WheelTimer，
+ * 启动和取消定时器的时间复杂度都是 O(1)。
+ *
+ * 时间轮有 kLevels 层，每层 kSlots 个槽，第 0 层的每个槽对应一个刻度 tick。
+ * 较远的定时器放在高层，在低层转完一圈时被下放到低一层。定时器的精度为一个
+ * 刻度。没有定时器时 uv_timer_t 停止，不会使事件循环保持运行。
+ *
+ * 因为实现原因，TimerWheel 只能在事件循环的线程中使用。
+ */
+class TimerWheel {
+ public:
+  explicit TimerWheel(uv_loop_t *loop,
+                      std::chrono::milliseconds tick = kDefaultTick);
+
+  /**
+   * TimerWheel 不能被拷贝或移动。
+   */
+  TimerWheel(const TimerWheel &) = delete;
+  TimerWheel &operator=(const TimerWheel &) = delete;
+  TimerWheel(TimerWheel &&) = delete;
+  TimerWheel &operator=(TimerWheel &&) = delete;
+
+  /**
+   * uv_timer_t 由 Loop 在析构时关闭。
+   */
+  ~TimerWheel();
+
+  [[nodiscard]] auto tick() const { return tick_; }
+  /**
+   * 启动的定时器数量。
+   */
+  [[nodiscard]] auto Size() const { return size_; }
+
+  /**
+   * 在 timeout 之后调用 on_timeout。如果 timer 已经启动，先取消它。
+   */
+  void Start(WheelTimer &timer, std::chrono::milliseconds timeout,
+             std::function<void()> on_timeout);
+
+  static constexpr auto kDefaultTick = std::chrono::milliseconds(100);
+  static constexpr int kSlotBits = 6;
+  static constexpr int kSlots = 1 << kSlotBits;
+  static constexpr int kLevels = 4;
+
+ private:
+  friend class WheelTimer;
+
+  /**
+   * 根据 timer.expire_ 将定时器放入对应的槽。
+   */
+  void Link(WheelTimer &timer);
+  void OnCancel();
+  /**
+   * 前进一个刻度，下放高层的定时器并调用到期的定时器。
+   */
+  void Tick();
+  [[nodiscard]] uint64_t Elapsed() const;
+
+  static void UvOnTimer(uv_timer_t *handle);
+
+  uv_loop_t *loop_;
+  uv_timer_t uv_timer_{};
+  std::chrono::milliseconds tick_;
+  // 创建时 uv_now 的值。
+  uint64_t start_ = 0;
+  // 已经处理到的刻度。
+  uint64_t now_ = 0;
+  size_t size_ = 0;
+  std::array<std::array<WheelTimer, kSlots>, kLevels> slots_;
+};
+
+}  // namespace ayaka
+
+#endif  // AYAKA_SRC_TIMER_WHEEL_HPP_
@@ -20,6 +20,7 @@
 
 #include <filesystem>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -58,7 +59,7 @@ class Url {
    * 支持解析 scheme://host[:port]/path[?query] 或 /path[?query] 形式的
    * URL。path 将会被 std::filesystem::path::lexically_normal 转换。
    */
-  explicit Url(const std::string& url) : src_(url) { Parse(url); }
+  explicit Url(std::string_view url) : src_(url) { Parse(src_); }
 
   Url(const Url&) = default;
   Url& operator=(const Url&) = default;
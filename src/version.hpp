@@ -0,0 +1,26 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef AYAKA_SRC_VERSION_HPP_
+#define AYAKA_SRC_VERSION_HPP_
+
+#define AYAKA_VERSION "0.0.0"
+#define AYAKA_VERSION_MAJOR "0"
+#define AYAKA_VERSION_MINOR "0"
+#define AYAKA_VERSION_PATCH "0"
+
+#endif  // AYAKA_SRC_VERSION_HPP_
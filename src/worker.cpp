@@ -19,18 +19,23 @@
 
 #include <utility>
 
+#include "compress_cache.hpp"
+#include "content_cache.hpp"
+
 namespace ayaka {
 
-Worker::Worker(InetAddr addr, std::shared_ptr<Router> router)
-    : router_(std::move(router)) {
+Worker::Worker(ServerConf conf, std::shared_ptr<Router> router)
+    : conf_(std::move(conf)), router_(std::move(router)) {
   thread_ = std::make_unique<std::thread>(
-      [this, addr = std::move(addr)]() { Run(addr); });
+      [this, addr = conf_.listen().ToInetAddr()]() { Run(addr); });
 }
 
 void Worker::Join() const { thread_->join(); }
 
 void Worker::Run(const InetAddr& addr) {
   loop_ = std::make_shared<Loop>();
+  loop_->buf_pool() =
+      BufPool(conf_.recv_buf_size(), conf_.recv_buf_pool_size());
   listener_ = std::make_unique<Tcp>(loop_);
 
   listener_->set_on_accept(
@@ -39,13 +44,26 @@ void Worker::Run(const InetAddr& addr) {
   listener_->Bind(addr);
   listener_->Listen();
   loop_->Run();
+
+  const auto& buf_pool = loop_->buf_pool();
+  AYAKA_LOG_INFO("recv buffer pool: {} bytes in use, {} allocations",
+                 buf_pool.MemoryUsage(), buf_pool.nallocs());
+  const auto& content_cache = ContentCache::Local();
+  AYAKA_LOG_INFO("content cache: {} hits, {} misses, {} evictions",
+                 content_cache.nhits(), content_cache.nmisses(),
+                 content_cache.nevictions());
+  const auto& compress_cache = CompressCache::Local();
+  AYAKA_LOG_INFO("compress cache: {} hits, {} misses, {} evictions",
+                 compress_cache.nhits(), compress_cache.nmisses(),
+                 compress_cache.nevictions());
 }
 
 void Worker::OnListerAccept(std::shared_ptr<Tcp> tcp) {
-  auto downstream = std::make_shared<Downstream>(tcp, router_);
-  auto res = downstreams_.insert(downstream);
-  const auto& iter = *res.first;
-  iter->tcp()->set_on_close([this, iter]() { downstreams_.erase(iter); });
+  auto downstream = std::make_shared<Downstream>(tcp, router_, conf_);
+  auto* key = downstream.get();
+  // Downstream 持有 Tcp，回调中不能再持有 Downstream，否则形成循环引用。
+  tcp->set_on_close([this, key]() { downstreams_.erase(key); });
+  downstreams_.emplace(key, std::move(downstream));
 }
 
 }  // namespace ayaka
@@ -22,8 +22,9 @@
 #include <memory>
 #include <string>
 #include <thread>
-#include <unordered_set>
+#include <unordered_map>
 
+#include "conf.hpp"
 #include "downstream.hpp"
 #include "inet_addr.hpp"
 #include "logger.hpp"
@@ -35,7 +36,7 @@ namespace ayaka {
 class Worker {
  public:
   Worker() = delete;
-  Worker(InetAddr addr, std::shared_ptr<Router> router);
+  Worker(ServerConf conf, std::shared_ptr<Router> router);
 
   /**
    * Worker 不能被拷贝或移动。
@@ -57,10 +58,11 @@ class Worker {
   void OnListerAccept(std::shared_ptr<Tcp> tcp);
 
   std::unique_ptr<std::thread> thread_;
+  ServerConf conf_;
   std::shared_ptr<Loop> loop_;
   std::unique_ptr<Tcp> listener_;
   std::shared_ptr<Router> router_;
-  std::unordered_set<std::shared_ptr<Downstream>> downstreams_;
+  std::unordered_map<Downstream*, std::shared_ptr<Downstream>> downstreams_;
 };
 
 }  // namespace ayaka
@@ -0,0 +1,158 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sys/socket.h>
+
+#include <atomic>
+#include <awaitable.hpp>
+#include <filesystem>
+#include <fstream>
+#include <task.hpp>
+#include <thread>
+
+#include "test.hpp"
+
+using namespace ayaka;
+using std::filesystem::path;
+
+TEST(AwaitableTest, Sleep) {
+  auto loop = std::make_shared<Loop>();
+  bool done = false;
+  auto start = std::chrono::steady_clock::now();
+  Spawn([](std::shared_ptr<Loop> loop, bool &done) -> Task<void> {
+    co_await Sleep(loop, std::chrono::milliseconds(20));
+    done = true;
+  }(loop, done));
+  EXPECT_FALSE(done);
+  loop->Run();
+  EXPECT_TRUE(done);
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(20));
+}
+
+TEST(AwaitableTest, File) {
+  auto file_path = path(testing::TempDir()) / "ayaka_awaitable.txt";
+  {
+    std::ofstream out(file_path);
+    out << "hello";
+  }
+
+  auto loop = std::make_shared<Loop>();
+  std::string content;
+  bool not_found = false;
+  Spawn([](std::shared_ptr<Loop> loop, path file_path, std::string &content,
+           bool &not_found) -> Task<void> {
+    auto file = co_await OpenFile(loop, file_path.string());
+    auto data = co_await ReadFile(loop, file);
+    content.assign(data->begin(), data->end());
+    not_found = co_await OpenFile(loop, "/path/does/not/exist") == nullptr;
+  }(loop, file_path, content, not_found));
+  loop->Run();
+  EXPECT_EQ(content, "hello");
+  EXPECT_TRUE(not_found);
+
+  std::filesystem::remove(file_path);
+}
+
+TEST(AwaitableTest, SwitchTo) {
+  auto loop = std::make_shared<Loop>();
+  auto loop_thread = std::this_thread::get_id();
+  std::atomic<bool> done = false;
+  std::thread::id resumed_thread;
+
+  std::thread other([&]() {
+    Spawn([](std::shared_ptr<Loop> loop, std::thread::id &resumed_thread,
+             std::atomic<bool> &done) -> Task<void> {
+      co_await SwitchTo(loop);
+      resumed_thread = std::this_thread::get_id();
+      done = true;
+    }(loop, resumed_thread, done));
+  });
+  other.join();
+  // Post 使用的 uv_async_t 不会使事件循环保持运行，需要其他活跃的 handle。
+  Spawn([](std::shared_ptr<Loop> loop) -> Task<void> {
+    co_await Sleep(loop, std::chrono::milliseconds(10));
+  }(loop));
+  while (!done) {
+    loop->Once();
+  }
+  // 协程在 loop 的线程中继续执行。
+  EXPECT_EQ(resumed_thread, loop_thread);
+}
+
+TEST(AwaitableTest, TcpStream) {
+  auto loop = std::make_shared<Loop>();
+  auto server = std::make_shared<Tcp>(loop);
+  InetAddr addr(InetAddr::Family::kIpv4, "127.0.0.1", 8080);
+  server->Bind(addr);
+
+  std::string received;
+  bool finished = false;
+  server->set_on_accept([&](std::shared_ptr<Tcp> tcp) {
+    Spawn([](std::shared_ptr<Tcp> tcp, std::string &received,
+             bool &finished) -> Task<void> {
+      TcpStream stream(std::move(tcp));
+      while (received.size() < 5) {
+        received += co_await stream.Read();
+      }
+      auto resp = Response::Default();
+      std::string hello = "hello";
+      resp->set_body(
+          std::make_shared<std::vector<char>>(hello.begin(), hello.end()));
+      EXPECT_TRUE(
+          co_await stream.Write(std::make_shared<SendRespPack>(resp)));
+      // 客户端关闭连接后返回空字符串。
+      while (!(co_await stream.Read()).empty()) {
+      }
+      EXPECT_TRUE(stream.closed());
+      finished = true;
+    }(std::move(tcp), received, finished));
+  });
+  server->Listen();
+
+  int client_fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr sock_addr{};
+  addr.ToSockAddr(&sock_addr);
+  ASSERT_EQ(connect(client_fd, &sock_addr, sizeof(sockaddr)), 0);
+  ASSERT_EQ(write(client_fd, "hello", 5), 5);
+  std::string resp;
+  while (resp.find("hello") == std::string::npos) {
+    loop->Once();
+    char buf[1024];
+    auto nread = recv(client_fd, buf, sizeof(buf), MSG_DONTWAIT);
+    if (nread > 0) {
+      resp.append(buf, nread);
+    }
+  }
+  EXPECT_EQ(received, "hello");
+  EXPECT_EQ(resp.find("HTTP/1.1 200 OK\r\n"), 0);
+
+  close(client_fd);
+  while (!finished) {
+    loop->Once();
+  }
+  server->Close();
+  while (!server->closed()) {
+    loop->Once();
+  }
+}
+
+int main(int argc, char *argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  ayaka::InitLogger();
+  return RUN_ALL_TESTS();
+}
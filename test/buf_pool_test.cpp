@@ -0,0 +1,81 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <buf_pool.hpp>
+
+#include "test.hpp"
+
+using ayaka::BufPool;
+
+TEST(BufPoolTest, Default) {
+  BufPool pool;
+  EXPECT_EQ(pool.buf_size(), BufPool::kDefaultBufSize);
+  EXPECT_EQ(pool.max_free(), BufPool::kDefaultMaxFree);
+  EXPECT_EQ(pool.nused(), 0);
+  EXPECT_EQ(pool.nfree(), 0);
+  EXPECT_EQ(pool.MemoryUsage(), 0);
+}
+
+TEST(BufPoolTest, Reuse) {
+  BufPool pool(1024, 4);
+  auto *buf1 = pool.Acquire();
+  EXPECT_EQ(pool.nused(), 1);
+  EXPECT_EQ(pool.MemoryUsage(), 1024);
+  pool.Release(buf1);
+  EXPECT_EQ(pool.nused(), 0);
+  EXPECT_EQ(pool.nfree(), 1);
+
+  // 归还的缓冲区会被再次使用。
+  auto *buf2 = pool.Acquire();
+  EXPECT_EQ(buf1, buf2);
+  EXPECT_EQ(pool.nallocs(), 1);
+  pool.Release(buf2);
+  pool.Release(nullptr);
+  EXPECT_EQ(pool.nfree(), 1);
+}
+
+TEST(BufPoolTest, Bounded) {
+  BufPool pool(1024, 2);
+  std::vector<char *> bufs;
+  for (int i = 0; i < 5; ++i) {
+    bufs.push_back(pool.Acquire());
+  }
+  EXPECT_EQ(pool.MemoryUsage(), 5 * 1024);
+  for (auto *buf : bufs) {
+    pool.Release(buf);
+  }
+  // 最多缓存 max_free 个空闲缓冲区。
+  EXPECT_EQ(pool.nfree(), 2);
+  EXPECT_EQ(pool.MemoryUsage(), 2 * 1024);
+}
+
+TEST(BufPoolTest, Move) {
+  BufPool pool1(1024, 2);
+  pool1.Release(pool1.Acquire());
+  BufPool pool2(std::move(pool1));
+  EXPECT_EQ(pool2.nfree(), 1);
+  EXPECT_EQ(pool2.buf_size(), 1024);
+
+  pool1 = std::move(pool2);
+  EXPECT_EQ(pool1.nfree(), 1);
+}
+
+int main(int argc, char *argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  ayaka::InitLogger();
+  return RUN_ALL_TESTS();
+}
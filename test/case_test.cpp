@@ -20,6 +20,7 @@
 #include "test.hpp"
 
 using ayaka::StrEqualIgnoreCase;
+using ayaka::StrHashIgnoreCase;
 
 TEST(CaseTest, StrEqualIgnoreCase) {
   EXPECT_TRUE(StrEqualIgnoreCase("", ""));
@@ -30,6 +31,13 @@ TEST(CaseTest, StrEqualIgnoreCase) {
   EXPECT_TRUE(StrEqualIgnoreCase("AB简体中文cd", "ab简体中文CD"));
 }
 
+TEST(CaseTest, StrHashIgnoreCase) {
+  EXPECT_EQ(StrHashIgnoreCase("Content-Type"),
+            StrHashIgnoreCase("content-type"));
+  EXPECT_EQ(StrHashIgnoreCase("HOST"), StrHashIgnoreCase("host"));
+  EXPECT_NE(StrHashIgnoreCase("host"), StrHashIgnoreCase("hosts"));
+}
+
 int main(int argc, char *argv[]) {
   testing::InitGoogleTest(&argc, argv);
   ayaka::InitLogger();
@@ -0,0 +1,125 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <compress_cache.hpp>
+#include <filesystem>
+#include <fstream>
+
+#include "test.hpp"
+
+using ayaka::CompressCache;
+using ayaka::Encoding;
+using ayaka::File;
+using std::filesystem::path;
+
+namespace {
+
+std::shared_ptr<File> MakeFile(const path &file_path,
+                               const std::string &content) {
+  {
+    std::ofstream out(file_path, std::ios::binary);
+    out << content;
+  }
+  return File::Open(file_path.string());
+}
+
+CompressCache::Content MakeContent(const std::string &content) {
+  return std::make_shared<std::vector<char>>(content.begin(), content.end());
+}
+
+}  // namespace
+
+TEST(CompressCacheTest, Default) {
+  CompressCache cache;
+  EXPECT_EQ(cache.budget(), CompressCache::kDefaultBudget);
+  EXPECT_EQ(cache.Size(), 0);
+  EXPECT_EQ(cache.MemoryUsage(), 0);
+}
+
+TEST(CompressCacheTest, GetPut) {
+  auto file_path = path(testing::TempDir()) / "ayaka_compress_cache_1.txt";
+  auto file = MakeFile(file_path, "hello world");
+
+  CompressCache cache(1024);
+  EXPECT_EQ(cache.Get("key", Encoding::kGzip, *file), nullptr);
+  EXPECT_EQ(cache.nmisses(), 1);
+
+  // 压缩后的内容与文件的大小无关。
+  auto content = MakeContent("gz");
+  cache.Put("key", Encoding::kGzip, *file, content);
+  EXPECT_EQ(cache.Size(), 1);
+  EXPECT_EQ(cache.MemoryUsage(), 2);
+  EXPECT_EQ(cache.Get("key", Encoding::kGzip, *file), content);
+  EXPECT_EQ(cache.nhits(), 1);
+  // 同一个文件的不同编码是不同的缓存项。
+  EXPECT_EQ(cache.Get("key", Encoding::kZstd, *file), nullptr);
+  cache.Put("key", Encoding::kZstd, *file, MakeContent("zst"));
+  EXPECT_EQ(cache.Size(), 2);
+  EXPECT_EQ(cache.Get("key", Encoding::kGzip, *file), content);
+
+  std::filesystem::remove(file_path);
+}
+
+TEST(CompressCacheTest, Budget) {
+  auto file_path = path(testing::TempDir()) / "ayaka_compress_cache_2.txt";
+  auto file = MakeFile(file_path, "hello");
+
+  CompressCache cache(10);
+  cache.Put("a", Encoding::kGzip, *file, MakeContent("aaaa"));
+  cache.Put("b", Encoding::kGzip, *file, MakeContent("bbbb"));
+  EXPECT_NE(cache.Get("a", Encoding::kGzip, *file), nullptr);
+  // 超出预算，淘汰最久未被使用的 "b"。
+  cache.Put("c", Encoding::kGzip, *file, MakeContent("cccc"));
+  EXPECT_EQ(cache.Size(), 2);
+  EXPECT_EQ(cache.MemoryUsage(), 8);
+  EXPECT_EQ(cache.nevictions(), 1);
+  EXPECT_EQ(cache.Get("b", Encoding::kGzip, *file), nullptr);
+
+  // 超过预算的内容不会被缓存。
+  cache.Put("d", Encoding::kGzip, *file, MakeContent("ddddddddddd"));
+  EXPECT_EQ(cache.Size(), 2);
+
+  CompressCache disabled(0);
+  disabled.Put("a", Encoding::kGzip, *file, MakeContent("a"));
+  EXPECT_EQ(disabled.Size(), 0);
+
+  std::filesystem::remove(file_path);
+}
+
+TEST(CompressCacheTest, Invalidate) {
+  auto file_path = path(testing::TempDir()) / "ayaka_compress_cache_3.txt";
+  auto file = MakeFile(file_path, "hello");
+
+  CompressCache cache(1024);
+  cache.Put("key", Encoding::kGzip, *file, MakeContent("gz"));
+
+  // 文件被替换后，缓存的内容不再对应新打开的文件。
+  std::filesystem::remove(file_path);
+  auto new_file = MakeFile(file_path, "hello world");
+  EXPECT_EQ(cache.Get("key", Encoding::kGzip, *new_file), nullptr);
+  EXPECT_EQ(cache.Size(), 0);
+  EXPECT_EQ(cache.MemoryUsage(), 0);
+  EXPECT_EQ(cache.nevictions(), 1);
+
+  std::filesystem::remove(file_path);
+}
+
+int main(int argc, char *argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  ayaka::InitLogger();
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,257 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <zlib.h>
+
+#include <compression.hpp>
+#include <filesystem>
+#include <fstream>
+#include <loop.hpp>
+
+#include "test.hpp"
+
+using ayaka::CompressOptions;
+using ayaka::Compressor;
+using ayaka::Encoding;
+using ayaka::File;
+using ayaka::Header;
+using ayaka::Request;
+using ayaka::Response;
+using std::filesystem::path;
+
+namespace {
+
+/**
+ * 解压 gzip 格式的 data，失败时返回空字符串。
+ */
+std::string Gunzip(const std::vector<char>& data) {
+  z_stream stream{};
+  if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+    return "";
+  }
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = static_cast<uInt>(data.size());
+  std::string result;
+  char buf[4096];
+  int ret;
+  do {
+    stream.next_out = reinterpret_cast<Bytef*>(buf);
+    stream.avail_out = sizeof(buf);
+    ret = inflate(&stream, Z_NO_FLUSH);
+    result.append(buf, sizeof(buf) - stream.avail_out);
+  } while (ret == Z_OK);
+  inflateEnd(&stream);
+  return ret == Z_STREAM_END ? result : "";
+}
+
+/**
+ * 大于 Compressor::kChunkSize 的文本，需要分多块压缩。
+ */
+std::string MakeText() {
+  std::string text;
+  for (int i = 0; text.size() < 3 * Compressor::kChunkSize; ++i) {
+    text += "<p>" + std::to_string(i * 7919 % 10007) + "</p>\n";
+  }
+  return text;
+}
+
+}  // namespace
+
+TEST(CompressOptionsTest, Admit) {
+  CompressOptions options;
+  EXPECT_EQ(options.level(), CompressOptions::kDefaultLevel);
+  EXPECT_FALSE(options.Admit(CompressOptions::kDefaultMinSize - 1));
+  EXPECT_TRUE(options.Admit(CompressOptions::kDefaultMinSize));
+  EXPECT_TRUE(options.Admit(CompressOptions::kDefaultMaxSize));
+  EXPECT_FALSE(options.Admit(CompressOptions::kDefaultMaxSize + 1));
+  options.set_level(0);
+  EXPECT_FALSE(options.Admit(CompressOptions::kDefaultMinSize));
+}
+
+TEST(CompressionTest, Compressible) {
+  EXPECT_TRUE(ayaka::Compressible("text/html"));
+  EXPECT_TRUE(ayaka::Compressible("text/css; charset=utf-8"));
+  EXPECT_TRUE(ayaka::Compressible("application/javascript"));
+  EXPECT_TRUE(ayaka::Compressible("Application/JSON"));
+  EXPECT_TRUE(ayaka::Compressible("image/svg+xml"));
+  EXPECT_TRUE(ayaka::Compressible("application/ld+json"));
+  EXPECT_FALSE(ayaka::Compressible("image/png"));
+  EXPECT_FALSE(ayaka::Compressible("application/zip"));
+  EXPECT_FALSE(ayaka::Compressible("font/woff2"));
+  EXPECT_FALSE(ayaka::Compressible("application/octet-stream"));
+  EXPECT_FALSE(ayaka::Compressible("text"));
+  EXPECT_FALSE(ayaka::Compressible(""));
+}
+
+TEST(CompressionTest, SelectCompression) {
+  EXPECT_EQ(ayaka::SelectCompression("gzip"), Encoding::kGzip);
+  EXPECT_EQ(ayaka::SelectCompression("br"), Encoding::kIdentity);
+  EXPECT_EQ(ayaka::SelectCompression("gzip;q=0"), Encoding::kIdentity);
+  EXPECT_EQ(ayaka::SelectCompression(""), Encoding::kIdentity);
+  auto preferred = Compressor::Supported(Encoding::kZstd) ? Encoding::kZstd
+                                                          : Encoding::kGzip;
+  EXPECT_EQ(ayaka::SelectCompression("br, gzip, zstd"), preferred);
+  EXPECT_EQ(ayaka::SelectCompression("*"), preferred);
+  EXPECT_FALSE(Compressor::Supported(Encoding::kBr));
+  EXPECT_EQ(Compressor::Create(Encoding::kBr, 6), nullptr);
+}
+
+TEST(CompressionTest, CompressedETag) {
+  EXPECT_EQ(ayaka::CompressedETag("\"1-2-3\"", Encoding::kGzip),
+            "\"1-2-3-gzip\"");
+  EXPECT_EQ(ayaka::CompressedETag("W/\"x\"", Encoding::kZstd), "W/\"x-zstd\"");
+  EXPECT_EQ(ayaka::CompressedETag("", Encoding::kGzip), "");
+}
+
+TEST(CompressionTest, CompressData) {
+  auto text = MakeText();
+  auto compressed = ayaka::CompressData(Encoding::kGzip, text);
+  ASSERT_NE(compressed, nullptr);
+  EXPECT_LT(compressed->size(), text.size());
+  EXPECT_EQ(Gunzip(*compressed), text);
+
+  compressed = ayaka::CompressData(Encoding::kGzip, "");
+  ASSERT_NE(compressed, nullptr);
+  EXPECT_EQ(Gunzip(*compressed), "");
+}
+
+TEST(CompressionTest, CompressFile) {
+  auto file_path = path(testing::TempDir()) / "ayaka_compression_1.html";
+  auto text = MakeText();
+  {
+    std::ofstream out(file_path, std::ios::binary);
+    out << text;
+  }
+  auto file = File::Open(file_path.string());
+  ASSERT_NE(file, nullptr);
+
+  auto compressed = ayaka::CompressFile(Encoding::kGzip, *file);
+  ASSERT_NE(compressed, nullptr);
+  EXPECT_EQ(Gunzip(*compressed), text);
+
+  auto loop = std::make_shared<ayaka::Loop>();
+  auto done = false;
+  Response::Body result;
+  ayaka::CompressFileAsync(loop->uv_loop(), file, Encoding::kGzip,
+                           [&](Response::Body body) {
+                             done = true;
+                             result = std::move(body);
+                           });
+  while (!done) {
+    loop->Once();
+  }
+  ASSERT_NE(result, nullptr);
+  EXPECT_EQ(*result, *compressed);
+
+  std::filesystem::remove(file_path);
+}
+
+TEST(CompressionTest, CompressResponse) {
+  auto text = MakeText();
+  Request req;
+  req.headers()[Header::kAcceptEncoding] = "gzip";
+  auto make_resp = [&](std::string_view type) {
+    auto resp = Response::Default();
+    resp->headers()[Header::kContentType] = type;
+    resp->headers()[Header::kETag] = "\"1\"";
+    resp->set_body(
+        std::make_shared<std::vector<char>>(text.begin(), text.end()));
+    return resp;
+  };
+
+  auto resp = make_resp("text/html");
+  ayaka::CompressResponse(req, *resp);
+  EXPECT_EQ(resp->headers()[Header::kContentEncoding], "gzip");
+  EXPECT_EQ(resp->headers()[Header::kVary], "Accept-Encoding");
+  EXPECT_EQ(resp->headers()[Header::kETag], "\"1-gzip\"");
+  EXPECT_EQ(Gunzip(*resp->body()), text);
+
+  // 处理器设置的 Content-Length 是压缩前的大小。
+  resp = make_resp("text/html");
+  resp->headers()[Header::kContentLength] = std::to_string(text.size());
+  ayaka::CompressResponse(req, *resp);
+  EXPECT_EQ(resp->headers()[Header::kContentEncoding], "gzip");
+  EXPECT_EQ(resp->headers().Find(Header::kContentLength), nullptr);
+
+  // 已经压缩过的类型不再压缩。
+  resp = make_resp("image/png");
+  ayaka::CompressResponse(req, *resp);
+  EXPECT_EQ(resp->headers().Find(Header::kContentEncoding), nullptr);
+  EXPECT_EQ(resp->BodySize(), text.size());
+
+  // 处理器已经协商过编码。
+  resp = make_resp("text/html");
+  resp->headers()[Header::kVary] = "Accept-Encoding";
+  ayaka::CompressResponse(req, *resp);
+  EXPECT_EQ(resp->headers().Find(Header::kContentEncoding), nullptr);
+
+  // 只压缩 200 响应。
+  resp = make_resp("text/html");
+  resp->set_status(ayaka::HttpStatus::NotModified());
+  ayaka::CompressResponse(req, *resp);
+  EXPECT_EQ(resp->headers().Find(Header::kContentEncoding), nullptr);
+
+  // 客户端不接受压缩时，响应仍然取决于 Accept-Encoding。
+  req.headers()[Header::kAcceptEncoding] = "identity";
+  resp = make_resp("text/html");
+  resp->headers()[Header::kVary] = "Origin";
+  ayaka::CompressResponse(req, *resp);
+  EXPECT_EQ(resp->headers().Find(Header::kContentEncoding), nullptr);
+  EXPECT_EQ(resp->headers()[Header::kVary], "Origin, Accept-Encoding");
+  EXPECT_EQ(resp->BodySize(), text.size());
+}
+
+TEST(CompressionTest, CompressResponseAsync) {
+  auto text = MakeText();
+  Request req;
+  req.headers()[Header::kAcceptEncoding] = "gzip";
+  auto resp = Response::Default();
+  resp->headers()[Header::kContentType] = "text/html";
+  resp->headers()[Header::kContentLength] = std::to_string(text.size());
+  resp->set_body(
+      std::make_shared<std::vector<char>>(text.begin(), text.end()));
+
+  auto loop = std::make_shared<ayaka::Loop>();
+  auto done = false;
+  ayaka::CompressResponseAsync(loop->uv_loop(), req, resp,
+                               [&done]() { done = true; });
+  // 在线程池中压缩，返回时还没有完成。
+  EXPECT_FALSE(done);
+  while (!done) {
+    loop->Once();
+  }
+  EXPECT_EQ(resp->headers()[Header::kContentEncoding], "gzip");
+  EXPECT_EQ(resp->headers().Find(Header::kContentLength), nullptr);
+  EXPECT_EQ(Gunzip(*resp->body()), text);
+
+  // 不需要压缩时立即完成。
+  resp = Response::Default();
+  resp->headers()[Header::kContentType] = "image/png";
+  resp->set_body(
+      std::make_shared<std::vector<char>>(text.begin(), text.end()));
+  done = false;
+  ayaka::CompressResponseAsync(loop->uv_loop(), req, resp,
+                               [&done]() { done = true; });
+  EXPECT_TRUE(done);
+  EXPECT_EQ(resp->headers().Find(Header::kContentEncoding), nullptr);
+}
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  ayaka::InitLogger();
+  return RUN_ALL_TESTS();
+}
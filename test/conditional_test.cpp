@@ -0,0 +1,108 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <conditional.hpp>
+#include <file.hpp>
+#include <memory>
+#include <request.hpp>
+
+#include "test.hpp"
+
+using ayaka::FormatHttpDate;
+using ayaka::Header;
+using ayaka::MatchETag;
+using ayaka::NotModified;
+using ayaka::ParseHttpDate;
+using ayaka::Request;
+
+TEST(ConditionalTest, FormatHttpDate) {
+  EXPECT_EQ(FormatHttpDate(784111777), "Sun, 06 Nov 1994 08:49:37 GMT");
+  EXPECT_EQ(FormatHttpDate(0), "Thu, 01 Jan 1970 00:00:00 GMT");
+}
+
+TEST(ConditionalTest, ParseHttpDate) {
+  EXPECT_EQ(ParseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT"), 784111777);
+  EXPECT_EQ(ParseHttpDate("Sunday, 06-Nov-94 08:49:37 GMT"), 784111777);
+  EXPECT_EQ(ParseHttpDate("Sun Nov  6 08:49:37 1994"), 784111777);
+  EXPECT_EQ(ParseHttpDate(""), -1);
+  EXPECT_EQ(ParseHttpDate("yesterday"), -1);
+  EXPECT_EQ(ParseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT garbage"), -1);
+}
+
+TEST(ConditionalTest, MakeETag) {
+  auto file = ayaka::File::Open(__FILE__);
+  ASSERT_NE(file, nullptr);
+  auto etag = ayaka::MakeETag(*file);
+  EXPECT_GE(etag.size(), 7);
+  EXPECT_EQ(etag.front(), '"');
+  EXPECT_EQ(etag.back(), '"');
+  EXPECT_EQ(ayaka::MakeETag(*ayaka::File::Open(__FILE__)), etag);
+}
+
+TEST(ConditionalTest, MatchETag) {
+  EXPECT_TRUE(MatchETag("\"abc\"", "\"abc\""));
+  EXPECT_TRUE(MatchETag("*", "\"abc\""));
+  EXPECT_TRUE(MatchETag("\"xyz\", \"abc\"", "\"abc\""));
+  EXPECT_TRUE(MatchETag("\"xyz\",\t W/\"abc\" ", "\"abc\""));
+  EXPECT_TRUE(MatchETag("\"abc\"", "W/\"abc\""));
+  EXPECT_FALSE(MatchETag("", "\"abc\""));
+  EXPECT_FALSE(MatchETag("\"ab\"", "\"abc\""));
+  EXPECT_FALSE(MatchETag("\"xyz\", \"abcd\"", "\"abc\""));
+}
+
+TEST(ConditionalTest, NotModified) {
+  constexpr time_t kMtime = 784111777;
+  Request req;
+  EXPECT_FALSE(NotModified(req, "\"abc\"", kMtime));
+
+  req.headers()[Header::kIfModifiedSince] = "Sun, 06 Nov 1994 08:49:37 GMT";
+  EXPECT_TRUE(NotModified(req, "\"abc\"", kMtime));
+  EXPECT_FALSE(NotModified(req, "\"abc\"", kMtime + 1));
+  req.headers()[Header::kIfModifiedSince] = "invalid";
+  EXPECT_FALSE(NotModified(req, "\"abc\"", kMtime));
+
+  // If-None-Match 优先于 If-Modified-Since。
+  req.headers()[Header::kIfModifiedSince] = "Sun, 06 Nov 1994 08:49:37 GMT";
+  req.headers()[Header::kIfNoneMatch] = "\"xyz\"";
+  EXPECT_FALSE(NotModified(req, "\"abc\"", kMtime));
+  req.headers()[Header::kIfNoneMatch] = "\"abc\"";
+  EXPECT_TRUE(NotModified(req, "\"abc\"", kMtime + 1));
+}
+
+TEST(ConditionalTest, IfRangeMatch) {
+  constexpr time_t kMtime = 784111777;
+  Request req;
+  EXPECT_TRUE(ayaka::IfRangeMatch(req, "\"abc\"", kMtime));
+
+  req.headers()[Header::kIfRange] = "\"abc\"";
+  EXPECT_TRUE(ayaka::IfRangeMatch(req, "\"abc\"", kMtime));
+  EXPECT_FALSE(ayaka::IfRangeMatch(req, "\"xyz\"", kMtime));
+  // 弱 ETag 不能用于 If-Range。
+  EXPECT_FALSE(ayaka::IfRangeMatch(req, "W/\"abc\"", kMtime));
+  req.headers()[Header::kIfRange] = "W/\"abc\"";
+  EXPECT_FALSE(ayaka::IfRangeMatch(req, "\"abc\"", kMtime));
+
+  req.headers()[Header::kIfRange] = "Sun, 06 Nov 1994 08:49:37 GMT";
+  EXPECT_TRUE(ayaka::IfRangeMatch(req, "\"abc\"", kMtime));
+  EXPECT_FALSE(ayaka::IfRangeMatch(req, "\"abc\"", kMtime + 1));
+}
+
+int main(int argc, char *argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  ayaka::InitLogger();
+  return RUN_ALL_TESTS();
+}
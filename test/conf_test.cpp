@@ -19,6 +19,7 @@
 
 #include "test.hpp"
 
+using ayaka::HttpConf;
 using ayaka::InetAddr;
 using ayaka::ListenConf;
 using ayaka::ServerConf;
@@ -89,6 +90,13 @@ TEST(ServerConfTest, Default) {
   EXPECT_EQ(conf.listen().ip(), ListenConf::kDefaultIp);
   EXPECT_EQ(conf.listen().port(), ListenConf::kDefaultPort);
   EXPECT_EQ(conf.worker_threads(), ServerConf::kDefaultWorkerThreads);
+  EXPECT_EQ(conf.keep_alive_requests(), ServerConf::kDefaultKeepAliveRequests);
+  EXPECT_EQ(conf.recv_buf_size(), ServerConf::kDefaultRecvBufSize);
+  EXPECT_EQ(conf.recv_buf_pool_size(), ServerConf::kDefaultRecvBufPoolSize);
+  EXPECT_EQ(conf.header_timeout(), ServerConf::kDefaultHeaderTimeout);
+  EXPECT_EQ(conf.keep_alive_timeout(), ServerConf::kDefaultKeepAliveTimeout);
+  EXPECT_EQ(conf.send_timeout(), ServerConf::kDefaultSendTimeout);
+  EXPECT_EQ(conf.max_body_size(), ServerConf::kDefaultMaxBodySize);
 }
 
 TEST(ServerConfTest, Setter) {
@@ -101,6 +109,8 @@ TEST(ServerConfTest, Setter) {
   EXPECT_EQ(conf.listen().port(), 8080);
   conf.set_worker_threads(10);
   EXPECT_EQ(conf.worker_threads(), 10);
+  conf.set_keep_alive_requests(0);
+  EXPECT_EQ(conf.keep_alive_requests(), 0);
 }
 
 TEST(ServerConfTest, Valid) {
@@ -112,6 +122,47 @@ TEST(ServerConfTest, Valid) {
   EXPECT_TRUE(conf.Valid());
   conf.set_worker_threads(ServerConf::kMaxWorkerThreads + 1);
   EXPECT_FALSE(conf.Valid());
+  conf.set_worker_threads(ServerConf::kDefaultWorkerThreads);
+  conf.set_keep_alive_requests(-1);
+  EXPECT_FALSE(conf.Valid());
+  conf.set_keep_alive_requests(ServerConf::kDefaultKeepAliveRequests);
+  conf.set_recv_buf_size(ServerConf::kMinRecvBufSize - 1);
+  EXPECT_FALSE(conf.Valid());
+  conf.set_recv_buf_size(ServerConf::kMaxRecvBufSize + 1);
+  EXPECT_FALSE(conf.Valid());
+  conf.set_recv_buf_size(64 * 1024);
+  EXPECT_TRUE(conf.Valid());
+  conf.set_recv_buf_pool_size(-1);
+  EXPECT_FALSE(conf.Valid());
+  conf.set_recv_buf_pool_size(ServerConf::kDefaultRecvBufPoolSize);
+  conf.set_header_timeout(0);
+  conf.set_keep_alive_timeout(0);
+  conf.set_send_timeout(0);
+  EXPECT_TRUE(conf.Valid());
+  conf.set_send_timeout(-1);
+  EXPECT_FALSE(conf.Valid());
+  conf.set_send_timeout(ServerConf::kDefaultSendTimeout);
+  conf.set_max_body_size(0);
+  EXPECT_TRUE(conf.Valid());
+  conf.set_max_body_size(-1);
+  EXPECT_FALSE(conf.Valid());
+}
+
+TEST(HttpConfTest, Default) {
+  HttpConf conf;
+  EXPECT_FALSE(conf.mime().empty());
+  EXPECT_EQ(conf.open_file_cache_size(), HttpConf::kDefaultOpenFileCacheSize);
+  EXPECT_EQ(conf.open_file_cache_valid(), HttpConf::kDefaultOpenFileCacheValid);
+  EXPECT_EQ(conf.mmap_max_file(), HttpConf::kDefaultMmapMaxFile);
+  EXPECT_EQ(conf.content_cache_size(), HttpConf::kDefaultContentCacheSize);
+  EXPECT_EQ(conf.content_cache_max_file(),
+            HttpConf::kDefaultContentCacheMaxFile);
+  EXPECT_EQ(conf.compression_level(), HttpConf::kDefaultCompressionLevel);
+  EXPECT_EQ(conf.compression_min_size(),
+            HttpConf::kDefaultCompressionMinSize);
+  EXPECT_EQ(conf.compression_max_size(),
+            HttpConf::kDefaultCompressionMaxSize);
+  EXPECT_EQ(conf.compress_cache_size(), HttpConf::kDefaultCompressCacheSize);
 }
 
 int main(int argc, char *argv[]) {
@@ -0,0 +1,132 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <content_cache.hpp>
+#include <filesystem>
+#include <fstream>
+
+#include "test.hpp"
+
+using ayaka::ContentCache;
+using ayaka::File;
+using std::filesystem::path;
+
+namespace {
+
+std::shared_ptr<File> MakeFile(const path &file_path,
+                               const std::string &content) {
+  {
+    std::ofstream out(file_path, std::ios::binary);
+    out << content;
+  }
+  return File::Open(file_path.string());
+}
+
+}  // namespace
+
+TEST(ContentCacheTest, Default) {
+  ContentCache cache;
+  EXPECT_EQ(cache.budget(), ContentCache::kDefaultBudget);
+  EXPECT_EQ(cache.max_file_size(), ContentCache::kDefaultMaxFileSize);
+  EXPECT_EQ(cache.Size(), 0);
+  EXPECT_EQ(cache.MemoryUsage(), 0);
+}
+
+TEST(ContentCacheTest, GetPut) {
+  auto file_path = path(testing::TempDir()) / "ayaka_content_cache_1.txt";
+  auto file = MakeFile(file_path, "hello");
+
+  ContentCache cache(1024, 16);
+  EXPECT_EQ(cache.Get("key", *file), nullptr);
+  EXPECT_EQ(cache.nmisses(), 1);
+
+  auto content = file->ReadAll();
+  ASSERT_NE(content, nullptr);
+  EXPECT_EQ(std::string(content->begin(), content->end()), "hello");
+  cache.Put("key", *file, content);
+  EXPECT_EQ(cache.Size(), 1);
+  EXPECT_EQ(cache.MemoryUsage(), 5);
+  EXPECT_EQ(cache.Get("key", *file), content);
+  EXPECT_EQ(cache.nhits(), 1);
+
+  std::filesystem::remove(file_path);
+}
+
+TEST(ContentCacheTest, Admit) {
+  auto file_path = path(testing::TempDir()) / "ayaka_content_cache_2.txt";
+  auto file = MakeFile(file_path, "hello world");
+
+  ContentCache small_file(1024, 8);
+  EXPECT_FALSE(small_file.Admit(*file));
+  small_file.Put("key", *file, file->ReadAll());
+  EXPECT_EQ(small_file.Size(), 0);
+
+  ContentCache disabled(0, 1024);
+  EXPECT_FALSE(disabled.Admit(*file));
+  disabled.Put("key", *file, file->ReadAll());
+  EXPECT_EQ(disabled.Size(), 0);
+
+  std::filesystem::remove(file_path);
+}
+
+TEST(ContentCacheTest, Budget) {
+  auto dir = path(testing::TempDir());
+  auto file1 = MakeFile(dir / "ayaka_content_cache_3.txt", "aaaa");
+  auto file2 = MakeFile(dir / "ayaka_content_cache_4.txt", "bbbb");
+  auto file3 = MakeFile(dir / "ayaka_content_cache_5.txt", "cccc");
+
+  ContentCache cache(10, 10);
+  cache.Put("a", *file1, file1->ReadAll());
+  cache.Put("b", *file2, file2->ReadAll());
+  EXPECT_NE(cache.Get("a", *file1), nullptr);
+  // 超出预算，淘汰最久未被使用的 "b"。
+  cache.Put("c", *file3, file3->ReadAll());
+  EXPECT_EQ(cache.Size(), 2);
+  EXPECT_EQ(cache.MemoryUsage(), 8);
+  EXPECT_EQ(cache.nevictions(), 1);
+  EXPECT_NE(cache.Get("a", *file1), nullptr);
+  EXPECT_EQ(cache.Get("b", *file2), nullptr);
+  EXPECT_NE(cache.Get("c", *file3), nullptr);
+
+  std::filesystem::remove(dir / "ayaka_content_cache_3.txt");
+  std::filesystem::remove(dir / "ayaka_content_cache_4.txt");
+  std::filesystem::remove(dir / "ayaka_content_cache_5.txt");
+}
+
+TEST(ContentCacheTest, Invalidate) {
+  auto file_path = path(testing::TempDir()) / "ayaka_content_cache_6.txt";
+  auto file = MakeFile(file_path, "hello");
+
+  ContentCache cache(1024, 1024);
+  cache.Put("key", *file, file->ReadAll());
+
+  // 文件被替换后，缓存的内容与新打开的文件不一致。
+  std::filesystem::remove(file_path);
+  auto new_file = MakeFile(file_path, "hello world");
+  EXPECT_EQ(cache.Get("key", *new_file), nullptr);
+  EXPECT_EQ(cache.Size(), 0);
+  EXPECT_EQ(cache.MemoryUsage(), 0);
+  EXPECT_EQ(cache.nevictions(), 1);
+
+  std::filesystem::remove(file_path);
+}
+
+int main(int argc, char *argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  ayaka::InitLogger();
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,550 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sys/socket.h>
+
+#include <awaitable.hpp>
+#include <co_handler.hpp>
+#include <chrono>
+#include <downstream.hpp>
+#include <filesystem>
+#include <fstream>
+#include <static_handler.hpp>
+#include <string>
+
+#include "test.hpp"
+
+using namespace ayaka;
+
+namespace {
+
+class HelloHandler : public HttpHandler {
+ public:
+  void DoGet([[maybe_unused]] const std::shared_ptr<Request>& req,
+             std::shared_ptr<Response>& resp) override {
+    std::string hello = "hello";
+    resp->set_body(
+        std::make_shared<std::vector<char>>(hello.begin(), hello.end()));
+  }
+};
+
+/**
+ * 返回可以被压缩的文本。set_length 为 true 时自己设置 Content-Length。
+ */
+class TextHandler : public HttpHandler {
+ public:
+  explicit TextHandler(bool set_length = false) : set_length_(set_length) {}
+
+  void DoGet([[maybe_unused]] const std::shared_ptr<Request>& req,
+             std::shared_ptr<Response>& resp) override {
+    resp->headers()[Header::kContentType] = "text/plain";
+    if (set_length_) {
+      resp->headers()[Header::kContentLength] = "1024";
+    }
+    resp->set_body(std::make_shared<std::vector<char>>(1024, 'a'));
+  }
+
+ private:
+  bool set_length_;
+};
+
+/**
+ * 把请求体原样返回。
+ */
+class EchoHandler : public HttpHandler {
+ public:
+  void DoPost(const std::shared_ptr<Request>& req,
+              std::shared_ptr<Response>& resp) override {
+    resp->set_body(std::make_shared<std::vector<char>>(req->body().content()));
+  }
+};
+
+/**
+ * 在下一次定时器触发时才完成处理。
+ */
+class SlowHandler : public HttpHandler {
+ public:
+  void HandleAsync([[maybe_unused]] const std::shared_ptr<Request>& req,
+                   HttpCompletion completion) override {
+    std::string slow = "slow";
+    completion.resp()->set_body(
+        std::make_shared<std::vector<char>>(slow.begin(), slow.end()));
+
+    auto* timer = new uv_timer_t;
+    uv_timer_init(completion.loop()->uv_loop(), timer);
+    timer->data = new HttpCompletion(std::move(completion));
+    uv_timer_start(
+        timer,
+        [](uv_timer_t* handle) {
+          auto* completion = static_cast<HttpCompletion*>(handle->data);
+          completion->Finish();
+          delete completion;
+          uv_close(reinterpret_cast<uv_handle_t*>(handle),
+                   [](uv_handle_t* handle) {
+                     delete reinterpret_cast<uv_timer_t*>(handle);
+                   });
+        },
+        10, 0);
+  }
+};
+
+/**
+ * 没有完成就丢弃了 HttpCompletion。
+ */
+class DropHandler : public HttpHandler {
+ public:
+  void HandleAsync([[maybe_unused]] const std::shared_ptr<Request>& req,
+                   [[maybe_unused]] HttpCompletion completion) override {}
+};
+
+/**
+ * 使用协程，在定时器触发后完成处理。
+ */
+class CoHandler : public CoHttpHandler {
+ public:
+  Task<void> HandleCo(std::shared_ptr<Request> req,
+                      HttpCompletion completion) override {
+    co_await Sleep(completion.loop(), std::chrono::milliseconds(10));
+    if (req->url().path().string() == "/co-fail") {
+      throw Http404Except(req->method(), req->url().src());
+    }
+    std::string co = "coroutine";
+    completion.resp()->set_body(
+        std::make_shared<std::vector<char>>(co.begin(), co.end()));
+  }
+};
+
+size_t CountOf(const std::string& str, const std::string& sub) {
+  size_t count = 0;
+  for (auto pos = str.find(sub); pos != std::string::npos;
+       pos = str.find(sub, pos + sub.size())) {
+    ++count;
+  }
+  return count;
+}
+
+class DownstreamTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    auto router = std::make_shared<Router>();
+    router->AddLocation(
+        std::make_shared<PathLocation>("/", std::make_shared<HelloHandler>()));
+    router->AddLocation(std::make_shared<PathLocation>(
+        "/slow", std::make_shared<SlowHandler>()));
+    router->AddLocation(std::make_shared<PathLocation>(
+        "/drop", std::make_shared<DropHandler>()));
+    router->AddLocation(std::make_shared<PathLocation>(
+        "/echo", std::make_shared<EchoHandler>()));
+    router->AddLocation(std::make_shared<PathLocation>(
+        "/text", std::make_shared<TextHandler>()));
+    router->AddLocation(std::make_shared<PathLocation>(
+        "/text-length", std::make_shared<TextHandler>(true)));
+    auto co_handler = std::make_shared<CoHandler>();
+    router->AddLocation(std::make_shared<PathLocation>("/co", co_handler));
+    router->AddLocation(
+        std::make_shared<PathLocation>("/co-fail", co_handler));
+    file_path_ = std::filesystem::path(testing::TempDir()) / "ayaka_file.txt";
+    {
+      std::ofstream out(file_path_);
+      out << "file content";
+    }
+    router->AddLocation(std::make_shared<PathLocation>(
+        "/file", std::make_shared<StaticPathHandler>(
+                     file_path_.string(), std::make_shared<Mime>())));
+
+    loop_ = std::make_shared<Loop>();
+    server_ = std::make_shared<Tcp>(loop_);
+    server_->Bind(addr_);
+    server_->set_on_accept([this, router](std::shared_ptr<Tcp> tcp) {
+      downstream_ = std::make_shared<Downstream>(std::move(tcp), router, conf_);
+    });
+    server_->Listen();
+
+    client_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr sock_addr{};
+    addr_.ToSockAddr(&sock_addr);
+    auto status = connect(client_fd_, &sock_addr, sizeof(sockaddr));
+    ASSERT_EQ(status, 0);
+    while (!downstream_) {
+      loop_->Once();
+    }
+  }
+
+  void TearDown() override {
+    close(client_fd_);
+    server_->Close();
+    if (downstream_) {
+      downstream_->tcp()->Close();
+    }
+    while (!server_->closed() ||
+           (downstream_ && !downstream_->tcp()->closed())) {
+      loop_->Once();
+    }
+    std::filesystem::remove(file_path_);
+  }
+
+  void Write(const std::string& data) const {
+    auto nwrite = write(client_fd_, data.data(), data.size());
+    EXPECT_EQ(nwrite, data.size());
+  }
+
+  std::string Read() const {
+    char buf[4096] = {};
+    auto nread = read(client_fd_, buf, sizeof(buf));
+    EXPECT_GT(nread, 0);
+    return {buf, static_cast<size_t>(nread)};
+  }
+
+  void WaitRequests(int nrequests) {
+    while (downstream_->nrequests() < nrequests ||
+           downstream_->npending() > 0 || downstream_->tcp()->Pending() > 0) {
+      loop_->Once();
+    }
+  }
+
+  std::filesystem::path file_path_;
+  InetAddr addr_{InetAddr::Family::kIpv4, "127.0.0.1", 8080};
+  ServerConf conf_;
+  std::shared_ptr<Loop> loop_;
+  std::shared_ptr<Tcp> server_;
+  std::shared_ptr<Downstream> downstream_;
+  int client_fd_ = -1;
+};
+
+class DownstreamTimeoutTest : public DownstreamTest {
+ protected:
+  void SetUp() override {
+    conf_.set_header_timeout(1);
+    conf_.set_keep_alive_timeout(1);
+    DownstreamTest::SetUp();
+  }
+
+  void WaitClosed() {
+    while (!downstream_->tcp()->closed()) {
+      loop_->Once();
+    }
+  }
+};
+
+}  // namespace
+
+TEST_F(DownstreamTest, KeepAlive) {
+  Write("GET / HTTP/1.1\r\n\r\n");
+  WaitRequests(1);
+  auto resp = Read();
+  EXPECT_EQ(resp.rfind("HTTP/1.1 200 OK\r\n", 0), 0);
+  EXPECT_NE(resp.find("Connection: keep-alive\r\n"), std::string::npos);
+  EXPECT_NE(resp.find("Content-Length: 5\r\n"), std::string::npos);
+
+  // 第二个请求复用同一个连接。
+  Write("GET / HTTP/1.1\r\n\r\n");
+  WaitRequests(2);
+  resp = Read();
+  EXPECT_EQ(resp.rfind("HTTP/1.1 200 OK\r\n", 0), 0);
+  EXPECT_FALSE(downstream_->tcp()->closed());
+}
+
+TEST_F(DownstreamTest, ConnectionClose) {
+  Write("GET / HTTP/1.1\r\nConnection: close\r\n\r\n");
+  while (!downstream_->tcp()->closed()) {
+    loop_->Once();
+  }
+  auto resp = Read();
+  EXPECT_NE(resp.find("Connection: close\r\n"), std::string::npos);
+  EXPECT_EQ(downstream_->nrequests(), 1);
+}
+
+TEST_F(DownstreamTest, Http10) {
+  Write("GET / HTTP/1.0\r\n\r\n");
+  while (!downstream_->tcp()->closed()) {
+    loop_->Once();
+  }
+  auto resp = Read();
+  EXPECT_NE(resp.find("Connection: close\r\n"), std::string::npos);
+}
+
+TEST_F(DownstreamTest, NotFoundKeepsConnection) {
+  Write("GET /foo HTTP/1.1\r\n\r\nGET / HTTP/1.1\r\n\r\n");
+  WaitRequests(2);
+  auto resp = Read();
+  while (CountOf(resp, "HTTP/1.1 ") < 2) {
+    resp += Read();
+  }
+  EXPECT_EQ(resp.rfind("HTTP/1.1 404 Not Found\r\n", 0), 0);
+  EXPECT_EQ(CountOf(resp, "HTTP/1.1 200 OK\r\n"), 1);
+  EXPECT_FALSE(downstream_->tcp()->closed());
+}
+
+TEST_F(DownstreamTest, Pipelining) {
+  std::string reqs;
+  for (int i = 0; i < 16; ++i) {
+    reqs += "GET / HTTP/1.1\r\n\r\n";
+  }
+  Write(reqs);
+  WaitRequests(16);
+  // 同一次读取中解析出的请求，其响应合并为一次写入。
+  EXPECT_LE(downstream_->nsends(), 2);
+
+  auto resp = Read();
+  while (CountOf(resp, "hello") < 16) {
+    resp += Read();
+  }
+  EXPECT_EQ(CountOf(resp, "HTTP/1.1 200 OK\r\n"), 16);
+  EXPECT_FALSE(downstream_->tcp()->closed());
+}
+
+TEST_F(DownstreamTest, PipeliningClose) {
+  Write(
+      "GET / HTTP/1.1\r\n\r\nGET / HTTP/1.1\r\nConnection: close\r\n\r\n"
+      "GET / HTTP/1.1\r\n\r\n");
+  while (!downstream_->tcp()->closed()) {
+    loop_->Once();
+  }
+  // Connection: close 之后的请求被忽略。
+  EXPECT_EQ(downstream_->nrequests(), 2);
+  auto resp = Read();
+  while (CountOf(resp, "hello") < 2) {
+    resp += Read();
+  }
+  EXPECT_EQ(CountOf(resp, "HTTP/1.1 200 OK\r\n"), 2);
+}
+
+TEST_F(DownstreamTest, SendFile) {
+  Write(
+      "GET /file HTTP/1.1\r\n\r\nGET / HTTP/1.1\r\n\r\n"
+      "GET /file HTTP/1.1\r\n\r\n");
+  WaitRequests(3);
+  auto resp = Read();
+  while (CountOf(resp, "file content") < 2 || CountOf(resp, "hello") < 1) {
+    resp += Read();
+  }
+  EXPECT_EQ(CountOf(resp, "Content-Length: 12\r\n"), 2);
+  // 响应的顺序与请求的顺序一致。
+  auto first = resp.find("file content");
+  auto second = resp.find("hello");
+  auto third = resp.find("file content", first + 1);
+  EXPECT_LT(first, second);
+  EXPECT_LT(second, third);
+}
+
+TEST_F(DownstreamTest, Range) {
+  Write(
+      "GET /file HTTP/1.1\r\nRange: bytes=5-\r\n\r\n"
+      "GET /file HTTP/1.1\r\nRange: bytes=0-3,-7\r\n\r\n"
+      "GET / HTTP/1.1\r\n\r\n");
+  WaitRequests(3);
+  auto resp = Read();
+  while (CountOf(resp, "hello") < 1) {
+    resp += Read();
+  }
+  EXPECT_EQ(CountOf(resp, "HTTP/1.1 206 Partial Content\r\n"), 2);
+  EXPECT_NE(resp.find("Content-Range: bytes 5-11/12\r\n"), std::string::npos);
+  EXPECT_NE(resp.find("Content-Length: 7\r\n"), std::string::npos);
+
+  // multipart/byteranges 的各段依次发送，之后的响应不受影响。
+  auto boundary_pos = resp.find("boundary=");
+  ASSERT_NE(boundary_pos, std::string::npos);
+  auto boundary = resp.substr(boundary_pos + 9, 16);
+  auto body = "--" + boundary +
+              "\r\nContent-Type: application/octet-stream\r\n"
+              "Content-Range: bytes 0-3/12\r\n\r\nfile\r\n--" +
+              boundary +
+              "\r\nContent-Type: application/octet-stream\r\n"
+              "Content-Range: bytes 5-11/12\r\n\r\ncontent\r\n--" +
+              boundary + "--\r\n";
+  EXPECT_NE(resp.find("Content-Length: " + std::to_string(body.size()) +
+                      "\r\n"),
+            std::string::npos);
+  auto body_pos = resp.find(body);
+  ASSERT_NE(body_pos, std::string::npos);
+  EXPECT_LT(body_pos, resp.find("hello"));
+}
+
+TEST_F(DownstreamTest, Deferred) {
+  Write("GET /slow HTTP/1.1\r\n\r\nGET / HTTP/1.1\r\n\r\n");
+  WaitRequests(2);
+  auto resp = Read();
+  while (CountOf(resp, "slow") < 1 || CountOf(resp, "hello") < 1) {
+    resp += Read();
+  }
+  // 先完成的响应等待之前的响应完成后再发送。
+  EXPECT_LT(resp.find("slow"), resp.find("hello"));
+  EXPECT_EQ(downstream_->nsends(), 1);
+}
+
+TEST_F(DownstreamTest, Dropped) {
+  Write("GET /drop HTTP/1.1\r\n\r\nGET / HTTP/1.1\r\n\r\n");
+  WaitRequests(2);
+  auto resp = Read();
+  while (CountOf(resp, "hello") < 1) {
+    resp += Read();
+  }
+  EXPECT_EQ(resp.find("HTTP/1.1 500 Internal Server Error\r\n"), 0);
+  EXPECT_FALSE(downstream_->tcp()->closed());
+}
+
+TEST_F(DownstreamTest, Coroutine) {
+  Write(
+      "GET /co HTTP/1.1\r\n\r\nGET /co-fail HTTP/1.1\r\n\r\n"
+      "GET / HTTP/1.1\r\n\r\n");
+  WaitRequests(3);
+  auto resp = Read();
+  while (CountOf(resp, "hello") < 1) {
+    resp += Read();
+  }
+  EXPECT_EQ(resp.find("HTTP/1.1 200 OK\r\n"), 0);
+  EXPECT_LT(resp.find("coroutine"), resp.find("HTTP/1.1 404 Not Found\r\n"));
+  EXPECT_LT(resp.find("HTTP/1.1 404 Not Found\r\n"), resp.find("hello"));
+}
+
+TEST_F(DownstreamTest, ContentLength) {
+  Write("POST /echo HTTP/1.1\r\nContent-Length: 11\r\n\r\nhello");
+  while (downstream_->nrequests() < 1) {
+    loop_->Once();
+  }
+  // 请求体还没有接收完整，处理器尚未完成。
+  EXPECT_EQ(downstream_->npending(), 1);
+  Write(" worldGET / HTTP/1.1\r\n\r\n");
+  WaitRequests(2);
+  auto resp = Read();
+  while (CountOf(resp, "hello") < 2) {
+    resp += Read();
+  }
+  EXPECT_EQ(resp.find("HTTP/1.1 200 OK\r\n"), 0);
+  EXPECT_NE(resp.find("Content-Length: 11\r\n"), std::string::npos);
+  EXPECT_LT(resp.find("hello world"), resp.rfind("HTTP/1.1 200 OK\r\n"));
+  EXPECT_FALSE(downstream_->tcp()->closed());
+}
+
+TEST_F(DownstreamTest, Chunked) {
+  Write(
+      "POST /echo HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+      "5\r\nhello\r\n");
+  Write("6\r\n world\r\n0\r\n\r\n");
+  WaitRequests(1);
+  auto resp = Read();
+  while (CountOf(resp, "hello world") < 1) {
+    resp += Read();
+  }
+  EXPECT_EQ(resp.find("HTTP/1.1 200 OK\r\n"), 0);
+  EXPECT_FALSE(downstream_->tcp()->closed());
+}
+
+TEST_F(DownstreamTest, Compress) {
+  Write("GET /text HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n");
+  WaitRequests(1);
+  auto resp = Read();
+  while (resp.find("\r\n\r\n") == std::string::npos) {
+    resp += Read();
+  }
+  EXPECT_EQ(resp.find("HTTP/1.1 200 OK\r\n"), 0);
+  EXPECT_NE(resp.find("Content-Encoding: gzip\r\n"), std::string::npos);
+  EXPECT_NE(resp.find("Vary: Accept-Encoding\r\n"), std::string::npos);
+  EXPECT_EQ(resp.find("Content-Length: 1024\r\n"), std::string::npos);
+}
+
+TEST_F(DownstreamTest, CompressContentLength) {
+  // 两个请求流水线发送，第一个响应的长度错误会破坏第二个响应。
+  std::string req =
+      "GET /text-length HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n";
+  Write(req + req);
+  WaitRequests(2);
+  std::string resp;
+  while (CountOf(resp, "HTTP/1.1 200 OK\r\n") < 2) {
+    resp += Read();
+  }
+  EXPECT_NE(resp.find("Content-Encoding: gzip\r\n"), std::string::npos);
+  EXPECT_EQ(CountOf(resp, "Content-Length: "), 2);
+  EXPECT_EQ(resp.find("Content-Length: 1024\r\n"), std::string::npos);
+
+  auto pos = resp.find("Content-Length: ") + 16;
+  auto length = std::stoul(resp.substr(pos));
+  auto head_end = resp.find("\r\n\r\n") + 4;
+  EXPECT_EQ(resp.find("HTTP/1.1 200 OK\r\n", head_end), head_end + length);
+}
+
+TEST_F(DownstreamTest, PayloadTooLarge) {
+  Write("POST /echo HTTP/1.1\r\nContent-Length: 1048577\r\n\r\n");
+  while (!downstream_->tcp()->closed()) {
+    loop_->Once();
+  }
+  auto resp = Read();
+  EXPECT_EQ(resp.find("HTTP/1.1 413 Payload Too Large\r\n"), 0);
+  EXPECT_EQ(downstream_->nrequests(), 0);
+}
+
+TEST_F(DownstreamTest, BodyErrorAfterSent) {
+  // 404 不等待请求体，在请求体接收完之前就已经发送。
+  Write("POST /nope HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n");
+  WaitRequests(1);
+  auto resp = Read();
+  EXPECT_EQ(resp.find("HTTP/1.1 404 Not Found\r\n"), 0);
+  EXPECT_FALSE(downstream_->tcp()->closed());
+
+  // 之后请求体出错，没有响应需要发送，立即关闭连接。
+  Write("zz\r\n");
+  while (!downstream_->tcp()->closed()) {
+    loop_->Once();
+  }
+  char buf[16];
+  EXPECT_EQ(read(client_fd_, buf, sizeof(buf)), 0);
+}
+
+TEST_F(DownstreamTest, DestroyedAfterClose) {
+  Write("GET / HTTP/1.1\r\n\r\n");
+  WaitRequests(1);
+  Read();
+
+  // 和 Worker 一样在连接关闭后释放 Downstream。
+  std::weak_ptr<Downstream> weak = downstream_;
+  downstream_->tcp()->set_on_close([this]() { downstream_.reset(); });
+  close(client_fd_);
+  client_fd_ = -1;
+  while (!weak.expired()) {
+    loop_->Once();
+  }
+  EXPECT_EQ(loop_->buf_pool().nused(), 0);
+}
+
+TEST_F(DownstreamTimeoutTest, Header) {
+  // 请求头部没有接收完整。
+  Write("GET / HTTP/1.1\r\nHost: ");
+  auto start = std::chrono::steady_clock::now();
+  WaitClosed();
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(900));
+  EXPECT_EQ(downstream_->nrequests(), 0);
+  char buf[16];
+  EXPECT_EQ(read(client_fd_, buf, sizeof(buf)), 0);
+}
+
+TEST_F(DownstreamTimeoutTest, KeepAlive) {
+  Write("GET / HTTP/1.1\r\n\r\n");
+  WaitRequests(1);
+  auto resp = Read();
+  EXPECT_EQ(resp.rfind("HTTP/1.1 200 OK\r\n", 0), 0);
+  WaitClosed();
+  EXPECT_EQ(downstream_->nrequests(), 1);
+  char buf[16];
+  EXPECT_EQ(read(client_fd_, buf, sizeof(buf)), 0);
+}
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  ayaka::InitLogger();
+  return RUN_ALL_TESTS();
+}
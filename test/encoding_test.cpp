@@ -0,0 +1,64 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <encoding.hpp>
+
+#include "test.hpp"
+
+using ayaka::AcceptedEncodings;
+using ayaka::Encoding;
+using ayaka::EncodingBit;
+
+namespace {
+
+constexpr auto kBr = EncodingBit(Encoding::kBr);
+constexpr auto kZstd = EncodingBit(Encoding::kZstd);
+constexpr auto kGzip = EncodingBit(Encoding::kGzip);
+
+}  // namespace
+
+TEST(EncodingTest, Names) {
+  EXPECT_EQ(ayaka::EncodingName(Encoding::kBr), "br");
+  EXPECT_EQ(ayaka::EncodingName(Encoding::kIdentity), "");
+  EXPECT_EQ(ayaka::EncodingSuffix(Encoding::kZstd), ".zst");
+  EXPECT_EQ(ayaka::EncodingSuffix(Encoding::kGzip), ".gz");
+}
+
+TEST(EncodingTest, AcceptedEncodings) {
+  EXPECT_EQ(AcceptedEncodings(""), 0);
+  EXPECT_EQ(AcceptedEncodings("identity"), 0);
+  EXPECT_EQ(AcceptedEncodings("gzip"), kGzip);
+  EXPECT_EQ(AcceptedEncodings("gzip, deflate, br, zstd"),
+            kBr | kZstd | kGzip);
+  EXPECT_EQ(AcceptedEncodings(" GZIP ;q=0.5,BR"), kBr | kGzip);
+  EXPECT_EQ(AcceptedEncodings("x-gzip"), kGzip);
+  EXPECT_EQ(AcceptedEncodings("*"), kBr | kZstd | kGzip);
+}
+
+TEST(EncodingTest, ZeroQuality) {
+  EXPECT_EQ(AcceptedEncodings("gzip;q=0, br"), kBr);
+  EXPECT_EQ(AcceptedEncodings("gzip; q=0.000, br;q=0.001"), kBr);
+  EXPECT_EQ(AcceptedEncodings("*, br;q=0"), kZstd | kGzip);
+  EXPECT_EQ(AcceptedEncodings("*;q=0, gzip"), kGzip);
+  EXPECT_EQ(AcceptedEncodings("br;level=1;q=0"), 0);
+}
+
+int main(int argc, char *argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  ayaka::InitLogger();
+  return RUN_ALL_TESTS();
+}
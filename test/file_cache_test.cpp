@@ -0,0 +1,187 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <file_cache.hpp>
+#include <filesystem>
+#include <fstream>
+
+#include "test.hpp"
+
+using ayaka::CachedFile;
+using ayaka::File;
+using ayaka::FileCache;
+using std::filesystem::path;
+
+namespace {
+
+std::shared_ptr<const CachedFile> MakeCachedFile(const path &file_path,
+                                                 const std::string &content) {
+  {
+    std::ofstream out(file_path);
+    out << content;
+  }
+  auto file = File::Open(file_path.string());
+  return std::make_shared<CachedFile>(file_path.string(), file, "text/plain");
+}
+
+std::shared_ptr<const CachedFile> GetAsync(FileCache &cache,
+                                           const std::string &key) {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+  std::shared_ptr<const CachedFile> result;
+  cache.GetAsync(&loop, key,
+                 [&result](std::shared_ptr<const CachedFile> cached) {
+                   result = std::move(cached);
+                 });
+  uv_run(&loop, UV_RUN_DEFAULT);
+  uv_loop_close(&loop);
+  return result;
+}
+
+}  // namespace
+
+TEST(FileCacheTest, Default) {
+  FileCache cache;
+  EXPECT_EQ(cache.capacity(), FileCache::kDefaultCapacity);
+  EXPECT_EQ(cache.valid(), FileCache::kDefaultValid);
+  EXPECT_EQ(cache.mmap_max_file(), FileCache::kDefaultMmapMaxFile);
+  EXPECT_EQ(cache.Size(), 0);
+  EXPECT_EQ(cache.Get("foo"), nullptr);
+  EXPECT_EQ(cache.nmisses(), 1);
+}
+
+TEST(FileCacheTest, GetPut) {
+  auto file_path = path(testing::TempDir()) / "ayaka_file_cache_1.txt";
+  auto cached = MakeCachedFile(file_path, "hello");
+
+  FileCache cache(16, std::chrono::hours(1));
+  cache.Put("key", cached);
+  EXPECT_EQ(cache.Size(), 1);
+  EXPECT_EQ(cache.Get("key"), cached);
+  EXPECT_EQ(cache.Get("key")->mime(), "text/plain");
+  EXPECT_EQ(cache.nhits(), 2);
+
+  // 在有效期内，即使文件被删除也直接返回缓存项。
+  std::filesystem::remove(file_path);
+  EXPECT_EQ(cache.Get("key"), cached);
+}
+
+TEST(FileCacheTest, Lru) {
+  auto file_path = path(testing::TempDir()) / "ayaka_file_cache_2.txt";
+  auto cached = MakeCachedFile(file_path, "hello");
+
+  FileCache cache(2, std::chrono::hours(1));
+  cache.Put("a", cached);
+  cache.Put("b", cached);
+  EXPECT_NE(cache.Get("a"), nullptr);
+  // "b" 最久未被使用，被淘汰。
+  cache.Put("c", cached);
+  EXPECT_EQ(cache.Size(), 2);
+  EXPECT_NE(cache.Get("a"), nullptr);
+  EXPECT_EQ(cache.Get("b"), nullptr);
+  EXPECT_NE(cache.Get("c"), nullptr);
+
+  std::filesystem::remove(file_path);
+}
+
+TEST(FileCacheTest, Disabled) {
+  auto file_path = path(testing::TempDir()) / "ayaka_file_cache_3.txt";
+  auto cached = MakeCachedFile(file_path, "hello");
+
+  FileCache cache(0, std::chrono::hours(1));
+  cache.Put("key", cached);
+  EXPECT_EQ(cache.Size(), 0);
+  EXPECT_EQ(cache.Get("key"), nullptr);
+
+  std::filesystem::remove(file_path);
+}
+
+TEST(FileCacheTest, Revalidate) {
+  auto file_path = path(testing::TempDir()) / "ayaka_file_cache_4.txt";
+  auto cached = MakeCachedFile(file_path, "hello");
+
+  // 有效期为 0，每次都检查文件是否被修改。
+  FileCache cache(16, std::chrono::seconds(0));
+  cache.Put("key", cached);
+  EXPECT_EQ(cache.Get("key"), cached);
+
+  {
+    std::ofstream out(file_path, std::ios::app);
+    out << " world";
+  }
+  EXPECT_EQ(cache.Get("key"), nullptr);
+  EXPECT_EQ(cache.Size(), 0);
+
+  cache.Put("key", MakeCachedFile(file_path, "hello"));
+  std::filesystem::remove(file_path);
+  EXPECT_EQ(cache.Get("key"), nullptr);
+}
+
+TEST(FileCacheTest, GetAsync) {
+  auto file_path = path(testing::TempDir()) / "ayaka_file_cache_5.txt";
+  auto cached = MakeCachedFile(file_path, "hello");
+
+  FileCache cache(16, std::chrono::seconds(0));
+  EXPECT_EQ(GetAsync(cache, "key"), nullptr);
+  cache.Put("key", cached);
+  EXPECT_EQ(GetAsync(cache, "key"), cached);
+  EXPECT_EQ(cache.nhits(), 1);
+
+  {
+    std::ofstream out(file_path, std::ios::app);
+    out << " world";
+  }
+  EXPECT_EQ(GetAsync(cache, "key"), nullptr);
+  EXPECT_EQ(cache.Size(), 0);
+
+  cache.Put("key", MakeCachedFile(file_path, "hello"));
+  std::filesystem::remove(file_path);
+  EXPECT_EQ(GetAsync(cache, "key"), nullptr);
+  EXPECT_EQ(cache.nmisses(), 3);
+}
+
+TEST(FileCacheTest, Mappable) {
+  auto file_path = path(testing::TempDir()) / "ayaka_file_cache_5.txt";
+  auto cached = MakeCachedFile(file_path, "hello");
+  const auto &file = *cached->file();
+
+  EXPECT_FALSE(FileCache().Mappable(file));
+  EXPECT_TRUE(FileCache(16, std::chrono::hours(1), 5).Mappable(file));
+  EXPECT_FALSE(FileCache(16, std::chrono::hours(1), 4).Mappable(file));
+  // 禁用缓存时映射无法共享。
+  EXPECT_FALSE(FileCache(0, std::chrono::hours(1), 5).Mappable(file));
+
+  CachedFile mapped(file_path.string(), cached->file(), "text/plain");
+  EXPECT_EQ(mapped.mapped(), nullptr);
+  mapped.Map();
+  ASSERT_NE(mapped.mapped(), nullptr);
+  EXPECT_MEMEQ(mapped.mapped()->data(), "hello", 5);
+
+  std::filesystem::remove(file_path);
+}
+
+TEST(FileCacheTest, Local) {
+  auto &cache = FileCache::Local();
+  EXPECT_EQ(&cache, &FileCache::Local());
+  EXPECT_EQ(cache.capacity(), FileCache::kDefaultCapacity);
+}
+
+int main(int argc, char *argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  ayaka::InitLogger();
+  return RUN_ALL_TESTS();
+}
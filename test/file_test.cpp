@@ -0,0 +1,117 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <file.hpp>
+#include <filesystem>
+#include <fstream>
+
+#include "test.hpp"
+
+using ayaka::File;
+using ayaka::FileBody;
+using ayaka::MappedFile;
+using std::filesystem::path;
+
+TEST(FileTest, Open) {
+  auto file_path = path(testing::TempDir()) / "ayaka_file_test.txt";
+  {
+    std::ofstream out(file_path);
+    out << "hello";
+  }
+
+  auto file = File::Open(file_path.string());
+  ASSERT_NE(file, nullptr);
+  EXPECT_NE(file->fd(), -1);
+  EXPECT_EQ(file->size(), 5);
+  EXPECT_NE(file->mtime(), 0);
+
+  char buf[5];
+  EXPECT_EQ(pread(file->fd(), buf, sizeof(buf), 0), 5);
+  EXPECT_MEMEQ(buf, "hello", 5);
+
+  std::filesystem::remove(file_path);
+}
+
+TEST(FileTest, OpenFailed) {
+  EXPECT_EQ(File::Open("/path/does/not/exist"), nullptr);
+  // 目录不是普通文件。
+  EXPECT_EQ(File::Open(testing::TempDir()), nullptr);
+}
+
+TEST(FileTest, Move) {
+  auto file_path = path(testing::TempDir()) / "ayaka_file_test.txt";
+  {
+    std::ofstream out(file_path);
+    out << "hello";
+  }
+
+  auto file = File::Open(file_path.string());
+  ASSERT_NE(file, nullptr);
+  auto fd = file->fd();
+  File moved(std::move(*file));
+  EXPECT_EQ(moved.fd(), fd);
+  EXPECT_EQ(file->fd(), -1);
+
+  std::filesystem::remove(file_path);
+}
+
+TEST(FileBodyTest, Empty) {
+  FileBody body;
+  EXPECT_TRUE(body.Empty());
+  body = FileBody(std::make_shared<File>(), 0, 0);
+  EXPECT_TRUE(body.Empty());
+  body = FileBody(std::make_shared<File>(), 10, 20);
+  EXPECT_FALSE(body.Empty());
+  EXPECT_EQ(body.offset(), 10);
+  EXPECT_EQ(body.length(), 20);
+}
+
+TEST(MappedFileTest, Map) {
+  auto file_path = path(testing::TempDir()) / "ayaka_mapped_file_test.txt";
+  {
+    std::ofstream out(file_path);
+    out << "hello";
+  }
+
+  auto file = File::Open(file_path.string());
+  ASSERT_NE(file, nullptr);
+  auto mapped = MappedFile::Map(*file);
+  ASSERT_NE(mapped, nullptr);
+  EXPECT_EQ(mapped->size(), 5);
+  EXPECT_MEMEQ(mapped->data(), "hello", 5);
+
+  // 映射不依赖文件描述符和路径。
+  file.reset();
+  std::filesystem::remove(file_path);
+  EXPECT_MEMEQ(mapped->data(), "hello", 5);
+
+  // 空文件不能映射。
+  {
+    std::ofstream out(file_path);
+  }
+  file = File::Open(file_path.string());
+  ASSERT_NE(file, nullptr);
+  EXPECT_EQ(MappedFile::Map(*file), nullptr);
+
+  std::filesystem::remove(file_path);
+}
+
+int main(int argc, char *argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  ayaka::InitLogger();
+  return RUN_ALL_TESTS();
+}
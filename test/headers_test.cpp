@@ -0,0 +1,90 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <headers.hpp>
+#include <string>
+#include <vector>
+
+#include "test.hpp"
+
+using ayaka::Header;
+using ayaka::Headers;
+using ayaka::HeaderName;
+using ayaka::LookupHeader;
+using ayaka::ResponseHeaders;
+
+TEST(HeadersTest, Lookup) {
+  for (size_t i = 0; i < ayaka::kKnownHeaders; ++i) {
+    auto header = static_cast<Header>(i);
+    EXPECT_EQ(LookupHeader(HeaderName(header)), header);
+  }
+  EXPECT_EQ(LookupHeader("content-length"), Header::kContentLength);
+  EXPECT_EQ(LookupHeader("HOST"), Header::kHost);
+  EXPECT_EQ(LookupHeader("X-Forwarded-For"), Header::kUnknown);
+  EXPECT_EQ(LookupHeader("Hosts"), Header::kUnknown);
+  EXPECT_EQ(LookupHeader(""), Header::kUnknown);
+  EXPECT_EQ(HeaderName(Header::kUnknown), "");
+}
+
+TEST(HeadersTest, Access) {
+  Headers headers;
+  EXPECT_TRUE(headers.empty());
+  headers["host"] = "example.com";
+  headers["X-Custom"] = "1";
+  EXPECT_EQ(headers.size(), 2);
+  EXPECT_EQ(*headers.Find(Header::kHost), "example.com");
+  EXPECT_EQ(*headers.Find("HOST"), "example.com");
+  EXPECT_EQ(headers.at("x-custom"), "1");
+  EXPECT_EQ(headers.Find(Header::kRange), nullptr);
+  EXPECT_EQ(headers.Find("x-other"), nullptr);
+  EXPECT_THROW((void)headers.at("x-other"), std::out_of_range);
+
+  // 同名头部覆盖之前的值。
+  headers["X-CUSTOM"] = "2";
+  EXPECT_EQ(headers.size(), 2);
+  EXPECT_EQ(headers.at("x-custom"), "2");
+
+  headers.Erase(Header::kHost);
+  EXPECT_EQ(headers.Find("host"), nullptr);
+  EXPECT_EQ(headers.size(), 1);
+  headers.Erase(Header::kUnknown);
+  EXPECT_EQ(headers.size(), 1);
+  EXPECT_DEBUG_DEATH(headers[Header::kUnknown] = "1", ".*");
+  headers.clear();
+  EXPECT_TRUE(headers.empty());
+}
+
+TEST(HeadersTest, ForEach) {
+  ResponseHeaders headers;
+  headers["x-custom"] = "1";
+  headers[Header::kServer] = "Ayaka";
+  headers["content-type"] = "text/html";
+  std::vector<std::string> lines;
+  headers.ForEach([&](std::string_view name, const std::string& value) {
+    lines.push_back(std::string(name) + ": " + value);
+  });
+  // 常用头部使用规范名称并按 Header 的顺序排在前面。
+  std::vector<std::string> expected = {"Content-Type: text/html",
+                                       "Server: Ayaka", "x-custom: 1"};
+  EXPECT_EQ(lines, expected);
+}
+
+int main(int argc, char *argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  ayaka::InitLogger();
+  return RUN_ALL_TESTS();
+}
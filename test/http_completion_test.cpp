@@ -0,0 +1,111 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <http_completion.hpp>
+#include <http_except.hpp>
+
+#include "test.hpp"
+
+using ayaka::Http404Except;
+using ayaka::HttpCompletion;
+using ayaka::Loop;
+using ayaka::Request;
+using ayaka::Response;
+
+namespace {
+
+std::shared_ptr<Request> MakeRequest() {
+  auto req = std::make_shared<Request>();
+  req->set_method(ayaka::http_method::kGet);
+  req->set_url(ayaka::Url("/"));
+  req->set_version("HTTP/1.1");
+  return req;
+}
+
+}  // namespace
+
+TEST(HttpCompletionTest, Finish) {
+  auto loop = std::make_shared<Loop>();
+  auto resp = Response::Default();
+  int ncalls = 0;
+  std::exception_ptr result;
+  HttpCompletion completion(loop, MakeRequest(), resp,
+                            [&](std::exception_ptr except) {
+                              ++ncalls;
+                              result = std::move(except);
+                            });
+  EXPECT_EQ(completion.loop(), loop);
+  EXPECT_EQ(completion.resp(), resp);
+  EXPECT_FALSE(completion.Done());
+
+  // 副本共享同一个状态，只有第一次完成有效。
+  auto copy = completion;
+  copy.Finish();
+  EXPECT_TRUE(completion.Done());
+  completion.Fail(Http404Except("GET", "/"));
+  EXPECT_EQ(ncalls, 1);
+  EXPECT_EQ(result, nullptr);
+}
+
+TEST(HttpCompletionTest, Fail) {
+  std::exception_ptr result;
+  HttpCompletion completion(
+      std::make_shared<Loop>(), MakeRequest(), Response::Default(),
+      [&](std::exception_ptr except) { result = std::move(except); });
+  completion.Fail(Http404Except("GET", "/"));
+  EXPECT_THROW(std::rethrow_exception(result), Http404Except);
+}
+
+TEST(HttpCompletionTest, FailError) {
+  auto resp = Response::Default();
+  resp->headers()["X-Custom"] = "1";
+  int ncalls = 0;
+  std::exception_ptr result;
+  HttpCompletion completion(std::make_shared<Loop>(), MakeRequest(), resp,
+                            [&](std::exception_ptr except) {
+                              ++ncalls;
+                              result = std::move(except);
+                            });
+  completion.Fail(ayaka::HttpError::kNotFound);
+  // 不创建异常对象，直接在 resp 上生成错误响应。
+  EXPECT_EQ(ncalls, 1);
+  EXPECT_EQ(result, nullptr);
+  EXPECT_EQ(resp->status().code(), "404");
+  EXPECT_EQ(resp->headers().Find("X-Custom"), nullptr);
+  EXPECT_TRUE(resp->body());
+}
+
+TEST(HttpCompletionTest, Dropped) {
+  auto resp = Response::Default();
+  int ncalls = 0;
+  {
+    HttpCompletion completion(std::make_shared<Loop>(), MakeRequest(), resp,
+                              [&](std::exception_ptr except) {
+                                ++ncalls;
+                                EXPECT_EQ(except, nullptr);
+                              });
+  }
+  // 没有完成就被销毁时返回 500。
+  EXPECT_EQ(ncalls, 1);
+  EXPECT_EQ(resp->status().code(), "500");
+}
+
+int main(int argc, char *argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  ayaka::InitLogger();
+  return RUN_ALL_TESTS();
+}
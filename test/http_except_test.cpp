@@ -22,6 +22,8 @@
 using ayaka::Http400Except;
 using ayaka::Http404Except;
 using ayaka::Http405Except;
+using ayaka::Http413Except;
+using ayaka::Http500Except;
 using ayaka::Response;
 
 TEST(Http400ExceptTest, Example) {
@@ -38,6 +40,14 @@ TEST(Http404ExceptTest, Example) {
   except.SetUp(resp);
   EXPECT_EQ(resp->status().code(), "404");
   EXPECT_EQ(resp->status().msg(), "Not Found");
+  EXPECT_EQ(resp->headers()["Content-Type"], "text/html");
+  ASSERT_TRUE(resp->body());
+  EXPECT_FALSE(resp->body()->empty());
+
+  // 错误页面被所有响应共享，不会重新生成。
+  auto resp2 = Response::Default();
+  except.SetUp(resp2);
+  EXPECT_EQ(resp2->body(), resp->body());
 }
 
 TEST(Http405ExceptTest, Example) {
@@ -48,6 +58,22 @@ TEST(Http405ExceptTest, Example) {
   EXPECT_EQ(resp->status().msg(), "Method Not Allowed");
 }
 
+TEST(Http413ExceptTest, Example) {
+  Http413Except except;
+  auto resp = Response::Default();
+  except.SetUp(resp);
+  EXPECT_EQ(resp->status().code(), "413");
+  EXPECT_EQ(resp->status().msg(), "Payload Too Large");
+}
+
+TEST(Http500ExceptTest, Example) {
+  Http500Except except("GET", "/");
+  auto resp = Response::Default();
+  except.SetUp(resp);
+  EXPECT_EQ(resp->status().code(), "500");
+  EXPECT_EQ(resp->status().msg(), "Internal Server Error");
+}
+
 int main(int argc, char *argv[]) {
   testing::InitGoogleTest(&argc, argv);
   ayaka::InitLogger();
@@ -15,24 +15,29 @@
  * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <cstring>
 #include <http_except.hpp>
 #include <http_parser.hpp>
 
+#include <string>
+#include <vector>
+
 #include "test.hpp"
 
+using ayaka::BufPool;
+using ayaka::BufRef;
 using ayaka::HeaderParser;
-using ayaka::Http400Except;
+using ayaka::HttpError;
 using ayaka::RequestParser;
 using ayaka::RequestStartLineParser;
 
 TEST(RequestStartLineParserTest, Simple1) {
   RequestStartLineParser parser;
   std::string str = "GET / HTTP/1.1\r\n";
-  for (char ch : str) {
-    parser.Step(ch);
-  }
+  EXPECT_EQ(parser.Exec(str), str.size());
 
   EXPECT_EQ(parser.method(), "GET");
+  EXPECT_EQ(parser.method_id(), ayaka::HttpMethod::kGet);
   EXPECT_EQ(parser.url(), "/");
   EXPECT_EQ(parser.version(), "HTTP/1.1");
   EXPECT_EQ(parser.state(), RequestStartLineParser::State::kDone);
@@ -41,31 +46,48 @@ TEST(RequestStartLineParserTest, Simple1) {
 TEST(RequestStartLineParserTest, Simple2) {
   RequestStartLineParser parser;
   std::string str = "POST /foo/bar HTTP/2.0\r\n";
-  for (char ch : str) {
-    parser.Step(ch);
-  }
+  EXPECT_EQ(parser.Exec(str), str.size());
 
   EXPECT_EQ(parser.method(), "POST");
+  EXPECT_EQ(parser.method_id(), ayaka::HttpMethod::kPost);
   EXPECT_EQ(parser.url(), "/foo/bar");
   EXPECT_EQ(parser.version(), "HTTP/2.0");
   EXPECT_EQ(parser.state(), RequestStartLineParser::State::kDone);
 }
 
+TEST(RequestStartLineParserTest, ExtensionMethod) {
+  RequestStartLineParser parser;
+  std::string str = "PROPFIND /dav HTTP/1.1\r\n";
+  EXPECT_EQ(parser.Exec(str), str.size());
+  EXPECT_EQ(parser.method(), "PROPFIND");
+  EXPECT_EQ(parser.method_id(), ayaka::HttpMethod::kUnknown);
+}
+
 TEST(RequestStartLineParserTest, Simple3) {
   RequestStartLineParser parser;
   std::string str = "POST /foo/bar HTTP/2.0\r\r";
-  EXPECT_THROW(
-      for (char ch
-           : str) { parser.Step(ch); },
-      Http400Except);
+  parser.Exec(str);
+  EXPECT_EQ(parser.state(), RequestStartLineParser::State::kError);
+}
+
+TEST(RequestStartLineParserTest, Moved) {
+  RequestStartLineParser parser;
+  std::string part = "GET /fo";
+  EXPECT_EQ(parser.Exec(part), part.size());
+  EXPECT_EQ(parser.state(), RequestStartLineParser::State::kUrl);
+
+  // 已经解析的部分被复制到其他地址后继续解析。
+  std::string str = "GET /foo HTTP/1.1\r\nHost";
+  EXPECT_EQ(parser.Exec(str, part.size()), str.size() - 4);
+  EXPECT_EQ(parser.method(), "GET");
+  EXPECT_EQ(parser.url(), "/foo");
+  EXPECT_EQ(parser.version(), "HTTP/1.1");
 }
 
 TEST(HeaderParserTest, Simple1) {
   HeaderParser parser;
   std::string str = "\r\n";
-  for (char ch : str) {
-    parser.Step(ch);
-  }
+  EXPECT_EQ(parser.Exec(str), str.size());
 
   EXPECT_TRUE(parser.headers().empty());
   EXPECT_EQ(parser.state(), HeaderParser::State::kDone);
@@ -74,9 +96,7 @@ TEST(HeaderParserTest, Simple1) {
 TEST(HeaderParserTest, Simple2) {
   HeaderParser parser;
   std::string str = "Host: example.com\r\n\r\n";
-  for (char ch : str) {
-    parser.Step(ch);
-  }
+  EXPECT_EQ(parser.Exec(str), str.size());
 
   EXPECT_EQ(parser.headers().size(), 1);
   EXPECT_EQ(parser.headers()["host"], "example.com");
@@ -86,9 +106,7 @@ TEST(HeaderParserTest, Simple2) {
 TEST(HeaderParserTest, Simple3) {
   HeaderParser parser;
   std::string str = "Host:example.com\r\n\r\n";
-  for (char ch : str) {
-    parser.Step(ch);
-  }
+  EXPECT_EQ(parser.Exec(str), str.size());
 
   EXPECT_EQ(parser.headers().size(), 1);
   EXPECT_EQ(parser.headers()["host"], "example.com");
@@ -98,9 +116,7 @@ TEST(HeaderParserTest, Simple3) {
 TEST(HeaderParserTest, Simple4) {
   HeaderParser parser;
   std::string str = "Host: example.com\r\nContent-Length: 0\r\n\r\n";
-  for (char ch : str) {
-    parser.Step(ch);
-  }
+  EXPECT_EQ(parser.Exec(str), str.size());
 
   EXPECT_EQ(parser.headers().size(), 2);
   EXPECT_EQ(parser.headers()["host"], "example.com");
@@ -111,19 +127,15 @@ TEST(HeaderParserTest, Simple4) {
 TEST(HeaderParserTest, Simple5) {
   HeaderParser parser;
   std::string str = "Host: example.com\r\r\r\n";
-  EXPECT_THROW(
-      for (char ch
-           : str) { parser.Step(ch); },
-      Http400Except);
+  parser.Exec(str);
+  EXPECT_EQ(parser.state(), HeaderParser::State::kError);
 }
 
 TEST(HeaderParserTest, Simple6) {
   HeaderParser parser;
   std::string str = "Host: example.com\r\n\r\r";
-  EXPECT_THROW(
-      for (char ch
-           : str) { parser.Step(ch); },
-      Http400Except);
+  parser.Exec(str);
+  EXPECT_EQ(parser.state(), HeaderParser::State::kError);
 }
 
 TEST(RequestParserTest, Simple1) {
@@ -166,6 +178,216 @@ TEST(RequestParserTest, Simple2) {
   EXPECT_EQ(req->headers()["content-type"], "text/plain");
 }
 
+TEST(RequestParserTest, ZeroCopy) {
+  BufPool pool(1024, 4);
+  auto *buf = pool.Acquire();
+  std::string str =
+      "GET /foo HTTP/1.1\r\nHost: example.com\r\n\r\nGET / HTTP/1.1\r\n";
+  memcpy(buf, str.data(), str.size());
+
+  RequestParser parser;
+  size_t nparsed = 0;
+  {
+    BufRef buf_ref(pool, buf);
+    nparsed = parser.Exec(buf, str.size(), buf_ref);
+  }
+  pool.Release(buf);
+  EXPECT_EQ(nparsed, str.find("GET /", 1));
+  EXPECT_EQ(parser.state(), RequestParser::State::kDone);
+
+  // 请求直接引用接收缓冲区，并且持有它。
+  auto req = parser.req();
+  EXPECT_EQ(pool.nused(), 1);
+  EXPECT_TRUE(req->head().empty());
+  EXPECT_EQ(req->method_id(), ayaka::HttpMethod::kGet);
+  EXPECT_EQ(req->version().data(), buf + str.find("HTTP/1.1"));
+  EXPECT_EQ(req->headers().at("HOST"), "example.com");
+  EXPECT_EQ(req->url().path().string(), "/foo");
+
+  parser.Reset();
+  req.reset();
+  EXPECT_EQ(pool.nused(), 0);
+}
+
+TEST(RequestParserTest, SplitRead) {
+  BufPool pool(1024, 4);
+  std::string str =
+      "GET / HTTP/1.1\r\nHost: example.com\r\nAccept: */*\r\n\r\nGET";
+  auto split = str.find("com");
+
+  RequestParser parser;
+  auto *buf = pool.Acquire();
+  memcpy(buf, str.data(), split);
+  {
+    BufRef buf_ref(pool, buf);
+    EXPECT_EQ(parser.Exec(buf, split, buf_ref), split);
+  }
+  pool.Release(buf);
+  EXPECT_EQ(parser.state(), RequestParser::State::kHeader);
+
+  buf = pool.Acquire();
+  memcpy(buf, str.data() + split, str.size() - split);
+  {
+    BufRef buf_ref(pool, buf);
+    EXPECT_EQ(parser.Exec(buf, str.size() - split, buf_ref),
+              str.size() - split - 3);
+  }
+  pool.Release(buf);
+  EXPECT_EQ(parser.state(), RequestParser::State::kDone);
+
+  // 跨越两次读取的请求头部被复制，不持有接收缓冲区。
+  auto req = parser.req();
+  EXPECT_EQ(pool.nused(), 0);
+  EXPECT_TRUE(req->buf().Empty());
+  EXPECT_EQ(req->head().size(), str.size() - 3);
+  EXPECT_EQ(req->method(), "GET");
+  EXPECT_EQ(req->headers().size(), 2);
+  EXPECT_EQ(req->headers().at("host"), "example.com");
+  EXPECT_EQ(req->headers().at("accept"), "*/*");
+}
+
+namespace {
+
+/**
+ * 逐次调用 Exec 直到消耗完 str，返回请求体。
+ */
+std::string ParseAll(RequestParser &parser, const std::string &str) {
+  size_t pos = 0;
+  while (pos < str.size() && parser.state() != RequestParser::State::kDone &&
+         parser.state() != RequestParser::State::kError) {
+    pos += parser.Exec(str.data() + pos, str.size() - pos);
+    if (parser.state() == RequestParser::State::kBody &&
+        parser.req()->body().nreceived() == 0) {
+      parser.req()->body().ReadAll([](std::exception_ptr) {});
+    }
+  }
+  const auto &content = parser.req()->body().content();
+  return {content.begin(), content.end()};
+}
+
+}  // namespace
+
+TEST(RequestParserTest, ContentLength) {
+  RequestParser parser;
+  std::string head = "POST / HTTP/1.1\r\nContent-Length: 11\r\n\r\n";
+  std::string str = head + "hello worldGET / HTTP/1.1\r\n\r\n";
+
+  // 请求头部完成时停止，以便处理器在请求体到达之前开始处理。
+  EXPECT_EQ(parser.Exec(str.data(), str.size()), head.size());
+  EXPECT_EQ(parser.state(), RequestParser::State::kBody);
+  EXPECT_FALSE(parser.InHead());
+  EXPECT_EQ(parser.req()->body().length(), 11);
+
+  EXPECT_EQ(parser.Exec(str.data() + head.size(), 5), 5);
+  EXPECT_EQ(parser.Exec(str.data() + head.size() + 5, str.size()), 6);
+  EXPECT_EQ(parser.state(), RequestParser::State::kDone);
+  EXPECT_TRUE(parser.req()->body().done());
+  const auto &content = parser.req()->body().content();
+  EXPECT_EQ(std::string(content.begin(), content.end()), "hello world");
+}
+
+TEST(RequestParserTest, Chunked) {
+  RequestParser parser;
+  std::string str =
+      "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+      "5\r\nhello\r\n"
+      "6;name=value\r\n world\r\n"
+      "0\r\nX-Trailer: 1\r\n\r\n";
+  EXPECT_EQ(ParseAll(parser, str), "hello world");
+  EXPECT_EQ(parser.req()->body().length(), ayaka::RequestBody::kChunked);
+
+  // 逐字节解析。
+  parser.Reset();
+  size_t pos = 0;
+  while (parser.state() != RequestParser::State::kDone) {
+    pos += parser.Exec(str.data() + pos, 1);
+  }
+  EXPECT_EQ(pos, str.size());
+  EXPECT_EQ(parser.req()->body().nreceived(), 11);
+}
+
+TEST(RequestParserTest, NoBody) {
+  RequestParser parser;
+  std::string str = "POST / HTTP/1.1\r\nContent-Length: 0\r\n\r\n";
+  EXPECT_EQ(parser.Exec(str.data(), str.size()), str.size());
+  EXPECT_EQ(parser.state(), RequestParser::State::kDone);
+  EXPECT_TRUE(parser.req()->body().Empty());
+}
+
+TEST(RequestParserTest, BadBody) {
+  std::vector<std::string> heads = {
+      "Content-Length: abc\r\n",
+      "Content-Length: -1\r\n",
+      "Content-Length: 1\r\nTransfer-Encoding: chunked\r\n",
+      "Transfer-Encoding: gzip\r\n",
+  };
+  for (const auto &head : heads) {
+    RequestParser parser;
+    std::string str = "POST / HTTP/1.1\r\n" + head + "\r\n";
+    (void)parser.Exec(str.data(), str.size());
+    EXPECT_EQ(parser.state(), RequestParser::State::kError);
+    EXPECT_EQ(parser.error(), HttpError::kBadRequest);
+  }
+
+  RequestParser parser;
+  std::string str =
+      "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nxyz\r\n";
+  ParseAll(parser, str);
+  EXPECT_EQ(parser.state(), RequestParser::State::kError);
+  EXPECT_EQ(parser.error(), HttpError::kBadRequest);
+
+  // Reset 之后可以继续解析。
+  parser.Reset();
+  EXPECT_EQ(parser.error(), HttpError::kNone);
+  str = "GET / HTTP/1.1\r\n\r\n";
+  EXPECT_EQ(parser.Exec(str.data(), str.size()), str.size());
+  EXPECT_EQ(parser.state(), RequestParser::State::kDone);
+}
+
+TEST(RequestParserTest, Smuggling) {
+  std::vector<std::string> heads = {
+      "Content-Length: 5\r\nContent-Length: 6\r\n",
+      "Content-Length: 5\r\ncontent-length: 50\r\n",
+      "Transfer-Encoding: chunked\r\nTransfer-Encoding: chunked\r\n",
+      "Transfer-Encoding: gzip\r\nTransfer-Encoding: chunked\r\n",
+      "Transfer-Encoding: chunked, chunked\r\n",
+      "Transfer-Encoding: chunked, gzip\r\n",
+  };
+  for (const auto &head : heads) {
+    RequestParser parser;
+    std::string str = "POST / HTTP/1.1\r\n" + head + "\r\n";
+    (void)parser.Exec(str.data(), str.size());
+    EXPECT_EQ(parser.state(), RequestParser::State::kError) << head;
+    EXPECT_EQ(parser.error(), HttpError::kBadRequest) << head;
+  }
+
+  // 值相同的多个 Content-Length 是允许的。
+  RequestParser parser;
+  std::string str =
+      "POST / HTTP/1.1\r\nContent-Length: 5\r\nContent-Length: 5 \r\n\r\n"
+      "hello";
+  ParseAll(parser, str);
+  EXPECT_EQ(parser.state(), RequestParser::State::kDone);
+}
+
+TEST(RequestParserTest, MaxBodySize) {
+  RequestParser parser;
+  parser.set_max_body_size(10);
+  std::string str = "POST / HTTP/1.1\r\nContent-Length: 11\r\n\r\n";
+  (void)parser.Exec(str.data(), str.size());
+  EXPECT_EQ(parser.state(), RequestParser::State::kError);
+  EXPECT_EQ(parser.error(), HttpError::kPayloadTooLarge);
+
+  parser.Reset();
+  str =
+      "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+      "5\r\nhello\r\n6\r\n world\r\n0\r\n\r\n";
+  ParseAll(parser, str);
+  EXPECT_EQ(parser.error(), HttpError::kPayloadTooLarge);
+  // 超过限制的块在接收之前就被拒绝。
+  EXPECT_EQ(parser.req()->body().nreceived(), 5);
+}
+
 int main(int argc, char *argv[]) {
   testing::InitGoogleTest(&argc, argv);
   ayaka::InitLogger();
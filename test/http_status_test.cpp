@@ -44,6 +44,17 @@ TEST(HttpStatusTest, Predefined) {
   EXPECT_EQ(HttpStatus::MethodNotAllowed().msg(), "Method Not Allowed");
 }
 
+TEST(HttpStatusTest, Line) {
+  EXPECT_EQ(HttpStatus::Ok().line(), "HTTP/1.1 200 OK\r\n");
+  EXPECT_EQ(HttpStatus::PayloadTooLarge().line(),
+            "HTTP/1.1 413 Payload Too Large\r\n");
+  // 预定义的状态指向同一个 StatusLine。
+  EXPECT_EQ(HttpStatus::NotFound().line().data(),
+            HttpStatus::NotFound().line().data());
+  EXPECT_TRUE(HttpStatus("304", "Not Modified").line().empty());
+  EXPECT_TRUE(HttpStatus().line().empty());
+}
+
 int main(int argc, char *argv[]) {
   testing::InitGoogleTest(&argc, argv);
   ayaka::InitLogger();
@@ -0,0 +1,105 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <range.hpp>
+#include <vector>
+
+#include "test.hpp"
+
+using ayaka::ByteRange;
+using ayaka::ParseRange;
+using ayaka::RangeResult;
+
+namespace {
+
+/**
+ * 把解析结果转换为 {offset, length, offset, length, ...}，便于比较。
+ */
+std::vector<size_t> Flatten(const std::vector<ByteRange>& ranges) {
+  std::vector<size_t> result;
+  for (const auto& range : ranges) {
+    result.push_back(range.offset);
+    result.push_back(range.length);
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(RangeTest, Single) {
+  std::vector<ByteRange> ranges;
+  EXPECT_EQ(ParseRange("bytes=0-499", 1000, ranges), RangeResult::kOk);
+  EXPECT_EQ(Flatten(ranges), (std::vector<size_t>{0, 500}));
+  EXPECT_EQ(ParseRange("bytes=500-", 1000, ranges), RangeResult::kOk);
+  EXPECT_EQ(Flatten(ranges), (std::vector<size_t>{500, 500}));
+  EXPECT_EQ(ParseRange("bytes=-300", 1000, ranges), RangeResult::kOk);
+  EXPECT_EQ(Flatten(ranges), (std::vector<size_t>{700, 300}));
+  // 超出内容的部分被截断。
+  EXPECT_EQ(ParseRange("bytes=900-2000", 1000, ranges), RangeResult::kOk);
+  EXPECT_EQ(Flatten(ranges), (std::vector<size_t>{900, 100}));
+  EXPECT_EQ(ParseRange("Bytes=-2000", 1000, ranges), RangeResult::kOk);
+  EXPECT_EQ(Flatten(ranges), (std::vector<size_t>{0, 1000}));
+}
+
+TEST(RangeTest, Multiple) {
+  std::vector<ByteRange> ranges;
+  EXPECT_EQ(ParseRange(" bytes=0-0, ,-1,5-9 ", 1000, ranges),
+            RangeResult::kOk);
+  EXPECT_EQ(Flatten(ranges), (std::vector<size_t>{0, 1, 999, 1, 5, 5}));
+  // 忽略不能满足的范围。
+  EXPECT_EQ(ParseRange("bytes=2000-3000,10-19", 1000, ranges),
+            RangeResult::kOk);
+  EXPECT_EQ(Flatten(ranges), (std::vector<size_t>{10, 10}));
+}
+
+TEST(RangeTest, Unsatisfiable) {
+  std::vector<ByteRange> ranges;
+  EXPECT_EQ(ParseRange("bytes=1000-", 1000, ranges),
+            RangeResult::kUnsatisfiable);
+  EXPECT_EQ(ParseRange("bytes=-0", 1000, ranges),
+            RangeResult::kUnsatisfiable);
+  EXPECT_EQ(ParseRange("bytes=0-", 0, ranges), RangeResult::kUnsatisfiable);
+  EXPECT_TRUE(ranges.empty());
+}
+
+TEST(RangeTest, Invalid) {
+  std::vector<ByteRange> ranges;
+  for (const auto* value :
+       {"", "bytes=", "bytes=,", "items=0-1", "bytes 0-1", "bytes=1",
+        "bytes=-", "bytes=a-b", "bytes=5-4", "bytes=0-1,x",
+        "bytes=+1-2", "bytes=1-2-3"}) {
+    EXPECT_EQ(ParseRange(value, 1000, ranges), RangeResult::kNone) << value;
+  }
+
+  std::string many = "bytes=0-0";
+  for (size_t i = 1; i <= ayaka::kMaxRanges; ++i) {
+    many += "," + std::to_string(i) + "-" + std::to_string(i);
+  }
+  EXPECT_EQ(ParseRange(many, 1000, ranges), RangeResult::kNone);
+}
+
+TEST(RangeTest, ContentRange) {
+  EXPECT_EQ(ayaka::ContentRange({0, 500}, 1234), "bytes 0-499/1234");
+  EXPECT_EQ(ayaka::ContentRange({1233, 1}, 1234), "bytes 1233-1233/1234");
+  EXPECT_EQ(ayaka::UnsatisfiedRange(1234), "bytes */1234");
+}
+
+int main(int argc, char *argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  ayaka::InitLogger();
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,102 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <http_except.hpp>
+#include <request_body.hpp>
+#include <string>
+
+#include "test.hpp"
+
+using ayaka::RequestBody;
+
+TEST(RequestBodyTest, Default) {
+  RequestBody body;
+  EXPECT_TRUE(body.Empty());
+  EXPECT_TRUE(body.done());
+  bool ended = false;
+  body.ReadAll([&](std::exception_ptr except) {
+    EXPECT_FALSE(except);
+    ended = true;
+  });
+  EXPECT_TRUE(ended);
+  EXPECT_TRUE(body.content().empty());
+}
+
+TEST(RequestBodyTest, Read) {
+  RequestBody body(11);
+  // 开始读取之前到达的数据被暂存。
+  body.Append("hello");
+  std::string data;
+  bool ended = false;
+  body.Read([&](std::string_view chunk) { data += chunk; },
+            [&](std::exception_ptr except) {
+              EXPECT_FALSE(except);
+              ended = true;
+            });
+  EXPECT_EQ(data, "hello");
+  body.Append(" world");
+  EXPECT_EQ(data, "hello world");
+  EXPECT_FALSE(ended);
+  body.Finish();
+  EXPECT_TRUE(ended);
+  EXPECT_EQ(body.nreceived(), 11);
+  EXPECT_TRUE(body.content().empty());
+}
+
+TEST(RequestBodyTest, ReadAll) {
+  RequestBody body(RequestBody::kChunked);
+  body.Append("hello");
+  bool ended = false;
+  body.ReadAll([&](std::exception_ptr except) {
+    EXPECT_FALSE(except);
+    ended = true;
+  });
+  body.Append(" world");
+  EXPECT_FALSE(ended);
+  body.Finish();
+  EXPECT_TRUE(ended);
+  EXPECT_EQ(std::string(body.content().begin(), body.content().end()),
+            "hello world");
+}
+
+TEST(RequestBodyTest, Abort) {
+  RequestBody body(100);
+  std::exception_ptr result;
+  body.ReadAll([&](std::exception_ptr except) { result = except; });
+  body.Append("hello");
+  body.Abort(std::make_exception_ptr(ayaka::Http413Except()));
+  EXPECT_TRUE(body.done());
+  EXPECT_THROW(std::rethrow_exception(result), ayaka::Http413Except);
+  EXPECT_TRUE(body.content().empty());
+  // 已经结束的请求体不会再被中止。
+  body.Abort(nullptr);
+}
+
+TEST(RequestBodyTest, Discard) {
+  RequestBody body(10);
+  body.Append("hello");
+  body.Discard();
+  body.Append("world");
+  EXPECT_TRUE(body.content().empty());
+  EXPECT_EQ(body.nreceived(), 10);
+}
+
+int main(int argc, char *argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  ayaka::InitLogger();
+  return RUN_ALL_TESTS();
+}
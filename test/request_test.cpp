@@ -0,0 +1,83 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <request.hpp>
+
+#include "test.hpp"
+
+using ayaka::Request;
+
+TEST(RequestTest, Method) {
+  using ayaka::HttpMethod;
+  for (size_t i = 0; i <= ayaka::kKnownMethods; ++i) {
+    auto method = static_cast<HttpMethod>(i);
+    EXPECT_EQ(ayaka::ParseMethod(ayaka::MethodName(method)), method);
+  }
+  EXPECT_EQ(ayaka::ParseMethod("get"), HttpMethod::kUnknown);
+  EXPECT_EQ(ayaka::ParseMethod("POSTS"), HttpMethod::kUnknown);
+  EXPECT_EQ(ayaka::ParseMethod("PUSH"), HttpMethod::kUnknown);
+
+  Request req;
+  EXPECT_EQ(req.method_id(), HttpMethod::kUnknown);
+  EXPECT_EQ(req.method(), "UNKNOWN");
+  req.set_method("DELETE");
+  EXPECT_EQ(req.method_id(), HttpMethod::kDelete);
+  EXPECT_EQ(req.method(), "DELETE");
+  // 扩展方法保留原始 token。
+  req.set_method("PROPFIND");
+  EXPECT_EQ(req.method_id(), HttpMethod::kUnknown);
+  EXPECT_EQ(req.method(), "PROPFIND");
+}
+
+TEST(RequestTest, KeepAliveHttp11) {
+  Request req;
+  req.set_version("HTTP/1.1");
+  EXPECT_TRUE(req.KeepAlive());
+  req.headers()["connection"] = "keep-alive";
+  EXPECT_TRUE(req.KeepAlive());
+  req.headers()["connection"] = "close";
+  EXPECT_FALSE(req.KeepAlive());
+  req.headers()["connection"] = "Upgrade, Close";
+  EXPECT_FALSE(req.KeepAlive());
+  req.headers()["connection"] = "closed";
+  EXPECT_TRUE(req.KeepAlive());
+}
+
+TEST(RequestTest, KeepAliveHttp10) {
+  Request req;
+  req.set_version("HTTP/1.0");
+  EXPECT_FALSE(req.KeepAlive());
+  req.headers()["connection"] = "Keep-Alive";
+  EXPECT_TRUE(req.KeepAlive());
+  req.headers()["connection"] = " keep-alive ,foo";
+  EXPECT_TRUE(req.KeepAlive());
+  req.headers()["connection"] = "close";
+  EXPECT_FALSE(req.KeepAlive());
+}
+
+TEST(RequestTest, KeepAliveUnknownVersion) {
+  Request req;
+  req.set_version("HTTP/0.9");
+  req.headers()["connection"] = "keep-alive";
+  EXPECT_FALSE(req.KeepAlive());
+}
+
+int main(int argc, char *argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  ayaka::InitLogger();
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,110 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <location.hpp>
+#include <memory>
+#include <router.hpp>
+
+#include "test.hpp"
+
+using ayaka::DirLocation;
+using ayaka::HttpHandler;
+using ayaka::PathLocation;
+using ayaka::Router;
+
+namespace {
+
+std::shared_ptr<HttpHandler> MakeHandler() {
+  return std::make_shared<ayaka::Http404Handler>();
+}
+
+}  // namespace
+
+TEST(RouterTest, Empty) {
+  Router router;
+  EXPECT_EQ(router.Route("/"), nullptr);
+  EXPECT_EQ(router.Route(""), nullptr);
+}
+
+TEST(RouterTest, Path) {
+  Router router;
+  auto root = MakeHandler();
+  auto foo = MakeHandler();
+  auto foobar = MakeHandler();
+  router.AddLocation(std::make_shared<PathLocation>("/", root));
+  router.AddLocation(std::make_shared<PathLocation>("/foo/bar", foobar));
+  // 拆分已有的节点。
+  router.AddLocation(std::make_shared<PathLocation>("/foo", foo));
+
+  EXPECT_EQ(router.Route("/"), root);
+  EXPECT_EQ(router.Route("/foo"), foo);
+  EXPECT_EQ(router.Route("/foo/bar"), foobar);
+  EXPECT_EQ(router.Route("/fo"), nullptr);
+  EXPECT_EQ(router.Route("/foo/"), nullptr);
+  EXPECT_EQ(router.Route("/foo/bar/"), nullptr);
+  EXPECT_EQ(router.Route("/foo/baz"), nullptr);
+}
+
+TEST(RouterTest, Dir) {
+  Router router;
+  auto root = MakeHandler();
+  auto foo = MakeHandler();
+  auto foobar = MakeHandler();
+  router.AddLocation(std::make_shared<DirLocation>("/", root));
+  router.AddLocation(std::make_shared<DirLocation>("/foo/bar/", foobar));
+  router.AddLocation(std::make_shared<DirLocation>("/foo", foo));
+
+  // 匹配键最长的 DirLocation。
+  EXPECT_EQ(router.Route("/"), root);
+  EXPECT_EQ(router.Route("/index.html"), root);
+  EXPECT_EQ(router.Route("/foo"), foo);
+  EXPECT_EQ(router.Route("/foobar"), foo);
+  EXPECT_EQ(router.Route("/foo/bar"), foo);
+  EXPECT_EQ(router.Route("/foo/bar/"), foobar);
+  EXPECT_EQ(router.Route("/foo/bar/index.html"), foobar);
+}
+
+TEST(RouterTest, PathAndDir) {
+  Router router;
+  auto dir = MakeHandler();
+  auto index = MakeHandler();
+  router.AddLocation(std::make_shared<DirLocation>("/static/", dir));
+  router.AddLocation(
+      std::make_shared<PathLocation>("/static/index.html", index));
+
+  // PathLocation 优先于 DirLocation。
+  EXPECT_EQ(router.Route("/static/index.html"), index);
+  EXPECT_EQ(router.Route("/static/index.htm"), dir);
+  EXPECT_EQ(router.Route("/static/index.html5"), dir);
+  EXPECT_EQ(router.Route("/static"), nullptr);
+}
+
+TEST(RouterTest, Duplicate) {
+  Router router;
+  auto first = MakeHandler();
+  router.AddLocation(std::make_shared<PathLocation>("/foo/../bar", first));
+  router.AddLocation(std::make_shared<PathLocation>("/bar", MakeHandler()));
+  router.AddLocation(std::make_shared<DirLocation>("", MakeHandler()));
+  EXPECT_EQ(router.Route("/bar"), first);
+  EXPECT_EQ(router.Route("/"), nullptr);
+}
+
+int main(int argc, char *argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  ayaka::InitLogger();
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,68 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <random>
+#include <scan.hpp>
+#include <string>
+
+#include "test.hpp"
+
+using ayaka::ScanFor;
+
+TEST(ScanTest, ScanFor) {
+  std::string str = "GET /index.html HTTP/1.1\r\n";
+  EXPECT_EQ(ScanFor(str, 0, ' ', '\t'), 3);
+  EXPECT_EQ(ScanFor(str, 4, ' ', '\t'), 15);
+  EXPECT_EQ(ScanFor(str, 0, '\r'), 24);
+  EXPECT_EQ(ScanFor(str, 0, ':'), str.size());
+  EXPECT_EQ(ScanFor(str, str.size(), '\r'), str.size());
+  EXPECT_EQ(ScanFor("", 0, '\r'), 0);
+}
+
+TEST(ScanTest, Impls) {
+  // 在不同的长度和位置上比较各个实现与逐字节实现的结果。
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> dist('a', 'z');
+  for (size_t len = 0; len < 100; ++len) {
+    std::string str(len, ' ');
+    for (auto &ch : str) {
+      ch = static_cast<char>(dist(gen));
+    }
+    for (size_t pos = 0; pos <= len; ++pos) {
+      auto copy = str;
+      if (pos < len) {
+        copy[pos] = ':';
+      }
+      auto expected = ayaka::detail::ScanScalar(copy.data(), len, ':', '\r');
+      EXPECT_EQ(expected, pos);
+#if defined(__x86_64__)
+      EXPECT_EQ(ayaka::detail::ScanSse2(copy.data(), len, ':', '\r'),
+                expected);
+      if (ayaka::detail::CpuHasAvx2()) {
+        EXPECT_EQ(ayaka::detail::ScanAvx2(copy.data(), len, ':', '\r'),
+                  expected);
+      }
+#endif
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  ayaka::InitLogger();
+  return RUN_ALL_TESTS();
+}
@@ -15,10 +15,13 @@
  * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <filesystem>
+#include <fstream>
 #include <send_pack.hpp>
 
 #include "test.hpp"
 
+using ayaka::BufPool;
 using ayaka::HttpStatus;
 using ayaka::Response;
 using ayaka::SendRespPack;
@@ -31,31 +34,141 @@ TEST(SendRespPackTest, Default) {
   EXPECT_FALSE(pack.on_finish());
 }
 
-TEST(SendRespPackTest, Constructor) {
+namespace {
+
+constexpr const char *kDate = "Sat, 01 Jan 2022 00:00:00 GMT";
+
+/**
+ * 固定 Date，使输出可以逐字节比较。
+ */
+std::shared_ptr<Response> MakeResponse(HttpStatus status) {
   auto resp = std::make_shared<Response>();
   resp->set_version("HTTP/1.1");
-  resp->set_status(HttpStatus::Ok());
+  resp->set_status(std::move(status));
+  resp->headers()[ayaka::Header::kDate] = kDate;
+  return resp;
+}
+
+/**
+ * 常用头部按 Header 的顺序排列，之后是自动添加的 Server。
+ */
+std::string Head(const std::string &status_line) {
+  return status_line + "\r\nDate: " + kDate + "\r\nServer: " +
+         std::string(Response::ServerName()) + "\r\n";
+}
+
+std::string Join(const SendRespPack &pack) {
+  std::string data;
+  for (const auto &buf : pack.bufs()) {
+    data.append(buf.base, buf.len);
+  }
+  return data;
+}
+
+}  // namespace
+
+TEST(SendRespPackTest, Constructor) {
+  auto resp = MakeResponse(HttpStatus::Ok());
 
   SendRespPack pack(resp);
   EXPECT_NE(pack.uv_write(), nullptr);
   EXPECT_EQ(pack.resp(), resp);
   EXPECT_FALSE(pack.on_finish());
 
-  EXPECT_EQ(pack.bufs().size(), 7);
-  EXPECT_EQ(pack.bufs()[0].len, strlen("HTTP/1.1"));
-  EXPECT_MEMEQ(pack.bufs()[0].base, "HTTP/1.1", pack.bufs()[0].len);
-  EXPECT_EQ(pack.bufs()[1].len, strlen(" "));
-  EXPECT_MEMEQ(pack.bufs()[1].base, " ", pack.bufs()[1].len);
-  EXPECT_EQ(pack.bufs()[2].len, strlen("200"));
-  EXPECT_MEMEQ(pack.bufs()[2].base, "200", pack.bufs()[2].len);
-  EXPECT_EQ(pack.bufs()[3].len, strlen(" "));
-  EXPECT_MEMEQ(pack.bufs()[3].base, " ", pack.bufs()[3].len);
-  EXPECT_EQ(pack.bufs()[4].len, strlen("OK"));
-  EXPECT_MEMEQ(pack.bufs()[4].base, "OK", pack.bufs()[4].len);
-  EXPECT_EQ(pack.bufs()[5].len, strlen("\r\n"));
-  EXPECT_MEMEQ(pack.bufs()[5].base, "\r\n", pack.bufs()[5].len);
-  EXPECT_EQ(pack.bufs()[6].len, strlen("\r\n"));
-  EXPECT_MEMEQ(pack.bufs()[6].base, "\r\n", pack.bufs()[6].len);
+  // 起始行和头部位于同一个 uv_buf_t 中。
+  auto expected = Head("HTTP/1.1 200 OK") + "Content-Length: 0\r\n\r\n";
+  ASSERT_EQ(pack.bufs().size(), 1);
+  EXPECT_EQ(pack.bufs()[0].len, expected.size());
+  EXPECT_MEMEQ(pack.bufs()[0].base, expected.data(), expected.size());
+}
+
+TEST(SendRespPackTest, Body) {
+  auto resp = Response::Default();
+  std::string hello = "hello";
+  resp->set_body(
+      std::make_shared<std::vector<char>>(hello.begin(), hello.end()));
+  resp->headers()["X-Custom"] = "1";
+
+  BufPool pool(1024, 1);
+  {
+    SendRespPack pack(resp, &pool);
+    EXPECT_EQ(pool.nused(), 1);
+    ASSERT_EQ(pack.bufs().size(), 2);
+    EXPECT_EQ(pack.bufs()[1].base, resp->body()->data());
+
+    auto data = Join(pack);
+    EXPECT_EQ(data.rfind("HTTP/1.1 200 OK\r\n", 0), 0);
+    EXPECT_NE(data.find("\r\nContent-Length: 5\r\n"), std::string::npos);
+    EXPECT_NE(data.find("\r\nX-Custom: 1\r\n"), std::string::npos);
+    EXPECT_NE(data.find("\r\nDate: "), std::string::npos);
+    EXPECT_NE(data.find("\r\nServer: Ayaka/"), std::string::npos);
+    EXPECT_EQ(data.substr(data.size() - 9), "\r\n\r\nhello");
+  }
+  // 头部缓冲区随 SendRespPack 一起归还。
+  EXPECT_EQ(pool.nused(), 0);
+
+  // 头部放不进 pool 的缓冲区时单独分配内存。
+  resp->headers()["X-Large"] = std::string(2048, 'x');
+  SendRespPack pack(resp, &pool);
+  EXPECT_EQ(pool.nused(), 0);
+  EXPECT_EQ(pack.bufs().size(), 2);
+  EXPECT_NE(Join(pack).find(std::string(2048, 'x')), std::string::npos);
+}
+
+TEST(SendRespPackTest, MappedBody) {
+  auto file_path =
+      std::filesystem::path(testing::TempDir()) / "ayaka_send_pack.txt";
+  {
+    std::ofstream out(file_path);
+    out << "hello";
+  }
+  auto file = ayaka::File::Open(file_path.string());
+  ASSERT_NE(file, nullptr);
+  auto mapped = ayaka::MappedFile::Map(*file);
+  ASSERT_NE(mapped, nullptr);
+
+  auto resp = MakeResponse(HttpStatus::Ok());
+  resp->set_mapped_body(mapped);
+  EXPECT_EQ(resp->BodySize(), 5);
+  SendRespPack pack(resp);
+  // 响应体直接指向映射的内存。
+  ASSERT_EQ(pack.bufs().size(), 2);
+  EXPECT_EQ(pack.bufs()[1].base, mapped->data());
+  EXPECT_EQ(Join(pack),
+            Head("HTTP/1.1 200 OK") + "Content-Length: 5\r\n\r\nhello");
+
+  resp->Reset();
+  EXPECT_EQ(resp->mapped_body(), nullptr);
+
+  std::filesystem::remove(file_path);
+}
+
+TEST(SendRespPackTest, ContentLength) {
+  auto resp = MakeResponse(HttpStatus::Ok());
+  resp->headers()[ayaka::Header::kContentLength] = "10";
+  EXPECT_EQ(Join(SendRespPack(resp)),
+            "HTTP/1.1 200 OK\r\nContent-Length: 10\r\nDate: " +
+                std::string(kDate) + "\r\nServer: " +
+                std::string(Response::ServerName()) + "\r\n\r\n");
+
+  resp = MakeResponse(HttpStatus("304", "Not Modified"));
+  EXPECT_EQ(Join(SendRespPack(resp)),
+            Head("HTTP/1.1 304 Not Modified") + "\r\n");
+}
+
+TEST(SendRespPackTest, MultipleResps) {
+  auto resp1 = MakeResponse(HttpStatus::Ok());
+  auto resp2 = MakeResponse(HttpStatus::NotFound());
+
+  SendRespPack pack({resp1, resp2});
+  EXPECT_EQ(pack.resp(), resp1);
+  EXPECT_EQ(pack.resps().size(), 2);
+  // 没有响应体时相邻的头部合并为一个 uv_buf_t。
+  EXPECT_EQ(pack.bufs().size(), 1);
+  EXPECT_EQ(Join(pack), Head("HTTP/1.1 200 OK") +
+                            "Content-Length: 0\r\n\r\n" +
+                            Head("HTTP/1.1 404 Not Found") +
+                            "Content-Length: 0\r\n\r\n");
 }
 
 int main(int argc, char *argv[]) {
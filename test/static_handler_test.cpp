@@ -15,7 +15,13 @@
  * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <zlib.h>
+
+#include <compress_cache.hpp>
+#include <content_cache.hpp>
+#include <fstream>
 #include <static_handler.hpp>
+#include <thread>
 
 #include "test.hpp"
 
@@ -27,6 +33,53 @@ using ayaka::StaticPathHandler;
 using ayaka::Url;
 using std::filesystem::path;
 
+namespace {
+
+/**
+ * 调用 HandleAsync 并运行事件循环直到处理完成。
+ */
+std::exception_ptr HandleAsync(ayaka::HttpHandler& handler,
+                               const std::shared_ptr<Request>& req,
+                               const std::shared_ptr<Response>& resp) {
+  auto loop = std::make_shared<ayaka::Loop>();
+  auto done = false;
+  std::exception_ptr result;
+  handler.HandleAsync(req, ayaka::HttpCompletion(
+                               loop, req, resp, [&](std::exception_ptr except) {
+                                 done = true;
+                                 result = std::move(except);
+                               }));
+  while (!done) {
+    loop->Once();
+  }
+  return result;
+}
+
+/**
+ * 解压 gzip 格式的 data，失败时返回空字符串。
+ */
+std::string Gunzip(const std::vector<char>& data) {
+  z_stream stream{};
+  if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+    return "";
+  }
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = static_cast<uInt>(data.size());
+  std::string result;
+  char buf[4096];
+  int ret;
+  do {
+    stream.next_out = reinterpret_cast<Bytef*>(buf);
+    stream.avail_out = sizeof(buf);
+    ret = inflate(&stream, Z_NO_FLUSH);
+    result.append(buf, sizeof(buf) - stream.avail_out);
+  } while (ret == Z_OK);
+  inflateEnd(&stream);
+  return ret == Z_STREAM_END ? result : "";
+}
+
+}  // namespace
+
 TEST(StaticPathHandlerTest, Example) {
   auto mime = std::make_shared<Mime>();
   mime->ext_map()["html"] = "text/html";
@@ -44,8 +97,127 @@ TEST(StaticPathHandlerTest, Example) {
   EXPECT_EQ(resp->version(), "HTTP/1.1");
   EXPECT_EQ(resp->status().code(), "200");
   EXPECT_EQ(resp->status().msg(), "OK");
-  EXPECT_EQ(resp->headers().size(), 4);
+  EXPECT_EQ(resp->headers().size(), 5);
+  EXPECT_EQ(resp->headers()[ayaka::Header::kAcceptRanges], "bytes");
   EXPECT_EQ(resp->headers()["Content-Type"], "text/html");
+  EXPECT_NE(resp->headers().Find(ayaka::Header::kETag), nullptr);
+  EXPECT_NE(resp->headers().Find(ayaka::Header::kLastModified), nullptr);
+  // 小文件的内容被读入内存。
+  EXPECT_TRUE(resp->file_body().Empty());
+  EXPECT_EQ(resp->BodySize(), std::filesystem::file_size(html_path));
+}
+
+TEST(StaticPathHandlerTest, LargeFile) {
+  auto file_path = path(testing::TempDir()) / "ayaka_static_large.bin";
+  {
+    std::ofstream out(file_path, std::ios::binary);
+    out << std::string(ayaka::ContentCache::kDefaultMaxFileSize + 1, 'a');
+  }
+
+  auto mime = std::make_shared<Mime>();
+  auto handler = StaticPathHandler(file_path.string(), mime);
+  auto req = std::make_shared<Request>();
+  req->set_method(ayaka::http_method::kGet);
+  req->set_url(Url("/large.bin"));
+  req->set_version("HTTP/1.1");
+
+  auto resp = Response::Default();
+  handler.Handle(req, resp);
+  // 大文件使用 sendfile 发送。
+  EXPECT_EQ(resp->body(), nullptr);
+  EXPECT_EQ(resp->file_body().offset(), 0);
+  EXPECT_EQ(resp->file_body().length(),
+            ayaka::ContentCache::kDefaultMaxFileSize + 1);
+
+  std::filesystem::remove(file_path);
+}
+
+TEST(StaticPathHandlerTest, Mmap) {
+  auto file_path = path(testing::TempDir()) / "ayaka_static_mmap.bin";
+  auto size = ayaka::ContentCache::kDefaultMaxFileSize + 1;
+  {
+    std::ofstream out(file_path, std::ios::binary);
+    out << std::string(size, 'a');
+  }
+
+  auto mime = std::make_shared<Mime>();
+  auto handler = StaticPathHandler(file_path.string(), mime);
+  auto req = std::make_shared<Request>();
+  req->set_method(ayaka::http_method::kGet);
+  req->set_url(Url("/mmap.bin"));
+  req->set_version("HTTP/1.1");
+
+  // 线程局部的 FileCache 在第一次使用时按照当时的默认参数创建。
+  ayaka::FileCache::SetLocalDefault(ayaka::FileCache::kDefaultCapacity,
+                                    ayaka::FileCache::kDefaultValid, size);
+  std::thread([&]() {
+    auto resp = Response::Default();
+    handler.Handle(req, resp);
+    ASSERT_NE(resp->mapped_body(), nullptr);
+    EXPECT_TRUE(resp->file_body().Empty());
+    EXPECT_EQ(resp->BodySize(), size);
+    EXPECT_EQ(resp->mapped_body()->data()[size - 1], 'a');
+
+    // 之后的响应共享缓存项持有的同一个映射。
+    auto mapped = resp->mapped_body();
+    resp = Response::Default();
+    EXPECT_EQ(HandleAsync(handler, req, resp), nullptr);
+    EXPECT_EQ(resp->mapped_body(), mapped);
+
+    // 范围仍然使用 sendfile 发送。
+    req->headers()[ayaka::Header::kRange] = "bytes=0-0";
+    resp = Response::Default();
+    handler.Handle(req, resp);
+    EXPECT_EQ(resp->mapped_body(), nullptr);
+    EXPECT_EQ(resp->file_body().length(), 1);
+  }).join();
+  ayaka::FileCache::SetLocalDefault(ayaka::FileCache::kDefaultCapacity,
+                                    ayaka::FileCache::kDefaultValid,
+                                    ayaka::FileCache::kDefaultMmapMaxFile);
+
+  std::filesystem::remove(file_path);
+}
+
+TEST(StaticPathHandlerTest, NotFound) {
+  auto mime = std::make_shared<Mime>();
+  auto handler = StaticPathHandler("/path/does/not/exist.html", mime);
+  auto req = std::make_shared<Request>();
+  req->set_method(ayaka::http_method::kGet);
+  req->set_url(Url("/index.html"));
+  req->set_version("HTTP/1.1");
+
+  auto resp = Response::Default();
+  handler.Handle(req, resp);
+  EXPECT_EQ(resp->status().code(), "404");
+}
+
+TEST(StaticDirHandlerTest, Cache) {
+  auto mime = std::make_shared<Mime>();
+  auto root = path(__FILE__).parent_path().parent_path();
+  auto handler = StaticDirHandler("/", root.string(), mime);
+  auto req = std::make_shared<Request>();
+  req->set_method(ayaka::http_method::kGet);
+  req->set_url(Url("/res/html/"));
+  req->set_version("HTTP/1.1");
+
+  auto& file_cache = ayaka::FileCache::Local();
+  file_cache.Clear();
+  auto& content_cache = ayaka::ContentCache::Local();
+  content_cache.Clear();
+  auto hits = file_cache.nhits();
+  auto content_hits = content_cache.nhits();
+
+  auto resp1 = Response::Default();
+  handler.Handle(req, resp1);
+  auto resp2 = Response::Default();
+  handler.Handle(req, resp2);
+  // 第二次请求使用缓存中已经打开的文件，并且与第一次请求共享响应体。
+  EXPECT_EQ(file_cache.nhits(), hits + 1);
+  EXPECT_EQ(content_cache.nhits(), content_hits + 1);
+  EXPECT_NE(resp1->body(), nullptr);
+  EXPECT_EQ(resp1->body(), resp2->body());
+  EXPECT_EQ(resp2->BodySize(),
+            std::filesystem::file_size(root / "res/html/index.html"));
 }
 
 TEST(StaticDirHandlerTest, Example) {
@@ -64,8 +236,318 @@ TEST(StaticDirHandlerTest, Example) {
   EXPECT_EQ(resp->version(), "HTTP/1.1");
   EXPECT_EQ(resp->status().code(), "200");
   EXPECT_EQ(resp->status().msg(), "OK");
-  EXPECT_EQ(resp->headers().size(), 4);
+  EXPECT_EQ(resp->headers().size(), 5);
+  EXPECT_EQ(resp->headers()[ayaka::Header::kAcceptRanges], "bytes");
+  EXPECT_EQ(resp->headers()["Content-Type"], "text/html");
+  EXPECT_NE(resp->headers().Find(ayaka::Header::kETag), nullptr);
+  EXPECT_NE(resp->headers().Find(ayaka::Header::kLastModified), nullptr);
+  EXPECT_EQ(resp->BodySize(),
+            std::filesystem::file_size(root / "res/html/index.html"));
+}
+
+TEST(StaticDirHandlerTest, ConditionalGet) {
+  auto mime = std::make_shared<Mime>();
+  auto root = path(__FILE__).parent_path().parent_path();
+  auto handler = StaticDirHandler("/", root.string(), mime);
+  auto req = std::make_shared<Request>();
+  req->set_method(ayaka::http_method::kGet);
+  req->set_url(Url("/res/html/index.html"));
+  req->set_version("HTTP/1.1");
+
+  auto resp = Response::Default();
+  handler.Handle(req, resp);
+  auto etag = resp->headers()[ayaka::Header::kETag];
+  auto last_modified = resp->headers()[ayaka::Header::kLastModified];
+
+  // ETag 匹配时返回没有响应体的 304，并且仍然带有验证器。
+  req->headers()[ayaka::Header::kIfNoneMatch] = etag;
+  resp = Response::Default();
+  handler.Handle(req, resp);
+  EXPECT_EQ(resp->status().code(), "304");
+  EXPECT_EQ(resp->BodySize(), 0);
+  EXPECT_EQ(resp->headers()[ayaka::Header::kETag], etag);
+  EXPECT_EQ(resp->headers().Find(ayaka::Header::kContentType), nullptr);
+
+  // If-None-Match 不匹配时忽略 If-Modified-Since。
+  req->headers()[ayaka::Header::kIfNoneMatch] = "\"other\"";
+  req->headers()[ayaka::Header::kIfModifiedSince] = last_modified;
+  resp = Response::Default();
+  handler.Handle(req, resp);
+  EXPECT_EQ(resp->status().code(), "200");
+
+  req->headers().Erase(ayaka::Header::kIfNoneMatch);
+  resp = Response::Default();
+  handler.Handle(req, resp);
+  EXPECT_EQ(resp->status().code(), "304");
+}
+
+TEST(StaticPathHandlerTest, Range) {
+  auto mime = std::make_shared<Mime>();
+  mime->ext_map()["html"] = "text/html";
+  auto html_path =
+      path(__FILE__).parent_path().parent_path() / "res/html/index.html";
+  auto size = std::filesystem::file_size(html_path);
+  auto handler = StaticPathHandler(html_path, mime);
+  auto req = std::make_shared<Request>();
+  req->set_method(ayaka::http_method::kGet);
+  req->set_url(Url("/index.html"));
+  req->set_version("HTTP/1.1");
+
+  // 单个范围直接使用 sendfile 发送文件的一部分。
+  req->headers()[ayaka::Header::kRange] = "bytes=10-19";
+  auto resp = Response::Default();
+  handler.Handle(req, resp);
+  EXPECT_EQ(resp->status().code(), "206");
+  EXPECT_EQ(resp->headers()[ayaka::Header::kContentType], "text/html");
+  EXPECT_EQ(resp->headers()[ayaka::Header::kContentRange],
+            "bytes 10-19/" + std::to_string(size));
+  EXPECT_EQ(resp->file_body().offset(), 10);
+  EXPECT_EQ(resp->file_body().length(), 10);
+
+  // 多个范围使用 multipart/byteranges。
+  req->headers()[ayaka::Header::kRange] = "bytes=0-4,-5";
+  resp = Response::Default();
+  handler.Handle(req, resp);
+  EXPECT_EQ(resp->status().code(), "206");
+  EXPECT_EQ(resp->headers()[ayaka::Header::kContentType].rfind(
+                "multipart/byteranges; boundary=", 0),
+            0);
+  ASSERT_EQ(resp->parts().size(), 3);
+  EXPECT_EQ(resp->parts()[0].data.rfind("--", 0), 0);
+  EXPECT_NE(resp->parts()[1].data.find("Content-Range: bytes " +
+                                       std::to_string(size - 5) + "-" +
+                                       std::to_string(size - 1) + "/"),
+            std::string::npos);
+  EXPECT_EQ(resp->parts()[1].file.offset(), size - 5);
+  EXPECT_TRUE(resp->parts()[2].file.Empty());
+  EXPECT_TRUE(resp->HasFileBody());
+
+  // 请求头部只引用 range，range 需要比 req 存活得更久。
+  auto range = "bytes=" + std::to_string(size) + "-";
+  req->headers()[ayaka::Header::kRange] = range;
+  resp = Response::Default();
+  handler.Handle(req, resp);
+  EXPECT_EQ(resp->status().code(), "416");
+  EXPECT_EQ(resp->headers()[ayaka::Header::kContentRange],
+            "bytes */" + std::to_string(size));
+  EXPECT_EQ(resp->BodySize(), 0);
+
+  // If-Range 不匹配时返回完整的内容。
+  req->headers()[ayaka::Header::kRange] = "bytes=0-4";
+  req->headers()[ayaka::Header::kIfRange] = "\"other\"";
+  resp = Response::Default();
+  handler.Handle(req, resp);
+  EXPECT_EQ(resp->status().code(), "200");
+  EXPECT_EQ(resp->BodySize(), size);
+}
+
+TEST(StaticDirHandlerTest, Precompressed) {
+  auto dir = path(testing::TempDir()) / "ayaka_precompressed";
+  std::filesystem::create_directories(dir);
+  for (const auto* name : {"app.js", "app.js.gz", "app.js.br"}) {
+    std::ofstream out(dir / name);
+    out << name;
+  }
+
+  auto mime = std::make_shared<Mime>();
+  mime->ext_map()["js"] = "text/javascript";
+  auto handler = StaticDirHandler("/", dir.string(), mime);
+  auto req = std::make_shared<Request>();
+  req->set_method(ayaka::http_method::kGet);
+  req->set_url(Url("/app.js"));
+  req->set_version("HTTP/1.1");
+  ayaka::FileCache::Local().Clear();
+  ayaka::ContentCache::Local().Clear();
+
+  auto get = [&](std::string_view accept_encoding) {
+    req->headers()[ayaka::Header::kAcceptEncoding] = accept_encoding;
+    auto resp = Response::Default();
+    handler.Handle(req, resp);
+    EXPECT_EQ(resp->headers()[ayaka::Header::kContentType],
+              "text/javascript");
+    EXPECT_EQ(resp->headers()[ayaka::Header::kVary], "Accept-Encoding");
+    const auto& body = *resp->body();
+    return std::string(body.begin(), body.end());
+  };
+  EXPECT_EQ(get("gzip, br"), "app.js.br");
+  EXPECT_EQ(get("gzip"), "app.js.gz");
+  EXPECT_EQ(get("gzip;q=0, zstd"), "app.js");
+
+  auto resp = Response::Default();
+  req->headers()[ayaka::Header::kAcceptEncoding] = "br";
+  handler.Handle(req, resp);
+  EXPECT_EQ(resp->headers()[ayaka::Header::kContentEncoding], "br");
+  auto br_etag = resp->headers()[ayaka::Header::kETag];
+  req->headers()[ayaka::Header::kAcceptEncoding] = "identity";
+  resp = Response::Default();
+  handler.Handle(req, resp);
+  EXPECT_EQ(resp->headers().Find(ayaka::Header::kContentEncoding), nullptr);
+  EXPECT_NE(resp->headers()[ayaka::Header::kETag], br_etag);
+
+  // 变体与原文件一起缓存，之后的请求不再检查变体是否存在。
+  std::filesystem::remove(dir / "app.js.br");
+  EXPECT_EQ(get("br"), "app.js.br");
+  ayaka::FileCache::Local().Clear();
+  resp = Response::Default();
+  EXPECT_EQ(HandleAsync(handler, req, resp), nullptr);
+  EXPECT_EQ(get("br, gzip"), "app.js.gz");
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST(StaticDirHandlerTest, Compress) {
+  auto dir = path(testing::TempDir()) / "ayaka_compress";
+  std::filesystem::create_directories(dir);
+  std::string text;
+  for (int i = 0; i < 1000; ++i) {
+    text += "body { margin: " + std::to_string(i) + "px; }\n";
+  }
+  {
+    std::ofstream out(dir / "app.css", std::ios::binary);
+    out << text;
+  }
+
+  auto mime = std::make_shared<Mime>();
+  mime->ext_map()["css"] = "text/css";
+  auto handler = StaticDirHandler("/", dir.string(), mime);
+  auto req = std::make_shared<Request>();
+  req->set_method(ayaka::http_method::kGet);
+  req->set_url(Url("/app.css"));
+  req->set_version("HTTP/1.1");
+  req->headers()[ayaka::Header::kAcceptEncoding] = "gzip";
+  ayaka::FileCache::Local().Clear();
+  ayaka::CompressCache::Local().Clear();
+
+  auto resp = Response::Default();
+  handler.Handle(req, resp);
+  EXPECT_EQ(resp->status().code(), "200");
+  EXPECT_EQ(resp->headers()[ayaka::Header::kContentEncoding], "gzip");
+  EXPECT_EQ(resp->headers()[ayaka::Header::kVary], "Accept-Encoding");
+  EXPECT_EQ(Gunzip(*resp->body()), text);
+  auto gzip_etag = resp->headers()[ayaka::Header::kETag];
+  EXPECT_NE(gzip_etag.find("-gzip\""), std::string::npos);
+
+  // 每个文件只压缩一次，之后的请求共享缓存的结果。
+  auto body = resp->body();
+  resp = Response::Default();
+  EXPECT_EQ(HandleAsync(handler, req, resp), nullptr);
+  EXPECT_EQ(resp->body(), body);
+  EXPECT_EQ(ayaka::CompressCache::Local().nhits(), 1);
+
+  // 压缩后的表示使用自己的 ETag。
+  req->headers()[ayaka::Header::kIfNoneMatch] = gzip_etag;
+  resp = Response::Default();
+  handler.Handle(req, resp);
+  EXPECT_EQ(resp->status().code(), "304");
+  req->headers().Erase(ayaka::Header::kIfNoneMatch);
+
+  // 范围针对未压缩的内容。
+  req->headers()[ayaka::Header::kRange] = "bytes=0-3";
+  resp = Response::Default();
+  handler.Handle(req, resp);
+  EXPECT_EQ(resp->status().code(), "206");
+  EXPECT_EQ(resp->headers().Find(ayaka::Header::kContentEncoding), nullptr);
+  req->headers().Erase(ayaka::Header::kRange);
+
+  req->headers()[ayaka::Header::kAcceptEncoding] = "identity";
+  resp = Response::Default();
+  handler.Handle(req, resp);
+  EXPECT_EQ(resp->headers().Find(ayaka::Header::kContentEncoding), nullptr);
+  EXPECT_EQ(resp->headers()[ayaka::Header::kVary], "Accept-Encoding");
+  EXPECT_NE(resp->headers()[ayaka::Header::kETag], gzip_etag);
+  EXPECT_EQ(resp->BodySize(), text.size());
+
+  // 压缩结果不在缓存中时，在线程池中压缩。
+  req->headers()[ayaka::Header::kAcceptEncoding] = "gzip";
+  ayaka::CompressCache::Local().Clear();
+  resp = Response::Default();
+  EXPECT_EQ(HandleAsync(handler, req, resp), nullptr);
+  EXPECT_EQ(resp->headers()[ayaka::Header::kContentEncoding], "gzip");
+  EXPECT_EQ(Gunzip(*resp->body()), text);
+  EXPECT_EQ(ayaka::CompressCache::Local().Size(), 1);
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST(StaticPathHandlerTest, Async) {
+  auto mime = std::make_shared<Mime>();
+  mime->ext_map()["html"] = "text/html";
+  auto html_path =
+      path(__FILE__).parent_path().parent_path() / "res/html/index.html";
+  auto handler = StaticPathHandler(html_path, mime);
+  auto req = std::make_shared<Request>();
+  req->set_method(ayaka::http_method::kGet);
+  req->set_url(Url("/index.html"));
+  req->set_version("HTTP/1.1");
+
+  ayaka::FileCache::Local().Clear();
+  ayaka::ContentCache::Local().Clear();
+  auto resp = Response::Default();
+  EXPECT_EQ(HandleAsync(handler, req, resp), nullptr);
   EXPECT_EQ(resp->headers()["Content-Type"], "text/html");
+  EXPECT_EQ(resp->BodySize(), std::filesystem::file_size(html_path));
+
+  // 条件请求命中时不读取文件。请求头部只引用 etag，不能引用 resp。
+  auto etag = resp->headers()[ayaka::Header::kETag];
+  req->headers()[ayaka::Header::kIfNoneMatch] = etag;
+  resp = Response::Default();
+  EXPECT_EQ(HandleAsync(handler, req, resp), nullptr);
+  EXPECT_EQ(resp->status().code(), "304");
+  EXPECT_EQ(resp->BodySize(), 0);
+
+  // 其他方法同 HttpHandler。
+  req->set_method(ayaka::http_method::kPost);
+  resp = Response::Default();
+  EXPECT_EQ(HandleAsync(handler, req, resp), nullptr);
+  EXPECT_EQ(resp->status().code(), "405");
+}
+
+TEST(StaticPathHandlerTest, AsyncLargeFile) {
+  auto file_path = path(testing::TempDir()) / "ayaka_static_large_async.bin";
+  {
+    std::ofstream out(file_path, std::ios::binary);
+    out << std::string(ayaka::ContentCache::kDefaultMaxFileSize + 1, 'a');
+  }
+
+  auto mime = std::make_shared<Mime>();
+  auto handler = StaticPathHandler(file_path.string(), mime);
+  auto req = std::make_shared<Request>();
+  req->set_method(ayaka::http_method::kGet);
+  req->set_url(Url("/large.bin"));
+  req->set_version("HTTP/1.1");
+
+  auto resp = Response::Default();
+  EXPECT_EQ(HandleAsync(handler, req, resp), nullptr);
+  EXPECT_EQ(resp->body(), nullptr);
+  EXPECT_EQ(resp->file_body().length(),
+            ayaka::ContentCache::kDefaultMaxFileSize + 1);
+
+  std::filesystem::remove(file_path);
+}
+
+TEST(StaticDirHandlerTest, Async) {
+  auto mime = std::make_shared<Mime>();
+  mime->ext_map()["html"] = "text/html";
+  auto root = path(__FILE__).parent_path().parent_path();
+  auto handler = StaticDirHandler("/", root.string(), mime);
+  auto req = std::make_shared<Request>();
+  req->set_method(ayaka::http_method::kGet);
+  req->set_url(Url("/res/html/"));
+  req->set_version("HTTP/1.1");
+
+  ayaka::FileCache::Local().Clear();
+  ayaka::ContentCache::Local().Clear();
+  // 请求目录时返回目录中的 index.html。
+  auto resp = Response::Default();
+  EXPECT_EQ(HandleAsync(handler, req, resp), nullptr);
+  EXPECT_EQ(resp->headers()["Content-Type"], "text/html");
+  EXPECT_EQ(resp->BodySize(),
+            std::filesystem::file_size(root / "res/html/index.html"));
+
+  req->set_url(Url("/path/does/not/exist.html"));
+  resp = Response::Default();
+  EXPECT_EQ(HandleAsync(handler, req, resp), nullptr);
+  EXPECT_EQ(resp->status().code(), "404");
 }
 
 int main(int argc, char* argv[]) {
@@ -0,0 +1,110 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdexcept>
+#include <string>
+#include <task.hpp>
+
+#include "test.hpp"
+
+using ayaka::Spawn;
+using ayaka::Task;
+
+namespace {
+
+Task<int> Add(int lhs, int rhs) { co_return lhs + rhs; }
+
+Task<int> Sum(int n) {
+  int sum = 0;
+  for (int i = 1; i <= n; ++i) {
+    sum = co_await Add(sum, i);
+  }
+  co_return sum;
+}
+
+Task<std::string> Throw() {
+  throw std::runtime_error("error");
+  co_return "";
+}
+
+Task<void> Catch(bool &caught) {
+  try {
+    co_await Throw();
+  } catch (const std::runtime_error &) {
+    caught = true;
+  }
+}
+
+/**
+ * 手动恢复的挂起点。
+ */
+class Suspend {
+ public:
+  [[nodiscard]] bool await_ready() const noexcept { return false; }
+  void await_suspend(std::coroutine_handle<> handle) { handle_ = handle; }
+  void await_resume() const noexcept {}
+
+  void Resume() const { handle_.resume(); }
+
+ private:
+  std::coroutine_handle<> handle_;
+};
+
+Task<void> WaitFor(Suspend &suspend, int &step) {
+  step = 1;
+  co_await suspend;
+  step = 2;
+}
+
+}  // namespace
+
+TEST(TaskTest, Lazy) {
+  auto task = Add(1, 2);
+  EXPECT_FALSE(task.Done());
+  Task<void> empty;
+  EXPECT_TRUE(empty.Done());
+}
+
+TEST(TaskTest, Value) {
+  int result = 0;
+  Spawn([](int &result) -> Task<void> {
+    result = co_await Sum(100);
+  }(result));
+  EXPECT_EQ(result, 5050);
+}
+
+TEST(TaskTest, Exception) {
+  bool caught = false;
+  Spawn(Catch(caught));
+  EXPECT_TRUE(caught);
+}
+
+TEST(TaskTest, Spawn) {
+  Suspend suspend;
+  int step = 0;
+  Spawn(WaitFor(suspend, step));
+  // Spawn 在第一次挂起时返回。
+  EXPECT_EQ(step, 1);
+  suspend.Resume();
+  EXPECT_EQ(step, 2);
+}
+
+int main(int argc, char *argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  ayaka::InitLogger();
+  return RUN_ALL_TESTS();
+}
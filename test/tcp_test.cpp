@@ -17,7 +17,10 @@
 
 #include <sys/socket.h>
 
+#include <filesystem>
+#include <fstream>
 #include <tcp.hpp>
+#include <thread>
 #include <utility>
 
 #include "test.hpp"
@@ -136,6 +139,8 @@ TEST(TcpTest, Recv) {
   while (!(server->closed() && client->closed())) {
     loop->Once();
   }
+  // 接收缓冲区来自事件循环的缓冲区池，并且在回调后归还。
+  EXPECT_EQ(loop->buf_pool().nused(), 0);
 }
 
 TEST(TcpTest, Send) {
@@ -163,7 +168,7 @@ TEST(TcpTest, Send) {
   }
 
   auto resp = std::make_shared<Response>();
-  resp->set_status(std::move(HttpStatus::Ok()));
+  resp->set_status(HttpStatus::Ok());
   resp->set_version("HTTP/1.1");
   std::shared_ptr<SendPack> send_pack = std::make_shared<SendRespPack>(resp);
   client->Send(send_pack, {});
@@ -174,8 +179,10 @@ TEST(TcpTest, Send) {
 
   char buf[1024] = {};
   auto nread = read(client_fd, buf, 1024);
-  EXPECT_EQ(nread, strlen("HTTP/1.1 200 OK\r\n\r\n"));
-  EXPECT_MEMEQ(buf, "HTTP/1.1 200 OK\r\n\r\n", nread);
+  // SendRespPack 自动添加 Date、Server 和 Content-Length。
+  std::string data(buf, nread);
+  EXPECT_EQ(data.rfind("HTTP/1.1 200 OK\r\nDate: ", 0), 0);
+  EXPECT_EQ(data.substr(data.size() - 21), "Content-Length: 0\r\n\r\n");
 
   server->Close();
   client->Close();
@@ -184,6 +191,71 @@ TEST(TcpTest, Send) {
   }
 }
 
+TEST(TcpTest, SendFile) {
+  // 文件足够大，使 sendfile 返回 EAGAIN 并超过 kMaxSendFileBurst。
+  auto file_path =
+      std::filesystem::path(testing::TempDir()) / "ayaka_tcp_test.bin";
+  std::string content;
+  for (int i = 0; i < 4 * 1024 * 1024; ++i) {
+    content.push_back(static_cast<char>('a' + i % 26));
+  }
+  {
+    std::ofstream out(file_path, std::ios::binary);
+    out << content;
+  }
+  auto file = File::Open(file_path.string());
+  ASSERT_NE(file, nullptr);
+
+  auto loop = std::make_shared<Loop>();
+  auto server = std::make_shared<Tcp>(loop);
+  InetAddr addr(InetAddr::Family::kIpv4, "127.0.0.1", 8080);
+  server->Bind(addr);
+
+  std::shared_ptr<Tcp> client;
+  server->set_on_accept(
+      [&client](std::shared_ptr<Tcp> tcp) { client = std::move(tcp); });
+  server->Listen();
+
+  int client_fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr sock_addr{};
+  addr.ToSockAddr(&sock_addr);
+  auto status = connect(client_fd, &sock_addr, sizeof(sockaddr));
+  EXPECT_EQ(status, 0);
+  while (!client) {
+    loop->Once();
+  }
+
+  // 在另一个线程中读取，避免 socket 缓冲区被填满。
+  std::string received;
+  std::thread reader([&received, client_fd, size = content.size() - 10]() {
+    char buf[65536];
+    while (received.size() < size) {
+      auto nread = read(client_fd, buf, sizeof(buf));
+      if (nread <= 0) {
+        break;
+      }
+      received.append(buf, nread);
+    }
+  });
+
+  bool finish = false;
+  client->SendFile(FileBody(file, 10, content.size() - 10),
+                   [&finish]() { finish = true; });
+  while (!finish) {
+    loop->Once();
+  }
+  reader.join();
+  EXPECT_EQ(client->Pending(), 0);
+  EXPECT_EQ(received, content.substr(10));
+
+  server->Close();
+  client->Close();
+  while (!(server->closed() && client->closed())) {
+    loop->Once();
+  }
+  std::filesystem::remove(file_path);
+}
+
 TEST(TcpTest, Hup1) {
   auto loop = std::make_shared<Loop>();
   auto server = std::make_shared<Tcp>(loop);
@@ -293,7 +365,7 @@ TEST(TcpTest, Hup3) {
 
   // 尝试发送数据。
   auto resp = std::make_shared<Response>();
-  resp->set_status(std::move(HttpStatus::Ok()));
+  resp->set_status(HttpStatus::Ok());
   resp->set_version("HTTP/1.1");
   std::shared_ptr<SendPack> send_pack = std::make_shared<SendRespPack>(resp);
   client->Send(send_pack, {});
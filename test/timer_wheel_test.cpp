@@ -0,0 +1,141 @@
+/**
+ * Copyright (C) 2022 Vincil Lau.
+ *
+ * Ayaka is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ayaka is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Ayaka. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <functional>
+#include <loop.hpp>
+#include <memory>
+#include <timer_wheel.hpp>
+#include <vector>
+
+#include "test.hpp"
+
+using namespace ayaka;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+namespace {
+
+class TimerWheelTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    loop_ = std::make_shared<Loop>();
+    wheel_ = std::make_unique<TimerWheel>(loop_->uv_loop(), milliseconds(1));
+  }
+
+  // uv_timer_t 由 Loop 在析构时关闭，所以 wheel_ 要在 loop_ 之后析构。
+  std::unique_ptr<TimerWheel> wheel_;
+  std::shared_ptr<Loop> loop_;
+};
+
+}  // namespace
+
+TEST_F(TimerWheelTest, Order) {
+  auto &wheel = *wheel_;
+  WheelTimer timers[3];
+  std::vector<int> fired;
+  wheel.Start(timers[0], milliseconds(30), [&]() { fired.push_back(0); });
+  wheel.Start(timers[1], milliseconds(10), [&]() { fired.push_back(1); });
+  wheel.Start(timers[2], milliseconds(20), [&]() { fired.push_back(2); });
+  EXPECT_EQ(wheel.Size(), 3);
+  EXPECT_TRUE(timers[0].Active());
+
+  auto start = steady_clock::now();
+  // 所有定时器到期后 uv_timer_t 停止，事件循环退出。
+  loop_->Run();
+  // 定时器的精度为一个刻度。
+  EXPECT_GE(steady_clock::now() - start, milliseconds(30 - 2));
+  EXPECT_EQ(fired, std::vector<int>({1, 2, 0}));
+  EXPECT_EQ(wheel.Size(), 0);
+  EXPECT_FALSE(timers[0].Active());
+}
+
+TEST_F(TimerWheelTest, Cancel) {
+  auto &wheel = *wheel_;
+  WheelTimer cancelled;
+  WheelTimer restarted;
+  bool cancelled_fired = false;
+  int restarted_fired = 0;
+  wheel.Start(cancelled, milliseconds(10), [&]() { cancelled_fired = true; });
+  wheel.Start(restarted, milliseconds(10), [&]() { ++restarted_fired; });
+  // 重新启动会替换原来的超时时间和回调。
+  wheel.Start(restarted, milliseconds(20), [&]() { restarted_fired += 10; });
+  EXPECT_EQ(wheel.Size(), 2);
+  cancelled.Cancel();
+  EXPECT_FALSE(cancelled.Active());
+  EXPECT_EQ(wheel.Size(), 1);
+
+  {
+    // 析构时自动取消。
+    WheelTimer scoped;
+    wheel.Start(scoped, milliseconds(5), []() { FAIL(); });
+  }
+  EXPECT_EQ(wheel.Size(), 1);
+
+  loop_->Run();
+  EXPECT_FALSE(cancelled_fired);
+  EXPECT_EQ(restarted_fired, 10);
+}
+
+TEST_F(TimerWheelTest, Cascade) {
+  auto &wheel = *wheel_;
+  // 超过第 0 层一圈的定时器放在高层，之后被下放到第 0 层。
+  auto far = milliseconds(TimerWheel::kSlots * 3 + 7);
+  WheelTimer timer;
+  WheelTimer near;
+  bool near_fired = false;
+  steady_clock::duration elapsed{};
+  auto start = steady_clock::now();
+  wheel.Start(timer, far,
+              [&]() { elapsed = steady_clock::now() - start; });
+  wheel.Start(near, milliseconds(3), [&]() { near_fired = true; });
+  loop_->Run();
+  EXPECT_TRUE(near_fired);
+  EXPECT_GE(elapsed, far - milliseconds(2));
+  EXPECT_LT(elapsed, far + milliseconds(500));
+}
+
+TEST_F(TimerWheelTest, RestartInCallback) {
+  auto &wheel = *wheel_;
+  WheelTimer timer;
+  int nfired = 0;
+  std::function<void()> on_timeout = [&]() {
+    if (++nfired < 3) {
+      wheel.Start(timer, milliseconds(5), on_timeout);
+    }
+  };
+  wheel.Start(timer, milliseconds(5), on_timeout);
+  loop_->Run();
+  EXPECT_EQ(nfired, 3);
+  EXPECT_FALSE(timer.Active());
+}
+
+TEST_F(TimerWheelTest, LoopTimerWheel) {
+  auto &wheel = loop_->timer_wheel();
+  EXPECT_EQ(wheel.tick(), TimerWheel::kDefaultTick);
+  WheelTimer timer;
+  bool fired = false;
+  wheel.Start(timer, milliseconds(1), [&]() { fired = true; });
+  loop_->Run();
+  EXPECT_TRUE(fired);
+}
+
+int main(int argc, char *argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  ayaka::InitLogger();
+  return RUN_ALL_TESTS();
+}